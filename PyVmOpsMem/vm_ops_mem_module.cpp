@@ -0,0 +1,348 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "vm_ops_mem.h"
+
+#include <vector>
+
+struct PyResult {
+    PyObject_HEAD
+    Result Value;
+};
+
+static PyTypeObject PyResultType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+/* Result: time/ops attributes, Output exposed through the buffer protocol */
+static PyObject *
+Result_time(PyResult *self, void *) {
+    return PyLong_FromLongLong(self->Value.Time);
+}
+
+static PyObject *
+Result_ops(PyResult *self, void *) {
+    return PyLong_FromUnsignedLongLong(self->Value.Ops);
+}
+
+static PyObject *
+Result_output(PyResult *self, void *) {
+    return PyMemoryView_FromObject((PyObject *) self);
+}
+
+static int
+Result_getbuffer(PyResult *self, Py_buffer *view, int flags) {
+    return PyBuffer_FillInfo(view, (PyObject *) self, self->Value.Output,
+                             sizeof(self->Value.Output), 1, flags);
+}
+
+static PyGetSetDef Result_getset[] = {
+    {"time", (getter) Result_time, nullptr, "Kernel time in ns", nullptr},
+    {"ops", (getter) Result_ops, nullptr, "Kernel ops (see kernel unit)", nullptr},
+    {"output", (getter) Result_output, nullptr, "Final accumulator bytes", nullptr},
+    {nullptr},
+};
+
+static PyBufferProcs Result_as_buffer = {(getbufferproc) Result_getbuffer, nullptr};
+
+/* Module functions */
+static PyObject *
+py_init(PyObject *, PyObject *) {
+    PyThreadState *state = PyEval_SaveThread();
+    init();
+    PyEval_RestoreThread(state);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+py_kernels(PyObject *, PyObject *) {
+    PyObject *list = PyList_New(0);
+    for (unsigned i = 0; i < kernel_count(); i++) {
+        const char *name = kernel_name(i);
+        PyObject *item = Py_BuildValue("(ssO)", name, kernel_unit(name),
+                                       kernel_support(name) ? Py_True : Py_False);
+        PyList_Append(list, item);
+        Py_DECREF(item);
+    }
+    return list;
+}
+
+static PyObject *
+py_run_kernel(PyObject *, PyObject *args, PyObject *kwds) {
+    static const char *keywords[] = {"name",   "steps", "bytes",  "flush",    "pattern",
+                                     "chains", "walk",  "stride", "prefetch", nullptr};
+    const char *name;
+    unsigned long long steps, bytes = 0;
+    int flush = 0, pattern = PATTERN_UNIFORM, chains = 0, walk = WALK_FORWARD, stride = 0,
+        prefetch = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "sK|Kpiiiii", (char **) keywords, &name, &steps,
+                                     &bytes, &flush, &pattern, &chains, &walk, &stride,
+                                     &prefetch)) {
+        return nullptr;
+    }
+    KernelParams params{steps, bytes, flush, pattern, chains, walk, stride, prefetch};
+
+    if (!kernel_support(name)) {
+        PyErr_Format(PyExc_RuntimeError, "Kernel `%s` not supported!", name);
+        return nullptr;
+    }
+
+    auto self = (PyResult *) PyResultType.tp_alloc(&PyResultType, 0);
+    if (self == nullptr) {
+        return nullptr;
+    }
+
+    PyThreadState *state = PyEval_SaveThread();
+    self->Value = run_kernel(name, &params);
+    PyEval_RestoreThread(state);
+
+    return (PyObject *) self;
+}
+
+static PyObject *
+py_run_kernels(PyObject *, PyObject *args) {
+    PyObject *specs;
+    if (!PyArg_ParseTuple(args, "O", &specs)) {
+        return nullptr;
+    }
+
+    PyObject *sequence = PySequence_Fast(specs, "jobs must be a sequence");
+    if (sequence == nullptr) {
+        return nullptr;
+    }
+
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    std::vector<KernelJob> jobs(count);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        KernelJob &job = jobs[i];
+        unsigned long long steps, bytes;
+        long long duration;
+        int flush = 0, pattern = PATTERN_UNIFORM, chains = 0, walk = WALK_FORWARD, stride = 0,
+            prefetch = 0, verify = 0, discard = 0;
+        /* (name, core_id, steps, bytes, flush, duration_ns[, pattern, chains, walk, stride,
+            prefetch, verify, discard]) */
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(sequence, i), "siKKpL|iiiiipp", &job.Name,
+                              &job.CoreId, &steps, &bytes, &flush, &duration, &pattern, &chains,
+                              &walk, &stride, &prefetch, &verify, &discard)) {
+            Py_DECREF(sequence);
+            return nullptr;
+        }
+        job.Steps = steps;
+        job.Bytes = bytes;
+        job.Flush = flush;
+        job.Pattern = pattern;
+        job.Chains = chains;
+        job.Walk = walk;
+        job.Stride = stride;
+        job.Prefetch = prefetch;
+        job.Duration = duration;
+        job.Verify = verify;
+        job.Discard = discard;
+    }
+
+    /* Names point into the job tuples, which the sequence keeps alive */
+    PyThreadState *state = PyEval_SaveThread();
+    int32_t status = run_kernels(jobs.data(), count);
+    PyEval_RestoreThread(state);
+
+    Py_DECREF(sequence);
+
+    if (status != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Failed to run kernels!");
+        return nullptr;
+    }
+
+    PyObject *list = PyList_New(count);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        PyList_SET_ITEM(list, i,
+                        Py_BuildValue("(LKKKKLKKLLK)", (long long) jobs[i].Time,
+                                      (unsigned long long) jobs[i].Ops,
+                                      (unsigned long long) jobs[i].Iterations,
+                                      (unsigned long long) jobs[i].Steps,
+                                      (unsigned long long) jobs[i].Cycles,
+                                      (long long) jobs[i].Elapsed,
+                                      (unsigned long long) jobs[i].Preempted,
+                                      (unsigned long long) jobs[i].Discarded,
+                                      (long long) jobs[i].DiscardedTime,
+                                      (long long) jobs[i].LostTime,
+                                      (unsigned long long) jobs[i].Mismatches));
+    }
+    return list;
+}
+
+static PyObject *
+py_calibrate_steps(PyObject *, PyObject *args, PyObject *kwds) {
+    static const char *keywords[] = {"name",   "bytes", "flush",  "pattern",  "chains",
+                                     "walk",   "stride", "prefetch", nullptr};
+    const char *name;
+    unsigned long long bytes = 0;
+    int flush = 0, pattern = PATTERN_UNIFORM, chains = 0, walk = WALK_FORWARD, stride = 0,
+        prefetch = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|Kpiiiii", (char **) keywords, &name, &bytes,
+                                     &flush, &pattern, &chains, &walk, &stride, &prefetch)) {
+        return nullptr;
+    }
+    KernelParams params{0, bytes, flush, pattern, chains, walk, stride, prefetch};
+
+    PyThreadState *state = PyEval_SaveThread();
+    uint64_t steps = calibrate_steps(name, &params);
+    PyEval_RestoreThread(state);
+
+    if (steps == 0) {
+        PyErr_Format(PyExc_RuntimeError, "Kernel `%s` not supported!", name);
+        return nullptr;
+    }
+    return PyLong_FromUnsignedLongLong(steps);
+}
+
+static PyObject *
+py_kernel_inst_time(PyObject *, PyObject *args) {
+    const char *name;
+    if (!PyArg_ParseTuple(args, "s", &name)) {
+        return nullptr;
+    }
+
+    PyThreadState *state = PyEval_SaveThread();
+    double time = kernel_inst_time(name);
+    PyEval_RestoreThread(state);
+
+    return PyFloat_FromDouble(time);
+}
+
+static PyObject *
+py_set_sample_time(PyObject *, PyObject *args) {
+    long long time;
+    if (!PyArg_ParseTuple(args, "L", &time)) {
+        return nullptr;
+    }
+    set_sample_time(time);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+py_set_jit_mix(PyObject *, PyObject *args, PyObject *kwds) {
+    static const char *keywords[] = {"mix", "unroll", "accumulators", nullptr};
+    const char *mix;
+    unsigned int unroll = DEFAULT_JIT_UNROLL;
+    unsigned int accumulators = DEFAULT_JIT_ACCUMULATORS;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|II", (char **) keywords, &mix, &unroll,
+                                     &accumulators)) {
+        return nullptr;
+    }
+    return PyLong_FromLong(set_jit_mix(mix, unroll, accumulators));
+}
+
+static PyObject *
+py_jit_instructions(PyObject *, PyObject *) {
+    return PyUnicode_FromString(jit_instructions());
+}
+
+static PyObject *
+py_verify_kernel(PyObject *, PyObject *args) {
+    const char *name;
+    unsigned long long steps = 0;
+    if (!PyArg_ParseTuple(args, "s|K", &name, &steps)) {
+        return nullptr;
+    }
+
+    PyThreadState *state = PyEval_SaveThread();
+    int32_t status = verify_kernel(name, steps);
+    PyEval_RestoreThread(state);
+
+    return PyLong_FromLong(status);
+}
+
+static PyObject *
+py_verify_result(PyObject *, PyObject *args) {
+    const char *name;
+    unsigned long long steps;
+    PyResult *result;
+    if (!PyArg_ParseTuple(args, "sKO!", &name, &steps, &PyResultType, &result)) {
+        return nullptr;
+    }
+    return PyLong_FromLong(verify_result(name, steps, &result->Value));
+}
+
+static PyObject *
+py_set_input_seed(PyObject *, PyObject *args) {
+    unsigned long long seed;
+    if (!PyArg_ParseTuple(args, "K", &seed)) {
+        return nullptr;
+    }
+    set_input_seed(seed);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+py_cpu_time(PyObject *, PyObject *) {
+    CpuResult r = cpu_time();
+    return Py_BuildValue("(LK)", (long long) r.Time, (unsigned long long) r.Cycles);
+}
+
+static PyObject *
+py_set_thread_affinity(PyObject *, PyObject *args) {
+    int coreId;
+    if (!PyArg_ParseTuple(args, "i", &coreId)) {
+        return nullptr;
+    }
+    set_thread_affinity(coreId);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+py_set_thread_priority(PyObject *, PyObject *) {
+    set_thread_priority();
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef methods[] = {
+    {"init", py_init, METH_NOARGS, "Probe topology and register kernels"},
+    {"kernels", py_kernels, METH_NOARGS, "List of (name, unit, supported)"},
+    {"run_kernel", (PyCFunction) py_run_kernel, METH_VARARGS | METH_KEYWORDS,
+     "Run one kernel call, returns Result"},
+    {"run_kernels", py_run_kernels, METH_VARARGS,
+     "Run (name, core_id, steps, bytes, flush, duration_ns[, pattern, chains, walk, stride, "
+     "prefetch, verify, discard]) jobs on pinned threads"},
+    {"calibrate_steps", (PyCFunction) py_calibrate_steps, METH_VARARGS | METH_KEYWORDS,
+     "Steps for one kernel call of the sample time"},
+    {"set_sample_time", py_set_sample_time, METH_VARARGS, "Target sample time in ns"},
+    {"kernel_inst_time", py_kernel_inst_time, METH_VARARGS, "Best ns per instruction"},
+    {"set_jit_mix", (PyCFunction) py_set_jit_mix, METH_VARARGS | METH_KEYWORDS,
+     "Generate the jit kernel, returns a JIT_* status"},
+    {"jit_instructions", py_jit_instructions, METH_NOARGS, "Comma separated jit mix entries"},
+    {"verify_kernel", py_verify_kernel, METH_VARARGS, "Run and verify a kernel"},
+    {"verify_result", py_verify_result, METH_VARARGS, "Verify a Result for a step count"},
+    {"set_input_seed", py_set_input_seed, METH_VARARGS, "Seed the kernel inputs"},
+    {"cpu_time", py_cpu_time, METH_NOARGS, "(time_ns, cycles)"},
+    {"set_thread_affinity", py_set_thread_affinity, METH_VARARGS, "Pin calling thread"},
+    {"set_thread_priority", py_set_thread_priority, METH_NOARGS, "Raise calling thread priority"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyModuleDef module = {
+    PyModuleDef_HEAD_INIT, "_vm_ops_mem", "Native VmOpsMem bindings", -1, methods,
+};
+
+PyMODINIT_FUNC
+PyInit__vm_ops_mem() {
+    PyResultType.tp_name = "_vm_ops_mem.Result";
+    PyResultType.tp_basicsize = sizeof(PyResult);
+    PyResultType.tp_as_buffer = &Result_as_buffer;
+    PyResultType.tp_flags = Py_TPFLAGS_DEFAULT;
+    PyResultType.tp_doc = "Kernel result, Output exposed through the buffer protocol";
+    PyResultType.tp_getset = Result_getset;
+    PyResultType.tp_new = PyType_GenericNew;
+
+    if (PyType_Ready(&PyResultType) < 0) {
+        return nullptr;
+    }
+
+    PyObject *m = PyModule_Create(&module);
+    if (m == nullptr) {
+        return nullptr;
+    }
+
+    Py_INCREF(&PyResultType);
+    PyModule_AddObject(m, "Result", (PyObject *) &PyResultType);
+
+    return m;
+}
@@ -0,0 +1,402 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "vmopsmem_export.h"
+
+/* Clocks cpu_time may read, REALTIME steps with the wall clock and the coarse ones are too slow */
+static const clockid_t TIME_SOURCES[] = {CLOCK_MONOTONIC, CLOCK_MONOTONIC_RAW, CLOCK_BOOTTIME};
+
+#define TIME_SOURCE_RESOLUTION 1000 /* ns, coarser clocks are not trusted */
+#define TIME_SOURCE_READS      1024
+#define TIME_SOURCE_BATCHES    16
+
+/* Spins before a ping-pong side yields, lets both sides share a single CPU */
+#define SKEW_SPINS (1u << 16)
+
+/* Tries of a paired clock and counter read, the tightest one is kept */
+#define DRIFT_PAIR_TRIES 8
+
+/* Checks of the counter as a time source, once per topology cache fingerprint */
+#define COUNTER_SKEW_TIME      500000 /* per pair of neighbouring CPUs */
+#define COUNTER_DRIFT_TIME     20000000
+#define COUNTER_DRIFT_INTERVAL 2000000
+#define COUNTER_MAX_SPREAD     1e-3 /* of the interval rates, a scaled counter varies far more */
+
+static clockid_t time_source = CLOCK_MONOTONIC;
+static double counter_nanos = 0; /* per tick, once the counter is the time source */
+static uint64_t counter_origin = 0;
+
+static int64_t
+ClockNanos(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Counter ticks per read of the clock, 0 when it went backwards or is too coarse */
+static uint64_t
+ClockReadTicks(clockid_t clock) {
+    timespec res;
+    if (clock_getres(clock, &res) != 0 || res.tv_sec != 0 ||
+        res.tv_nsec > TIME_SOURCE_RESOLUTION) {
+        return 0;
+    }
+
+    uint64_t best = UINT64_MAX;
+    for (unsigned batch = 0; batch < TIME_SOURCE_BATCHES; batch++) {
+        int64_t prev = ClockNanos(clock);
+        uint64_t start = SerializedTicks();
+        for (unsigned i = 0; i < TIME_SOURCE_READS; i++) {
+            int64_t now = ClockNanos(clock);
+            if (now < prev) {
+                return 0;
+            }
+            prev = now;
+        }
+        best = std::min(best, SerializedTicks() - start);
+    }
+    return std::max<uint64_t>(best / TIME_SOURCE_READS, 1);
+}
+
+template <typename Call>
+static Result
+ClockKernel(uint64_t steps, Call call) {
+    int64_t value = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t k = 0; k < steps; k++) {
+        value += call();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps /* clock reads */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &value, sizeof(value));
+    return r;
+}
+
+/* ns per tick when every CPU reads the same counter and its rate holds, 0 otherwise. The drift
+ * slope needs seconds, over the short check only the spread of the interval rates is used */
+static double
+CounterNanos() {
+    /* Every CPU against the next, in two rounds of disjoint pairs that each run at once */
+    for (size_t parity = 1; parity <= 2; parity++) {
+        std::vector<SkewResult> results(processors.size());
+        std::vector<std::thread> threads;
+        for (size_t i = parity; i < processors.size(); i += 2) {
+            threads.emplace_back([&, i]() {
+                results[i] = counter_skew(processors[i - 1].Index, processors[i].Index,
+                                          COUNTER_SKEW_TIME);
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+
+        for (size_t i = parity; i < processors.size(); i += 2) {
+            const SkewResult &r = results[i];
+            if (r.Rounds == 0 || r.MinOffset > 0 || r.MaxOffset < 0 || r.Backwards != 0) {
+                return 0;
+            }
+        }
+    }
+
+    DriftResult drift = counter_drift(COUNTER_DRIFT_TIME, COUNTER_DRIFT_INTERVAL);
+    if (drift.Intervals == 0 || drift.Frequency <= 0 ||
+        (drift.MaxFrequency - drift.MinFrequency) / drift.Frequency > COUNTER_MAX_SPREAD) {
+        return 0;
+    }
+    return 1e9 / drift.Frequency;
+}
+
+/* The counter when it passes the skew and drift checks, every clock reads it or something
+ * slower. Otherwise the cheapest clock that is fine grained and never went backwards */
+void
+SelectTimeSource() {
+    time_source = CLOCK_MONOTONIC;
+    counter_nanos = 0;
+
+    uint64_t best = UINT64_MAX;
+    for (clockid_t clock : TIME_SOURCES) {
+        uint64_t ticks = ClockReadTicks(clock);
+        if (ticks != 0 && ticks < best) {
+            best = ticks;
+            time_source = clock;
+        }
+    }
+
+    /* The verdict holds as long as the topology, 0 caches a rejected counter */
+    double nanos = 0;
+    std::string path = CachePath("counter");
+    FILE *file = path.empty() ? nullptr : fopen(path.c_str(), "r");
+    bool cached = file != nullptr && fscanf(file, "%lf", &nanos) == 1;
+    if (file != nullptr) {
+        fclose(file);
+    }
+    if (!cached) {
+        nanos = CounterNanos();
+        if (!path.empty()) {
+            char line[64];
+            snprintf(line, sizeof(line), "%.17g\n", nanos);
+            SaveCache(path, line);
+        }
+    }
+
+    /* With a counter based clocksource the drift is checked against the counter itself, the
+     * kernel's clocksource watchdog vetted it against an independent clock instead */
+    if (nanos > 0) {
+        counter_nanos = nanos;
+        counter_origin = SerializedTicks();
+        time_source = TIME_SOURCE_COUNTER;
+    }
+}
+
+int64_t
+SourceTime() {
+    if (time_source == TIME_SOURCE_COUNTER) {
+        return (int64_t) ((SerializedTicks() - counter_origin) * counter_nanos);
+    }
+    return ClockNanos(time_source);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+clock_support() {
+    return 1;
+}
+
+/* Through libc, the vDSO unless the clocksource cannot be read from user space */
+VMOPSMEM_EXPORT Result
+clock_realtime(uint64_t steps) {
+    return ClockKernel(steps, []() { return ClockNanos(CLOCK_REALTIME); });
+}
+
+VMOPSMEM_EXPORT Result
+clock_monotonic(uint64_t steps) {
+    return ClockKernel(steps, []() { return ClockNanos(CLOCK_MONOTONIC); });
+}
+
+VMOPSMEM_EXPORT Result
+clock_monotonic_raw(uint64_t steps) {
+    return ClockKernel(steps, []() { return ClockNanos(CLOCK_MONOTONIC_RAW); });
+}
+
+VMOPSMEM_EXPORT Result
+clock_boottime(uint64_t steps) {
+    return ClockKernel(steps, []() { return ClockNanos(CLOCK_BOOTTIME); });
+}
+
+/* The last tick, no clocksource read at all */
+VMOPSMEM_EXPORT Result
+clock_monotonic_coarse(uint64_t steps) {
+    return ClockKernel(steps, []() { return ClockNanos(CLOCK_MONOTONIC_COARSE); });
+}
+
+/* Always the syscall, what the vDSO falls back to on hpet, acpi_pm or an unstable kvm-clock */
+VMOPSMEM_EXPORT Result
+clock_syscall(uint64_t steps) {
+    return ClockKernel(steps, []() {
+        timespec ts;
+        syscall(SYS_clock_gettime, CLOCK_MONOTONIC, &ts);
+        return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+    });
+}
+
+VMOPSMEM_EXPORT const char *
+clock_source() {
+    static char name[64] = {};
+    FILE *file = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    if (file == nullptr) {
+        return "";
+    }
+    if (fgets(name, sizeof(name), file) == nullptr) {
+        name[0] = '\0';
+    }
+    fclose(file);
+    name[std::strcspn(name, "\n")] = '\0';
+    return name;
+}
+
+VMOPSMEM_EXPORT int32_t
+time_source_clock() {
+    return time_source;
+}
+
+/* CLOCK_MONOTONIC reads the counter, it is no independent reference for the drift */
+VMOPSMEM_EXPORT int32_t
+clock_counter_based() {
+    const char *name = clock_source();
+    return std::strcmp(name, "tsc") == 0 || std::strcmp(name, "arch_sys_counter") == 0;
+}
+
+VMOPSMEM_EXPORT SkewResult
+counter_skew(int32_t first, int32_t second, int64_t duration) {
+    SkewResult r{};
+    r.MinOffset = INT64_MIN;
+    r.MaxOffset = INT64_MAX;
+    r.RoundTrip = INT64_MAX;
+
+    /* Rounds are numbered, each side publishes its counter read with the round it belongs to */
+    std::atomic<uint64_t> ping{0}, pong{0};
+    std::atomic<uint64_t> pingTicks{0}, pongTicks{0};
+    std::atomic<int32_t> stop{0};
+    std::atomic<unsigned> ready{0};
+
+    auto wait = [&](std::atomic<uint64_t> &round, uint64_t expected) {
+        for (unsigned spins = 1; round.load() != expected && !stop.load(); spins++) {
+            if (spins % SKEW_SPINS == 0) {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    std::thread responder([&]() {
+        set_thread_affinity(second);
+        set_thread_priority();
+        ready.fetch_add(1);
+
+        for (uint64_t round = 1; !stop.load(); round++) {
+            wait(ping, round);
+            pongTicks.store(SerializedTicks());
+            pong.store(round);
+        }
+    });
+
+    std::thread initiator([&]() {
+        set_thread_affinity(first);
+        set_thread_priority();
+        while (ready.load() < 1) {
+            std::this_thread::yield();
+        }
+
+        /* t1 < t2 - offset < t3, so every round bounds the offset of the second counter */
+        int64_t end = SourceTime() + duration;
+        for (uint64_t round = 1; SourceTime() < end; round++) {
+            uint64_t t1 = SerializedTicks();
+            pingTicks.store(t1);
+            ping.store(round);
+            wait(pong, round);
+            uint64_t t3 = SerializedTicks();
+            uint64_t t2 = pongTicks.load();
+
+            r.Rounds++;
+            r.Backwards += (t2 < t1) + (t3 < t2);
+            r.MaxOffset = std::min(r.MaxOffset, (int64_t) (t2 - t1));
+            r.MinOffset = std::max(r.MinOffset, (int64_t) (t2 - t3));
+            r.RoundTrip = std::min(r.RoundTrip, (int64_t) (t3 - t1));
+        }
+        stop.store(1);
+    });
+
+    initiator.join();
+    responder.join();
+
+    if (r.Rounds == 0) {
+        r.MinOffset = r.MaxOffset = r.RoundTrip = 0;
+    }
+    return r;
+}
+
+VMOPSMEM_EXPORT DriftResult
+counter_drift(int64_t duration, int64_t interval) {
+    DriftResult r{};
+
+    /* The counter read on both sides of the clock read, the clock sits in the middle */
+    auto pair = [](int64_t &time, uint64_t &ticks) {
+        uint64_t best = UINT64_MAX;
+        for (unsigned i = 0; i < DRIFT_PAIR_TRIES; i++) {
+            uint64_t before = SerializedTicks();
+            int64_t now = ClockNanos(CLOCK_MONOTONIC);
+            uint64_t after = SerializedTicks();
+            if (after - before < best) {
+                best = after - before;
+                time = now;
+                ticks = before + (after - before) / 2;
+            }
+        }
+    };
+
+    /* CLOCK_MONOTONIC is slewed by NTP, against it the drift is relative to real time */
+    int64_t startTime = 0, prevTime;
+    uint64_t startTicks = 0, prevTicks;
+    pair(startTime, startTicks);
+    prevTime = startTime;
+    prevTicks = startTicks;
+
+    /* Least squares slope of the interval frequencies over the interval midpoints */
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    while (prevTime - startTime < duration) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(interval));
+
+        int64_t time = 0;
+        uint64_t ticks = 0;
+        pair(time, ticks);
+
+        double frequency = (double) (ticks - prevTicks) * 1e9 / (double) (time - prevTime);
+        double x = (prevTime + time) / 2e9 - startTime / 1e9;
+        r.MinFrequency = r.Intervals == 0 ? frequency : std::min(r.MinFrequency, frequency);
+        r.MaxFrequency = std::max(r.MaxFrequency, frequency);
+        r.Intervals++;
+        sumX += x;
+        sumY += frequency;
+        sumXX += x * x;
+        sumXY += x * frequency;
+
+        prevTime = time;
+        prevTicks = ticks;
+    }
+
+    r.Time = prevTime - startTime;
+    r.Frequency = (double) (prevTicks - startTicks) * 1e9 / (double) std::max<int64_t>(r.Time, 1);
+
+    double n = (double) r.Intervals;
+    double denominator = n * sumXX - sumX * sumX;
+    if (r.Intervals > 1 && denominator != 0 && r.Frequency != 0) {
+        r.Drift = (n * sumXY - sumX * sumY) / denominator / r.Frequency * 1e6;
+    }
+    return r;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterClockKernels(std::vector<Kernel> &registry) {
+    registry.push_back({"clock_realtime", "calls", clock_support,
+                        [](const KernelParams &p) { return clock_realtime(p.Steps); }, nullptr,
+                        1});
+    registry.push_back({"clock_monotonic", "calls", clock_support,
+                        [](const KernelParams &p) { return clock_monotonic(p.Steps); }, nullptr,
+                        1});
+    registry.push_back({"clock_monotonic_raw", "calls", clock_support,
+                        [](const KernelParams &p) { return clock_monotonic_raw(p.Steps); },
+                        nullptr, 1});
+    registry.push_back({"clock_boottime", "calls", clock_support,
+                        [](const KernelParams &p) { return clock_boottime(p.Steps); }, nullptr,
+                        1});
+    registry.push_back({"clock_monotonic_coarse", "calls", clock_support,
+                        [](const KernelParams &p) { return clock_monotonic_coarse(p.Steps); },
+                        nullptr, 1});
+    registry.push_back({"clock_syscall", "calls", clock_support,
+                        [](const KernelParams &p) { return clock_syscall(p.Steps); }, nullptr,
+                        1});
+}
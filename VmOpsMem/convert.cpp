@@ -0,0 +1,115 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#define CONVERT_STREAM 3
+
+void
+ConvertInput(float *input, uint64_t count) {
+    /* Multiples of 1/4096 in [-64, 64], 19 significant bits so every narrowing rounds */
+    for (uint64_t i = 0; i < std::min<uint64_t>(count, CONVERT_PATTERN); i++) {
+        input[i] = SeededValue(CONVERT_STREAM, i, -(1 << 18), 1 << 18) / 4096.0f;
+    }
+    for (uint64_t i = CONVERT_PATTERN; i < count; i += CONVERT_PATTERN) {
+        std::memcpy(input + i, input,
+                    std::min<uint64_t>(count - i, CONVERT_PATTERN) * sizeof(float));
+    }
+}
+
+void
+QuantInput(int8_t *input, uint64_t count) {
+    for (uint64_t i = 0; i < std::min<uint64_t>(count, CONVERT_PATTERN); i++) {
+        input[i] = (int8_t) SeededValue(CONVERT_STREAM, i, INT8_MIN, INT8_MAX);
+    }
+    for (uint64_t i = CONVERT_PATTERN; i < count; i += CONVERT_PATTERN) {
+        std::memcpy(input + i, input, std::min<uint64_t>(count - i, CONVERT_PATTERN));
+    }
+}
+
+int32_t
+VerifyBf16(uint64_t steps, const Result &result) {
+    if (steps == 0) {
+        return VERIFY_UNCHECKED;
+    }
+
+    float input[CONVERT_CHECKED];
+    ConvertInput(input, CONVERT_CHECKED);
+
+    for (unsigned i = 0; i < CONVERT_CHECKED; i++) {
+        uint32_t bits;
+        std::memcpy(&bits, &input[i], sizeof(bits));
+
+        /* Round to nearest even on the dropped 16 bits */
+        uint16_t expected = (bits + 0x7FFF + ((bits >> 16) & 1)) >> 16;
+        uint16_t value;
+        std::memcpy(&value, result.Output + i * sizeof(value), sizeof(value));
+        if (value != expected) {
+            return VERIFY_MISMATCH;
+        }
+    }
+    return VERIFY_MATCH;
+}
+
+int32_t
+VerifyF16(uint64_t steps, const Result &result) {
+    if (steps == 0) {
+        return VERIFY_UNCHECKED;
+    }
+
+    float input[CONVERT_CHECKED];
+    ConvertInput(input, CONVERT_CHECKED);
+
+    for (unsigned i = 0; i < CONVERT_CHECKED; i++) {
+        uint16_t bits;
+        std::memcpy(&bits, result.Output + i * sizeof(bits), sizeof(bits));
+
+        /* Every input is a normal half, rounding is off by at most half an ulp */
+        double limit = std::ldexp(std::fabs(input[i]), -11);
+        if (!(std::fabs(HalfToFloat(bits) - (double) input[i]) <= limit)) {
+            return VERIFY_MISMATCH;
+        }
+    }
+    return VERIFY_MATCH;
+}
+
+int32_t
+VerifyQuant(uint64_t steps, const Result &result) {
+    if (steps == 0) {
+        return VERIFY_UNCHECKED;
+    }
+
+    float input[CONVERT_CHECKED];
+    ConvertInput(input, CONVERT_CHECKED);
+
+    for (unsigned i = 0; i < CONVERT_CHECKED; i++) {
+        /* The kernels multiply by the reciprocal, exact for a power of two scale */
+        float scaled = std::nearbyint(input[i] * (1.0f / QUANT_SCALE));
+        int32_t expected = std::clamp((int32_t) scaled + QUANT_ZERO_POINT, INT8_MIN, INT8_MAX);
+        if ((int8_t) result.Output[i] != expected) {
+            return VERIFY_MISMATCH;
+        }
+    }
+    return VERIFY_MATCH;
+}
+
+int32_t
+VerifyDequant(uint64_t steps, const Result &result) {
+    if (steps == 0) {
+        return VERIFY_UNCHECKED;
+    }
+
+    int8_t input[CONVERT_CHECKED];
+    QuantInput(input, CONVERT_CHECKED);
+
+    for (unsigned i = 0; i < CONVERT_CHECKED; i++) {
+        float expected = (float) (input[i] - QUANT_ZERO_POINT) * QUANT_SCALE;
+        float value;
+        std::memcpy(&value, result.Output + i * sizeof(value), sizeof(value));
+        if (value != expected) {
+            return VERIFY_MISMATCH;
+        }
+    }
+    return VERIFY_MATCH;
+}
@@ -0,0 +1,230 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/auxv.h>
+
+#include "vmopsmem_export.h"
+
+/* PRECISION CONVERSION */
+#if defined(__ARM_FEATURE_BF16)
+#define CVT_F32_BF16_SUPPORT 1
+#else
+#define CVT_F32_BF16_SUPPORT 0
+#endif
+
+#define CVT_F32_F16_SUPPORT 1
+#define CVT_F32_S8_SUPPORT  1
+#define CVT_S8_F32_SUPPORT  1
+
+/* Elements per call of a block, eight fp32 vectors */
+#define CONVERT_BLOCK 32
+
+/* Streams the source buffer into the target one, the bytes are those of the fp32 side */
+template <typename Source, typename Target, typename Block>
+static Result
+ConvertKernel(uint64_t bytes, uint64_t steps, int32_t flush, Block block) {
+    /* Never fewer than the checked outputs, verify_kernel passes no size */
+    uint64_t count = std::max<uint64_t>(bytes / sizeof(float), CONVERT_CHECKED);
+    count = (count + CONVERT_BLOCK - 1) & ~(uint64_t) (CONVERT_BLOCK - 1);
+
+    uint64_t sourceBytes = count * sizeof(Source);
+    uint64_t targetBytes = count * sizeof(Target);
+    bool fresh;
+    uint64_t contents = std::is_same_v<Source, float> ? BUFFER_F32_INPUT : BUFFER_S8_INPUT;
+    auto source = (Source *) SlotBuffer(0, sourceBytes, contents, fresh);
+    auto target = (Target *) AllocBuffer(targetBytes, 1, BUFFER_FILLED);
+    if (source == nullptr || target == nullptr) {
+        return Result{};
+    }
+
+    /* The inputs stay in place from one call to the next until the size or the seed changes */
+    if (fresh) {
+        if constexpr (std::is_same_v<Source, float>) {
+            ConvertInput(source, count);
+        } else {
+            QuantInput(source, count);
+        }
+    }
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer((const uint8_t *) source, sourceBytes);
+            FlushBuffer((const uint8_t *) target, targetBytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < count; i += CONVERT_BLOCK) {
+            block(source + i, target + i);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * count /* elements */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, target, std::min<uint64_t>(count, CONVERT_CHECKED) * sizeof(Target));
+
+    return r;
+}
+
+/* Scale, round to nearest even and add the zero point, 4 lanes */
+static inline int32x4_t
+Quantize(const float *in) {
+    int32x4_t q = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(in), vdupq_n_f32(1.0f / QUANT_SCALE)));
+    return vaddq_s32(q, vdupq_n_s32(QUANT_ZERO_POINT));
+}
+
+/* Subtract the zero point, convert and scale, 4 lanes */
+static inline float32x4_t
+Dequantize(int16x4_t q) {
+    int32x4_t wide = vsubq_s32(vmovl_s16(q), vdupq_n_s32(QUANT_ZERO_POINT));
+    return vmulq_f32(vcvtq_f32_s32(wide), vdupq_n_f32(QUANT_SCALE));
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+cvt_f32_bf16_support() {
+#if CVT_F32_BF16_SUPPORT
+    if (getauxval(AT_HWCAP2) & HWCAP2_BF16) {
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+cvt_f32_f16_support() {
+#if CVT_F32_F16_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+cvt_f32_s8_support() {
+#if CVT_F32_S8_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+cvt_s8_f32_support() {
+#if CVT_S8_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+#if CVT_F32_BF16_SUPPORT
+VMOPSMEM_EXPORT Result
+cvt_f32_bf16(uint64_t bytes, uint64_t steps, int32_t flush) {
+    /* bfcvtn and bfcvtn2, two fp32 vectors into one of bf16, rounded to nearest even */
+    return ConvertKernel<float, uint16_t>(bytes, steps, flush, [](const float *in, uint16_t *out) {
+        for (unsigned i = 0; i < CONVERT_BLOCK; i += 8) {
+            bfloat16x8_t r = vcvtq_low_bf16_f32(vld1q_f32(in + i));
+            r = vcvtq_high_bf16_f32(r, vld1q_f32(in + i + 4));
+            vst1q_bf16((bfloat16_t *) (out + i), r);
+        }
+    });
+}
+#endif
+
+#if CVT_F32_F16_SUPPORT
+VMOPSMEM_EXPORT Result
+cvt_f32_f16(uint64_t bytes, uint64_t steps, int32_t flush) {
+    /* fcvtn and fcvtn2, two fp32 vectors into one of fp16 */
+    return ConvertKernel<float, uint16_t>(bytes, steps, flush, [](const float *in, uint16_t *out) {
+        for (unsigned i = 0; i < CONVERT_BLOCK; i += 8) {
+            float16x8_t r = vcvt_high_f16_f32(vcvt_f16_f32(vld1q_f32(in + i)),
+                                              vld1q_f32(in + i + 4));
+            vst1q_f16((float16_t *) (out + i), r);
+        }
+    });
+}
+#endif
+
+#if CVT_F32_S8_SUPPORT
+VMOPSMEM_EXPORT Result
+cvt_f32_s8(uint64_t bytes, uint64_t steps, int32_t flush) {
+    /* Narrowed with signed saturation twice, 32 to 16 and 16 to 8 bits */
+    return ConvertKernel<float, int8_t>(bytes, steps, flush, [](const float *in, int8_t *out) {
+        for (unsigned i = 0; i < CONVERT_BLOCK; i += 16) {
+            int16x8_t lo = vqmovn_high_s32(vqmovn_s32(Quantize(in + i)), Quantize(in + i + 4));
+            int16x8_t hi =
+                vqmovn_high_s32(vqmovn_s32(Quantize(in + i + 8)), Quantize(in + i + 12));
+            vst1q_s8(out + i, vqmovn_high_s16(vqmovn_s16(lo), hi));
+        }
+    });
+}
+#endif
+
+#if CVT_S8_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+cvt_s8_f32(uint64_t bytes, uint64_t steps, int32_t flush) {
+    /* Sign extended twice, 8 to 16 and 16 to 32 bits */
+    return ConvertKernel<int8_t, float>(bytes, steps, flush, [](const int8_t *in, float *out) {
+        for (unsigned i = 0; i < CONVERT_BLOCK; i += 16) {
+            int8x16_t q = vld1q_s8(in + i);
+            int16x8_t lo = vmovl_s8(vget_low_s8(q));
+            int16x8_t hi = vmovl_high_s8(q);
+            vst1q_f32(out + i, Dequantize(vget_low_s16(lo)));
+            vst1q_f32(out + i + 4, Dequantize(vget_high_s16(lo)));
+            vst1q_f32(out + i + 8, Dequantize(vget_low_s16(hi)));
+            vst1q_f32(out + i + 12, Dequantize(vget_high_s16(hi)));
+        }
+    });
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterConvertKernels(std::vector<Kernel> &registry) {
+#if CVT_F32_BF16_SUPPORT
+    registry.push_back({"cvt_f32_bf16", "elems", cvt_f32_bf16_support,
+                        [](const KernelParams &p) {
+                            return cvt_f32_bf16(p.Bytes, p.Steps, p.Flush);
+                        },
+                        VerifyBf16});
+#endif
+#if CVT_F32_F16_SUPPORT
+    registry.push_back({"cvt_f32_f16", "elems", cvt_f32_f16_support,
+                        [](const KernelParams &p) {
+                            return cvt_f32_f16(p.Bytes, p.Steps, p.Flush);
+                        },
+                        VerifyF16});
+#endif
+#if CVT_F32_S8_SUPPORT
+    registry.push_back({"cvt_f32_s8", "elems", cvt_f32_s8_support,
+                        [](const KernelParams &p) {
+                            return cvt_f32_s8(p.Bytes, p.Steps, p.Flush);
+                        },
+                        VerifyQuant});
+#endif
+#if CVT_S8_F32_SUPPORT
+    registry.push_back({"cvt_s8_f32", "elems", cvt_s8_f32_support,
+                        [](const KernelParams &p) {
+                            return cvt_s8_f32(p.Bytes, p.Steps, p.Flush);
+                        },
+                        VerifyDequant});
+#endif
+}
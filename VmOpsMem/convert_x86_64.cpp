@@ -0,0 +1,213 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+#include <immintrin.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "vmopsmem_export.h"
+
+/* PRECISION CONVERSION */
+#if defined(__AVX512BF16__)
+#define CVT_F32_BF16_SUPPORT 1
+#else
+#define CVT_F32_BF16_SUPPORT 0
+#endif
+
+#if defined(__AVX512F__)
+#define CVT_F32_F16_SUPPORT 1
+#define CVT_F32_S8_SUPPORT  1
+#define CVT_S8_F32_SUPPORT  1
+#else
+#define CVT_F32_F16_SUPPORT 0
+#define CVT_F32_S8_SUPPORT  0
+#define CVT_S8_F32_SUPPORT  0
+#endif
+
+/* Elements per call of a block, two fp32 vectors */
+#define CONVERT_BLOCK 32
+
+/* Streams the source buffer into the target one, the bytes are those of the fp32 side */
+template <typename Source, typename Target, typename Block>
+static Result
+ConvertKernel(uint64_t bytes, uint64_t steps, int32_t flush, Block block) {
+    /* Never fewer than the checked outputs, verify_kernel passes no size */
+    uint64_t count = std::max<uint64_t>(bytes / sizeof(float), CONVERT_CHECKED);
+    count = (count + CONVERT_BLOCK - 1) & ~(uint64_t) (CONVERT_BLOCK - 1);
+
+    uint64_t sourceBytes = count * sizeof(Source);
+    uint64_t targetBytes = count * sizeof(Target);
+    bool fresh;
+    uint64_t contents = std::is_same_v<Source, float> ? BUFFER_F32_INPUT : BUFFER_S8_INPUT;
+    auto source = (Source *) SlotBuffer(0, sourceBytes, contents, fresh);
+    auto target = (Target *) AllocBuffer(targetBytes, 1, BUFFER_FILLED);
+    if (source == nullptr || target == nullptr) {
+        return Result{};
+    }
+
+    /* The inputs stay in place from one call to the next until the size or the seed changes */
+    if (fresh) {
+        if constexpr (std::is_same_v<Source, float>) {
+            ConvertInput(source, count);
+        } else {
+            QuantInput(source, count);
+        }
+    }
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer((const uint8_t *) source, sourceBytes);
+            FlushBuffer((const uint8_t *) target, targetBytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < count; i += CONVERT_BLOCK) {
+            block(source + i, target + i);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * count /* elements */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, target, std::min<uint64_t>(count, CONVERT_CHECKED) * sizeof(Target));
+
+    return r;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+cvt_f32_bf16_support() {
+#if CVT_F32_BF16_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+cvt_f32_f16_support() {
+#if CVT_F32_F16_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+cvt_f32_s8_support() {
+#if CVT_F32_S8_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+cvt_s8_f32_support() {
+#if CVT_S8_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+#if CVT_F32_BF16_SUPPORT
+VMOPSMEM_EXPORT Result
+cvt_f32_bf16(uint64_t bytes, uint64_t steps, int32_t flush) {
+    /* vcvtne2ps2bf16, both fp32 vectors into one of bf16, rounded to nearest even */
+    return ConvertKernel<float, uint16_t>(bytes, steps, flush, [](const float *in, uint16_t *out) {
+        __m512bh r = _mm512_cvtne2ps_pbh(_mm512_load_ps(in + 16), _mm512_load_ps(in));
+        _mm512_store_si512((__m512i *) out, (__m512i) r);
+    });
+}
+#endif
+
+#if CVT_F32_F16_SUPPORT
+VMOPSMEM_EXPORT Result
+cvt_f32_f16(uint64_t bytes, uint64_t steps, int32_t flush) {
+    /* vcvtps2ph, one fp32 vector into half of one of fp16 */
+    return ConvertKernel<float, uint16_t>(bytes, steps, flush, [](const float *in, uint16_t *out) {
+        __m256i lo = _mm512_cvtps_ph(_mm512_load_ps(in), _MM_FROUND_TO_NEAREST_INT);
+        __m256i hi = _mm512_cvtps_ph(_mm512_load_ps(in + 16), _MM_FROUND_TO_NEAREST_INT);
+        _mm256_store_si256((__m256i *) out, lo);
+        _mm256_store_si256((__m256i *) (out + 16), hi);
+    });
+}
+#endif
+
+#if CVT_F32_S8_SUPPORT
+VMOPSMEM_EXPORT Result
+cvt_f32_s8(uint64_t bytes, uint64_t steps, int32_t flush) {
+    /* Scale, round to nearest even, add the zero point and narrow with signed saturation */
+    return ConvertKernel<float, int8_t>(bytes, steps, flush, [](const float *in, int8_t *out) {
+        const __m512 scale = _mm512_set1_ps(1.0f / QUANT_SCALE);
+        const __m512i zero = _mm512_set1_epi32(QUANT_ZERO_POINT);
+        __m512i lo = _mm512_cvtps_epi32(_mm512_mul_ps(_mm512_load_ps(in), scale));
+        __m512i hi = _mm512_cvtps_epi32(_mm512_mul_ps(_mm512_load_ps(in + 16), scale));
+        _mm_store_si128((__m128i *) out, _mm512_cvtsepi32_epi8(_mm512_add_epi32(lo, zero)));
+        _mm_store_si128((__m128i *) (out + 16), _mm512_cvtsepi32_epi8(_mm512_add_epi32(hi, zero)));
+    });
+}
+#endif
+
+#if CVT_S8_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+cvt_s8_f32(uint64_t bytes, uint64_t steps, int32_t flush) {
+    /* Sign extend, subtract the zero point, convert and scale */
+    return ConvertKernel<int8_t, float>(bytes, steps, flush, [](const int8_t *in, float *out) {
+        const __m512 scale = _mm512_set1_ps(QUANT_SCALE);
+        const __m512i zero = _mm512_set1_epi32(QUANT_ZERO_POINT);
+        __m512i lo = _mm512_cvtepi8_epi32(_mm_load_si128((const __m128i *) in));
+        __m512i hi = _mm512_cvtepi8_epi32(_mm_load_si128((const __m128i *) (in + 16)));
+        lo = _mm512_sub_epi32(lo, zero);
+        hi = _mm512_sub_epi32(hi, zero);
+        _mm512_store_ps(out, _mm512_mul_ps(_mm512_cvtepi32_ps(lo), scale));
+        _mm512_store_ps(out + 16, _mm512_mul_ps(_mm512_cvtepi32_ps(hi), scale));
+    });
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterConvertKernels(std::vector<Kernel> &registry) {
+#if CVT_F32_BF16_SUPPORT
+    registry.push_back({"cvt_f32_bf16", "elems", cvt_f32_bf16_support,
+                        [](const KernelParams &p) {
+                            return cvt_f32_bf16(p.Bytes, p.Steps, p.Flush);
+                        },
+                        VerifyBf16});
+#endif
+#if CVT_F32_F16_SUPPORT
+    registry.push_back({"cvt_f32_f16", "elems", cvt_f32_f16_support,
+                        [](const KernelParams &p) {
+                            return cvt_f32_f16(p.Bytes, p.Steps, p.Flush);
+                        },
+                        VerifyF16});
+#endif
+#if CVT_F32_S8_SUPPORT
+    registry.push_back({"cvt_f32_s8", "elems", cvt_f32_s8_support,
+                        [](const KernelParams &p) {
+                            return cvt_f32_s8(p.Bytes, p.Steps, p.Flush);
+                        },
+                        VerifyQuant});
+#endif
+#if CVT_S8_F32_SUPPORT
+    registry.push_back({"cvt_s8_f32", "elems", cvt_s8_f32_support,
+                        [](const KernelParams &p) {
+                            return cvt_s8_f32(p.Bytes, p.Steps, p.Flush);
+                        },
+                        VerifyDequant});
+#endif
+}
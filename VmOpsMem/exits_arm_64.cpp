@@ -0,0 +1,96 @@
+#include "vm_ops_mem.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+
+#include "vmopsmem_export.h"
+
+/* TRAPPING INSTRUCTIONS, EL0 reads the kernel emulates or the hypervisor traps */
+#define EXIT_MRS_SUPPORT    1
+#define EXIT_CNTVCT_SUPPORT 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+exit_mrs_support() {
+#if EXIT_MRS_SUPPORT
+    /* The kernel only emulates EL0 reads of the ID registers when it says so */
+    return (getauxval(AT_HWCAP) & HWCAP_CPUID) != 0;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+exit_cntvct_support() {
+#if EXIT_CNTVCT_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+#if EXIT_MRS_SUPPORT
+VMOPSMEM_EXPORT Result
+exit_mrs(uint64_t steps) {
+    uint64_t midr = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    /* Undefined at EL0, every read traps to the kernel's emulation */
+    for (uint64_t k = 0; k < steps; k++) {
+        __asm__ volatile("mrs	%0, midr_el1" : "=r"(midr));
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps /* mrs */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &midr, sizeof(midr));
+    return r;
+}
+#endif
+
+#if EXIT_CNTVCT_SUPPORT
+VMOPSMEM_EXPORT Result
+exit_cntvct(uint64_t steps) {
+    uint64_t ticks = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    /* Only traps when the hypervisor or the kernel traps the counter, e.g. for an erratum */
+    for (uint64_t k = 0; k < steps; k++) {
+        __asm__ volatile("mrs	%0, cntvct_el0" : "=r"(ticks));
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps /* mrs */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &ticks, sizeof(ticks));
+    return r;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterExitKernels(std::vector<Kernel> &registry) {
+#if EXIT_MRS_SUPPORT
+    registry.push_back({"exit_mrs", "inst", exit_mrs_support,
+                        [](const KernelParams &p) { return exit_mrs(p.Steps); }, nullptr, 1});
+#endif
+#if EXIT_CNTVCT_SUPPORT
+    registry.push_back({"exit_cntvct", "inst", exit_cntvct_support,
+                        [](const KernelParams &p) { return exit_cntvct(p.Steps); }, nullptr, 1});
+#endif
+}
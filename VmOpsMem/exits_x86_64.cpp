@@ -0,0 +1,158 @@
+#include "vm_ops_mem.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "vmopsmem_export.h"
+
+/* TRAPPING INSTRUCTIONS, each call to the hypervisor is a VM exit */
+#define EXIT_CPUID_SUPPORT  1
+#define EXIT_RDTSCP_SUPPORT 1
+#define EXIT_RDMSR_SUPPORT  1
+
+/* rdmsr is privileged, user space reaches it through the msr driver */
+#define MSR_IA32_TSC 0x10
+
+static int
+OpenMsr(int cpu) {
+    char path[64];
+    snprintf(path, sizeof(path), "/dev/cpu/%d/msr", cpu);
+    return open(path, O_RDONLY);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+exit_cpuid_support() {
+#if EXIT_CPUID_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+exit_rdtscp_support() {
+#if EXIT_RDTSCP_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+exit_rdmsr_support() {
+#if EXIT_RDMSR_SUPPORT
+    /* Needs the msr module and CAP_SYS_RAWIO */
+    int fd = OpenMsr(0);
+    if (fd >= 0) {
+        close(fd);
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+#if EXIT_CPUID_SUPPORT
+VMOPSMEM_EXPORT Result
+exit_cpuid(uint64_t steps) {
+    uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    /* Leaf 0 is intercepted by every hypervisor */
+    for (uint64_t k = 0; k < steps; k++) {
+        __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0), "c"(0));
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps /* cpuid */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &eax, sizeof(eax));
+    return r;
+}
+#endif
+
+#if EXIT_RDTSCP_SUPPORT
+VMOPSMEM_EXPORT Result
+exit_rdtscp(uint64_t steps) {
+    uint32_t lo = 0, hi = 0, aux = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    /* Only exits when the hypervisor traps the TSC, e.g. to emulate a migrated frequency */
+    for (uint64_t k = 0; k < steps; k++) {
+        __asm__ volatile("rdtscp" : "=a"(lo), "=d"(hi), "=c"(aux));
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps /* rdtscp */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &aux, sizeof(aux));
+    return r;
+}
+#endif
+
+#if EXIT_RDMSR_SUPPORT
+VMOPSMEM_EXPORT Result
+exit_rdmsr(uint64_t steps) {
+    /* The driver runs rdmsr on the CPU of the file, this one avoids a cross-CPU call */
+    int fd = OpenMsr(sched_getcpu());
+    if (fd < 0) {
+        return Result{};
+    }
+
+    uint64_t value = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (pread(fd, &value, sizeof(value), MSR_IA32_TSC) != sizeof(value)) {
+            close(fd);
+            return Result{};
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    close(fd);
+
+    uint64_t ops = steps /* rdmsr, each behind a pread */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &value, sizeof(value));
+    return r;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterExitKernels(std::vector<Kernel> &registry) {
+#if EXIT_CPUID_SUPPORT
+    registry.push_back({"exit_cpuid", "inst", exit_cpuid_support,
+                        [](const KernelParams &p) { return exit_cpuid(p.Steps); }, nullptr, 1});
+#endif
+#if EXIT_RDTSCP_SUPPORT
+    registry.push_back({"exit_rdtscp", "inst", exit_rdtscp_support,
+                        [](const KernelParams &p) { return exit_rdtscp(p.Steps); }, nullptr, 1});
+#endif
+#if EXIT_RDMSR_SUPPORT
+    registry.push_back({"exit_rdmsr", "inst", exit_rdmsr_support,
+                        [](const KernelParams &p) { return exit_rdmsr(p.Steps); }, nullptr, 1});
+#endif
+}
@@ -0,0 +1,284 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include "vmopsmem_export.h"
+
+#define CACHE_LINE_SIZE 64
+
+/* L1 resident working set when the job does not ask for one */
+#define JIT_DEFAULT_BYTES (16 * 1024)
+#define JIT_MAX_COUNT     64
+#define JIT_MAX_UNROLL    64
+
+struct JitEntry {
+    const JitOp *Op;
+    unsigned Count;
+};
+
+struct JitProgram {
+    std::vector<JitSlot> Body;
+    uint32_t Stride; /* cursor advance per iteration, one line per memory operand */
+    void *Code;
+    size_t CodeSize;
+};
+
+static JitProgram jit_program;
+/* Held shared by every running call, set_jit_mix waits for them before replacing the code */
+static std::shared_mutex jit_lock;
+
+static const JitOp *
+FindJitOp(const std::string &name) {
+    for (const JitOp &op : jit_target.Ops) {
+        if (name == op.Name) {
+            return &op;
+        }
+    }
+    return nullptr;
+}
+
+/* "fma:2,load:1,amx_s8:1", the count defaults to one */
+static int32_t
+ParseMix(const char *mix, std::vector<JitEntry> &entries) {
+    std::string text(mix);
+    text.erase(std::remove(text.begin(), text.end(), ' '), text.end());
+
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = std::min(text.find(',', begin), text.size());
+        std::string item = text.substr(begin, end - begin);
+        begin = end + 1;
+
+        size_t colon = item.find(':');
+        std::string name = item.substr(0, colon);
+        unsigned count = 1;
+        if (colon != std::string::npos) {
+            char *last;
+            count = strtoul(item.c_str() + colon + 1, &last, 10);
+            if (*last != '\0' || count == 0 || count > JIT_MAX_COUNT) {
+                return JIT_BAD_MIX;
+            }
+        }
+
+        const JitOp *op = FindJitOp(name);
+        if (op == nullptr) {
+            return JIT_BAD_MIX;
+        }
+        if (!op->Support()) {
+            return JIT_UNSUPPORTED;
+        }
+        entries.push_back({op, count});
+    }
+
+    return JIT_OK;
+}
+
+static int32_t
+PlanBody(const std::vector<JitEntry> &entries, uint32_t unroll, uint32_t accumulators,
+         JitProgram &program) {
+    /* Each entry owns a block of registers so the mix forms independent chains */
+    std::vector<std::vector<unsigned>> blocks(entries.size());
+    unsigned next[JIT_CLASSES] = {};
+    unsigned rounds = 0;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        const JitOp *op = entries[i].Op;
+        rounds = std::max(rounds, entries[i].Count);
+        if (op->Memory == JIT_MEM_STORE) {
+            continue;
+        }
+
+        const std::vector<unsigned> &pool = jit_target.Registers[op->Class];
+        /* A small register file caps the request rather than failing it */
+        unsigned want = std::min({accumulators, entries[i].Count * unroll, (unsigned) pool.size()});
+        if (next[op->Class] + want > pool.size()) {
+            return JIT_TOO_LARGE;
+        }
+        blocks[i].assign(pool.begin() + next[op->Class], pool.begin() + next[op->Class] + want);
+        next[op->Class] += want;
+    }
+
+    /* Interleave the entries so "fma:2,load:1" issues fma, load, fma rather than two runs */
+    std::vector<unsigned> used(entries.size());
+    uint32_t offset = 0;
+
+    for (uint32_t u = 0; u < unroll; u++) {
+        for (unsigned round = 0; round < rounds; round++) {
+            for (size_t i = 0; i < entries.size(); i++) {
+                if (round >= entries[i].Count) {
+                    continue;
+                }
+
+                JitSlot slot{entries[i].Op, 0, 0};
+                if (slot.Op->Memory != JIT_MEM_NONE) {
+                    if (offset > jit_target.MaxOffset) {
+                        return JIT_TOO_LARGE;
+                    }
+                    slot.Offset = offset;
+                    offset += CACHE_LINE_SIZE;
+                }
+                if (!blocks[i].empty()) {
+                    slot.Reg = blocks[i][used[i]++ % blocks[i].size()];
+                }
+                program.Body.push_back(slot);
+            }
+        }
+    }
+
+    program.Stride = offset;
+    return JIT_OK;
+}
+
+static void *
+MapCode(const std::vector<uint8_t> &code) {
+    void *p = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                   0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    std::memcpy(p, code.data(), code.size());
+
+    /* Never writable and executable at the same time */
+    if (mprotect(p, code.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(p, code.size());
+        return nullptr;
+    }
+    __builtin___clear_cache((char *) p, (char *) p + code.size());
+    return p;
+}
+
+static void
+ReleaseProgram(JitProgram &program) {
+    if (program.Code != nullptr) {
+        munmap(program.Code, program.CodeSize);
+    }
+    program = JitProgram{};
+}
+
+static Result
+RunJit(const KernelParams &params) {
+    std::shared_lock<std::shared_mutex> lock(jit_lock);
+    const JitProgram &program = jit_program;
+    if (program.Code == nullptr) {
+        return Result{};
+    }
+
+    /* Whole number of strides, so the cursor wraps exactly at the end */
+    uint64_t stride = std::max<uint64_t>(program.Stride, CACHE_LINE_SIZE);
+    uint64_t bytes = params.Bytes > 0 ? params.Bytes : JIT_DEFAULT_BYTES;
+    bytes = (bytes + stride - 1) / stride * stride;
+
+    /* Kept per thread like the memory kernels, stores write over the ones */
+    bool stores = std::any_of(program.Body.begin(), program.Body.end(), [](const JitSlot &slot) {
+        return slot.Op->Memory == JIT_MEM_STORE;
+    });
+    bool fresh;
+    uint8_t *buffer = SlotBuffer(0, bytes, stores ? BUFFER_FILLED : BUFFER_ONES, fresh);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    /* One full vector register per operand, 1.0 keeps the float chains finite */
+    alignas(CACHE_LINE_SIZE) float operands[2 * CACHE_LINE_SIZE / sizeof(float)];
+    std::fill(std::begin(operands), std::end(operands), 1.0f);
+    alignas(CACHE_LINE_SIZE) char output[CACHE_LINE_SIZE] = {};
+
+    auto function = (JitFunction) program.Code;
+    jit_target.Enter(program.Body);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (params.Steps > 0) {
+        function(params.Steps, buffer, buffer + bytes, operands, output, program.Stride);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    jit_target.Exit(program.Body);
+
+    uint64_t ops = params.Steps * program.Body.size() /* instructions */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, output, sizeof(output));
+    return r;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+jit_support() {
+    std::shared_lock<std::shared_mutex> lock(jit_lock);
+    return jit_program.Code != nullptr;
+}
+
+VMOPSMEM_EXPORT const char *
+jit_instructions() {
+    static std::string names;
+
+    names.clear();
+    for (const JitOp &op : jit_target.Ops) {
+        if (!op.Support()) {
+            continue;
+        }
+        if (!names.empty()) {
+            names += ',';
+        }
+        names += op.Name;
+    }
+    return names.c_str();
+}
+
+VMOPSMEM_EXPORT int32_t
+set_jit_mix(const char *mix, uint32_t unroll, uint32_t accumulators) {
+    std::unique_lock<std::shared_mutex> lock(jit_lock);
+    ReleaseProgram(jit_program);
+
+    if (mix == nullptr || unroll == 0 || unroll > JIT_MAX_UNROLL || accumulators == 0) {
+        return JIT_BAD_MIX;
+    }
+
+    std::vector<JitEntry> entries;
+    int32_t status = ParseMix(mix, entries);
+    if (status != JIT_OK) {
+        return status;
+    }
+
+    JitProgram program{};
+    status = PlanBody(entries, unroll, accumulators, program);
+    if (status != JIT_OK) {
+        return status;
+    }
+
+    std::vector<uint8_t> code;
+    jit_target.Emit(code, program.Body);
+
+    program.Code = MapCode(code);
+    program.CodeSize = code.size();
+    if (program.Code == nullptr) {
+        return JIT_MAP_FAILED;
+    }
+
+    jit_program = program;
+    return JIT_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterJitKernels(std::vector<Kernel> &registry) {
+    registry.push_back({"jit", "inst", jit_support, RunJit});
+}
@@ -0,0 +1,204 @@
+#include "vm_ops_mem.h"
+
+#include <cstddef>
+
+#include <asm/hwcap.h>
+#include <stdint.h>
+#include <sys/auxv.h>
+
+/* General purpose registers, arguments arrive in AAPCS64 order */
+#define GPR_ITERATIONS 0
+#define GPR_BEGIN      1
+#define GPR_END        2
+#define GPR_OPERANDS   3
+#define GPR_OUTPUT     4
+#define GPR_STRIDE     5
+#define GPR_CURSOR     9
+
+/* v30 and v31 hold the fixed operands, v8 - v15 are callee saved and never touched */
+#define OPERAND_A 30
+#define OPERAND_B 31
+
+#define INST_NOP 0xD503201F
+#define INST_RET 0xD65F03C0
+
+static int32_t
+BaseSupport() {
+    return 1;
+}
+
+static int32_t
+DotSupport() {
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMDDP) != 0;
+}
+
+static int32_t
+HalfSupport() {
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMDHP) != 0;
+}
+
+static int32_t
+MatMulSupport() {
+    return (getauxval(AT_HWCAP2) & HWCAP2_I8MM) != 0;
+}
+
+static int32_t
+BF16Support() {
+    return (getauxval(AT_HWCAP2) & HWCAP2_BF16) != 0;
+}
+
+static void
+EmitInst(std::vector<uint8_t> &code, uint32_t inst) {
+    for (unsigned i = 0; i < 4; i++) {
+        code.push_back(inst >> (8 * i));
+    }
+}
+
+/* Three register vector instruction: Vd, Vn, Vm */
+static void
+EmitVector(std::vector<uint8_t> &code, uint32_t opcode, unsigned d, unsigned n, unsigned m) {
+    EmitInst(code, opcode | m << 16 | n << 5 | d);
+}
+
+/* ldr/str q with an unsigned offset, scaled by 16 */
+static void
+EmitQuad(std::vector<uint8_t> &code, uint32_t opcode, unsigned t, unsigned n, uint32_t offset) {
+    EmitInst(code, opcode | (offset / 16) << 10 | n << 5 | t);
+}
+
+/* fmla vd.4s, v30.4s, v31.4s */
+static void
+EmitFma(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVector(code, 0x4E20CC00, slot.Reg, OPERAND_A, OPERAND_B);
+}
+
+/* fmla vd.8h, v30.8h, v31.8h */
+static void
+EmitFmaF16(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVector(code, 0x4E400C00, slot.Reg, OPERAND_A, OPERAND_B);
+}
+
+/* fadd vd.4s, vd.4s, v31.4s */
+static void
+EmitAdd(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVector(code, 0x4E20D400, slot.Reg, slot.Reg, OPERAND_B);
+}
+
+/* fmul vd.4s, vd.4s, v31.4s */
+static void
+EmitMul(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVector(code, 0x6E20DC00, slot.Reg, slot.Reg, OPERAND_B);
+}
+
+/* sdot vd.4s, v30.16b, v31.16b */
+static void
+EmitDot(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVector(code, 0x4E809400, slot.Reg, OPERAND_A, OPERAND_B);
+}
+
+/* smmla vd.4s, v30.16b, v31.16b */
+static void
+EmitMmla(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVector(code, 0x4E80A400, slot.Reg, OPERAND_A, OPERAND_B);
+}
+
+/* bfdot vd.4s, v30.8h, v31.8h */
+static void
+EmitBFDot(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVector(code, 0x6E40FC00, slot.Reg, OPERAND_A, OPERAND_B);
+}
+
+/* bfmmla vd.4s, v30.8h, v31.8h */
+static void
+EmitBFMmla(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVector(code, 0x6E40EC00, slot.Reg, OPERAND_A, OPERAND_B);
+}
+
+/* ldr qd, [x9, #offset] */
+static void
+EmitLoad(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitQuad(code, 0x3DC00000, slot.Reg, GPR_CURSOR, slot.Offset);
+}
+
+/* str q30, [x9, #offset] */
+static void
+EmitStore(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitQuad(code, 0x3D800000, OPERAND_A, GPR_CURSOR, slot.Offset);
+}
+
+/* add xd, xd, #1 */
+static void
+EmitAlu(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitInst(code, 0x91000400 | slot.Reg << 5 | slot.Reg);
+}
+
+static void
+EmitLoop(std::vector<uint8_t> &code, const std::vector<JitSlot> &body) {
+    /* ldr q30, [x3]; ldr q31, [x3, #64] */
+    EmitQuad(code, 0x3DC00000, OPERAND_A, GPR_OPERANDS, 0);
+    EmitQuad(code, 0x3DC00000, OPERAND_B, GPR_OPERANDS, 64);
+
+    /* Every accumulator starts at zero: movi vd.2d, #0 and movz xd, #0 */
+    for (unsigned reg : jit_target.Registers[JIT_VECTOR]) {
+        EmitInst(code, 0x6F00E400 | reg);
+    }
+    for (unsigned reg : jit_target.Registers[JIT_GPR]) {
+        EmitInst(code, 0xD2800000 | reg);
+    }
+
+    /* mov x9, x1 */
+    EmitInst(code, 0xAA0003E0 | GPR_BEGIN << 16 | GPR_CURSOR);
+
+    /* Loop entry on its own cache line */
+    while (code.size() % 64 != 0) {
+        EmitInst(code, INST_NOP);
+    }
+    size_t loop = code.size();
+
+    for (const JitSlot &slot : body) {
+        slot.Op->Emit(code, slot);
+    }
+
+    /* add x9, x9, x5; cmp x9, x2; csel x9, x1, x9, hs; subs x0, x0, #1; b.ne loop */
+    EmitInst(code, 0x8B000000 | GPR_STRIDE << 16 | GPR_CURSOR << 5 | GPR_CURSOR);
+    EmitInst(code, 0xEB00001F | GPR_END << 16 | GPR_CURSOR << 5);
+    EmitInst(code, 0x9A802000 | GPR_CURSOR << 16 | GPR_BEGIN << 5 | GPR_CURSOR);
+    EmitInst(code, 0xF1000400 | GPR_ITERATIONS << 5 | GPR_ITERATIONS);
+    int32_t branch = ((int64_t) loop - (int64_t) code.size()) / 4;
+    EmitInst(code, 0x54000001 | (branch & 0x7FFFF) << 5);
+
+    /* str q0, [x4]; ret */
+    EmitQuad(code, 0x3D800000, 0, GPR_OUTPUT, 0);
+    EmitInst(code, INST_RET);
+}
+
+static void
+EnterLoop(const std::vector<JitSlot> &body) {}
+
+static void
+ExitLoop(const std::vector<JitSlot> &body) {}
+
+const JitTarget jit_target = {
+    {
+        {"fma", JIT_VECTOR, JIT_MEM_NONE, BaseSupport, EmitFma},
+        {"fma_f16", JIT_VECTOR, JIT_MEM_NONE, HalfSupport, EmitFmaF16},
+        {"add", JIT_VECTOR, JIT_MEM_NONE, BaseSupport, EmitAdd},
+        {"mul", JIT_VECTOR, JIT_MEM_NONE, BaseSupport, EmitMul},
+        {"dot", JIT_VECTOR, JIT_MEM_NONE, DotSupport, EmitDot},
+        {"mmla", JIT_VECTOR, JIT_MEM_NONE, MatMulSupport, EmitMmla},
+        {"bfdot", JIT_VECTOR, JIT_MEM_NONE, BF16Support, EmitBFDot},
+        {"bfmmla", JIT_VECTOR, JIT_MEM_NONE, BF16Support, EmitBFMmla},
+        {"load", JIT_VECTOR, JIT_MEM_LOAD, BaseSupport, EmitLoad},
+        {"store", JIT_VECTOR, JIT_MEM_STORE, BaseSupport, EmitStore},
+        {"alu", JIT_GPR, JIT_MEM_NONE, BaseSupport, EmitAlu},
+    },
+    {
+        {0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29},
+        {},
+        {10, 11, 12, 13, 14, 15},
+    },
+    4095 * 16,
+    EmitLoop,
+    EnterLoop,
+    ExitLoop,
+};
@@ -0,0 +1,308 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <immintrin.h>
+#include <stdint.h>
+
+/* General purpose registers, arguments arrive in System V order */
+#define GPR_RAX 0 /* cursor */
+#define GPR_RCX 1 /* operands, free after the prologue */
+#define GPR_RDX 2 /* end */
+#define GPR_RSI 6 /* begin */
+#define GPR_RDI 7 /* iterations */
+#define GPR_R8  8 /* output */
+#define GPR_R9  9 /* stride */
+#define GPR_R10 10
+#define GPR_R11 11
+
+/* zmm30 and zmm31 hold the fixed operands, tmm4 and tmm5 for the tile instructions */
+#define OPERAND_A 30
+#define OPERAND_B 31
+#define TILE_A    4
+#define TILE_B    5
+
+/* Opcode maps and implied prefixes of the VEX and EVEX encodings */
+#define MAP_0F   1
+#define MAP_0F38 2
+#define PP_NONE  0
+#define PP_66    1
+#define PP_F3    2
+#define PP_F2    3
+
+struct tile_config_t {
+    uint8_t paletteId;
+    uint8_t startRow;
+    uint8_t reserved[14];
+    uint16_t cols[16];
+    uint8_t rows[16];
+};
+
+static void
+QueryLeaf7(uint32_t &ebx, uint32_t &ecx, uint32_t &edx) {
+    uint32_t eax = 7;
+    ecx = 0;
+    __asm__ volatile("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+}
+
+static int32_t
+BaseSupport() {
+    return 1;
+}
+
+static int32_t
+Avx512Support() {
+    uint32_t ebx, ecx, edx;
+    QueryLeaf7(ebx, ecx, edx);
+    return (ebx >> 16) & 1; /* AVX512F */
+}
+
+static int32_t
+VnniSupport() {
+    uint32_t ebx, ecx, edx;
+    QueryLeaf7(ebx, ecx, edx);
+    return ((ebx >> 16) & 1) && ((ecx >> 11) & 1); /* AVX512F, AVX512_VNNI */
+}
+
+static int32_t
+AmxS8Support() {
+#if defined(__AMX_TILE__)
+    uint32_t ebx, ecx, edx;
+    QueryLeaf7(ebx, ecx, edx);
+    return ((edx >> 24) & 1) && ((edx >> 25) & 1); /* AMX-TILE, AMX-INT8 */
+#endif
+    return 0;
+}
+
+static int32_t
+AmxBF16Support() {
+#if defined(__AMX_TILE__)
+    uint32_t ebx, ecx, edx;
+    QueryLeaf7(ebx, ecx, edx);
+    return ((edx >> 24) & 1) && ((edx >> 22) & 1); /* AMX-TILE, AMX-BF16 */
+#endif
+    return 0;
+}
+
+static void
+Emit32(std::vector<uint8_t> &code, uint32_t value) {
+    for (unsigned i = 0; i < 4; i++) {
+        code.push_back(value >> (8 * i));
+    }
+}
+
+/* EVEX.512.W0 with zmm operands: reg and rm as in ModRM, vvvv the extra source */
+static void
+EmitEvex(std::vector<uint8_t> &code, uint8_t map, uint8_t pp, uint8_t opcode, unsigned reg,
+         unsigned vvvv, unsigned rm) {
+    code.push_back(0x62);
+    code.push_back((~reg & 8) << 4 | (~rm & 16) << 2 | (~rm & 8) << 2 | (~reg & 16) | map);
+    code.push_back((~vvvv & 15) << 3 | 0x04 | pp);
+    code.push_back(0x40 | (~vvvv & 16) >> 1);
+    code.push_back(opcode);
+    code.push_back(0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+/* EVEX.512.W0 with a [base + disp32] memory operand, base must not be rsp or r12 */
+static void
+EmitEvexMem(std::vector<uint8_t> &code, uint8_t map, uint8_t pp, uint8_t opcode, unsigned reg,
+            unsigned base, uint32_t disp) {
+    code.push_back(0x62);
+    code.push_back((~reg & 8) << 4 | 0x40 | (~base & 8) << 2 | (~reg & 16) | map);
+    code.push_back(0x78 | 0x04 | pp);
+    code.push_back(0x48);
+    code.push_back(opcode);
+    code.push_back(0x80 | (reg & 7) << 3 | (base & 7));
+    Emit32(code, disp);
+}
+
+/* Three byte VEX.128.W0 in map 0F38, tile registers need no extension bits */
+static void
+EmitVexTile(std::vector<uint8_t> &code, uint8_t pp, uint8_t opcode, unsigned reg, unsigned vvvv,
+            unsigned rm) {
+    code.push_back(0xC4);
+    code.push_back(0xE0 | MAP_0F38);
+    code.push_back((~vvvv & 15) << 3 | pp);
+    code.push_back(opcode);
+    code.push_back(0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+/* vfmadd231ps zmm, zmm30, zmm31 */
+static void
+EmitFma(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitEvex(code, MAP_0F38, PP_66, 0xB8, slot.Reg, OPERAND_A, OPERAND_B);
+}
+
+/* vaddps zmm, zmm, zmm31 */
+static void
+EmitAdd(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitEvex(code, MAP_0F, PP_NONE, 0x58, slot.Reg, slot.Reg, OPERAND_B);
+}
+
+/* vmulps zmm, zmm, zmm31 */
+static void
+EmitMul(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitEvex(code, MAP_0F, PP_NONE, 0x59, slot.Reg, slot.Reg, OPERAND_B);
+}
+
+/* vpdpbusd zmm, zmm30, zmm31 */
+static void
+EmitVnni(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitEvex(code, MAP_0F38, PP_66, 0x50, slot.Reg, OPERAND_A, OPERAND_B);
+}
+
+/* vmovups zmm, [rax + offset] */
+static void
+EmitLoad(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitEvexMem(code, MAP_0F, PP_NONE, 0x10, slot.Reg, GPR_RAX, slot.Offset);
+}
+
+/* vmovups [rax + offset], zmm30 */
+static void
+EmitStore(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitEvexMem(code, MAP_0F, PP_NONE, 0x11, OPERAND_A, GPR_RAX, slot.Offset);
+}
+
+/* add r64, 1 */
+static void
+EmitAlu(std::vector<uint8_t> &code, const JitSlot &slot) {
+    code.push_back(0x48 | (slot.Reg >> 3));
+    code.push_back(0x83);
+    code.push_back(0xC0 | (slot.Reg & 7));
+    code.push_back(0x01);
+}
+
+/* tdpbssd tmm, tmm4, tmm5 */
+static void
+EmitAmxS8(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVexTile(code, PP_F2, 0x5E, slot.Reg, TILE_B, TILE_A);
+}
+
+/* tdpbf16ps tmm, tmm4, tmm5 */
+static void
+EmitAmxBF16(std::vector<uint8_t> &code, const JitSlot &slot) {
+    EmitVexTile(code, PP_F3, 0x5C, slot.Reg, TILE_B, TILE_A);
+}
+
+static void
+EmitLoop(std::vector<uint8_t> &code, const std::vector<JitSlot> &body) {
+    /* vmovups zmm30, [rcx]; vmovups zmm31, [rcx + 64] */
+    EmitEvexMem(code, MAP_0F, PP_NONE, 0x10, OPERAND_A, GPR_RCX, 0);
+    EmitEvexMem(code, MAP_0F, PP_NONE, 0x10, OPERAND_B, GPR_RCX, 64);
+
+    /* Every accumulator starts at zero: vpxord zmm, zmm, zmm and xor r32, r32 */
+    for (unsigned reg : jit_target.Registers[JIT_VECTOR]) {
+        EmitEvex(code, MAP_0F, PP_66, 0xEF, reg, reg, reg);
+    }
+    for (unsigned reg : jit_target.Registers[JIT_GPR]) {
+        if (reg >= 8) {
+            code.push_back(0x45);
+        }
+        code.push_back(0x31);
+        code.push_back(0xC0 | (reg & 7) << 3 | (reg & 7));
+    }
+
+    /* mov rax, rsi */
+    code.insert(code.end(), {0x48, 0x89, 0xF0});
+
+    /* Loop entry on its own cache line */
+    while (code.size() % 64 != 0) {
+        code.push_back(0x90);
+    }
+    size_t loop = code.size();
+
+    for (const JitSlot &slot : body) {
+        slot.Op->Emit(code, slot);
+    }
+
+    /* add rax, r9; cmp rax, rdx; cmovae rax, rsi; dec rdi; jnz loop */
+    code.insert(code.end(), {0x4C, 0x01, 0xC8});
+    code.insert(code.end(), {0x48, 0x39, 0xD0});
+    code.insert(code.end(), {0x48, 0x0F, 0x43, 0xC6});
+    code.insert(code.end(), {0x48, 0xFF, 0xCF});
+    code.insert(code.end(), {0x0F, 0x85});
+    Emit32(code, (uint32_t) (loop - (code.size() + 4)));
+
+    /* vmovups [r8], zmm0; vzeroupper; ret */
+    EmitEvexMem(code, MAP_0F, PP_NONE, 0x11, 0, GPR_R8, 0);
+    code.insert(code.end(), {0xC5, 0xF8, 0x77});
+    code.push_back(0xC3);
+}
+
+static bool
+UsesTiles(const std::vector<JitSlot> &body) {
+    for (const JitSlot &slot : body) {
+        if (slot.Op->Class == JIT_TILE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void
+EnterLoop(const std::vector<JitSlot> &body) {
+#if defined(__AMX_TILE__)
+    if (!UsesTiles(body)) {
+        return;
+    }
+
+    /* Accumulators tmm0 - tmm3 start at zero, tmm4 and tmm5 are bf16 ones */
+    tile_config_t tile_info{};
+    tile_info.paletteId = 1;
+    tile_info.cols[0] = 64;
+    tile_info.rows[0] = 16;
+    tile_info.cols[1] = 64;
+    tile_info.rows[1] = 16;
+    tile_info.cols[2] = 64;
+    tile_info.rows[2] = 16;
+    tile_info.cols[3] = 64;
+    tile_info.rows[3] = 16;
+    tile_info.cols[4] = 64;
+    tile_info.rows[4] = 16;
+    tile_info.cols[5] = 64;
+    tile_info.rows[5] = 16;
+
+    /* Some compilers only see the first bytes of the config being read by ldtilecfg */
+    __asm__ volatile("" : : "r"(&tile_info) : "memory");
+    _tile_loadconfig(&tile_info);
+
+    uint16_t ones[512];
+    std::fill(std::begin(ones), std::end(ones), 0x3F80);
+    _tile_loadd(TILE_A, ones, 64);
+    _tile_loadd(TILE_B, ones, 64);
+#endif
+}
+
+static void
+ExitLoop(const std::vector<JitSlot> &body) {
+#if defined(__AMX_TILE__)
+    if (UsesTiles(body)) {
+        _tile_release();
+    }
+#endif
+}
+
+const JitTarget jit_target = {
+    {
+        {"fma", JIT_VECTOR, JIT_MEM_NONE, Avx512Support, EmitFma},
+        {"add", JIT_VECTOR, JIT_MEM_NONE, Avx512Support, EmitAdd},
+        {"mul", JIT_VECTOR, JIT_MEM_NONE, Avx512Support, EmitMul},
+        {"vnni", JIT_VECTOR, JIT_MEM_NONE, VnniSupport, EmitVnni},
+        {"load", JIT_VECTOR, JIT_MEM_LOAD, Avx512Support, EmitLoad},
+        {"store", JIT_VECTOR, JIT_MEM_STORE, Avx512Support, EmitStore},
+        {"alu", JIT_GPR, JIT_MEM_NONE, BaseSupport, EmitAlu},
+        {"amx_s8", JIT_TILE, JIT_MEM_NONE, AmxS8Support, EmitAmxS8},
+        {"amx_bf16", JIT_TILE, JIT_MEM_NONE, AmxBF16Support, EmitAmxBF16},
+    },
+    {
+        {0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14,
+         15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29},
+        {0, 1, 2, 3},
+        {GPR_RCX, GPR_R10, GPR_R11},
+    },
+    0x7FFFFFC0,
+    EmitLoop,
+    EnterLoop,
+    ExitLoop,
+};
@@ -0,0 +1,99 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/* Polynomial error bound, relative above 1 and absolute below */
+#define MATH_TOLERANCE 1e-5
+#define MATH_STREAM    2
+
+void
+MathInput(float *input, unsigned count, bool positive) {
+    /* Multiples of 1/64, in [-8, 8] or in (0, 16] for log and rsqrt */
+    for (unsigned i = 0; i < count; i++) {
+        int32_t value = positive ? SeededValue(MATH_STREAM, i, 1, 1024)
+                                 : SeededValue(MATH_STREAM, i, -512, 512);
+        input[i] = value / 64.0f;
+    }
+}
+
+static int32_t
+VerifyMathOutput(const Result &result, const std::vector<double> &expected) {
+    for (size_t i = 0; i < expected.size(); i++) {
+        float value;
+        std::memcpy(&value, result.Output + i * sizeof(float), sizeof(value));
+
+        double limit = MATH_TOLERANCE * std::max(1.0, std::fabs(expected[i]));
+        if (!(std::fabs(value - expected[i]) <= limit)) {
+            return VERIFY_MISMATCH;
+        }
+    }
+    return VERIFY_MATCH;
+}
+
+template <typename Function>
+static int32_t
+VerifyElementwise(uint64_t steps, const Result &result, bool positive, Function reference) {
+    if (steps == 0) {
+        return VERIFY_UNCHECKED;
+    }
+
+    float input[MATH_CHECKED];
+    MathInput(input, MATH_CHECKED, positive);
+
+    std::vector<double> expected(MATH_CHECKED);
+    for (unsigned i = 0; i < MATH_CHECKED; i++) {
+        expected[i] = reference((double) input[i]);
+    }
+    return VerifyMathOutput(result, expected);
+}
+
+int32_t
+VerifyExp(uint64_t steps, const Result &result) {
+    return VerifyElementwise(steps, result, false, [](double x) { return std::exp(x); });
+}
+
+int32_t
+VerifyLog(uint64_t steps, const Result &result) {
+    return VerifyElementwise(steps, result, true, [](double x) { return std::log(x); });
+}
+
+int32_t
+VerifyTanh(uint64_t steps, const Result &result) {
+    return VerifyElementwise(steps, result, false, [](double x) { return std::tanh(x); });
+}
+
+int32_t
+VerifySigmoid(uint64_t steps, const Result &result) {
+    return VerifyElementwise(steps, result, false,
+                             [](double x) { return 1.0 / (1.0 + std::exp(-x)); });
+}
+
+int32_t
+VerifyRsqrt(uint64_t steps, const Result &result) {
+    return VerifyElementwise(steps, result, true, [](double x) { return 1.0 / std::sqrt(x); });
+}
+
+int32_t
+VerifySoftmax(uint64_t steps, const Result &result) {
+    if (steps == 0) {
+        return VERIFY_UNCHECKED;
+    }
+
+    /* The checked outputs are exactly the first row */
+    float input[MATH_ROW];
+    MathInput(input, MATH_ROW, false);
+
+    double max = *std::max_element(input, input + MATH_ROW);
+    double sum = 0;
+    std::vector<double> expected(MATH_ROW);
+    for (unsigned i = 0; i < MATH_ROW; i++) {
+        expected[i] = std::exp(input[i] - max);
+        sum += expected[i];
+    }
+    for (double &value : expected) {
+        value /= sum;
+    }
+    return VerifyMathOutput(result, expected);
+}
@@ -0,0 +1,316 @@
+#include "vm_ops_mem.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include <arm_neon.h>
+#include <stdint.h>
+
+#include "vmopsmem_export.h"
+
+/* VECTOR MATH */
+#define EXP_F32_SUPPORT     1
+#define LOG_F32_SUPPORT     1
+#define TANH_F32_SUPPORT    1
+#define SIGMOID_F32_SUPPORT 1
+#define RSQRT_F32_SUPPORT   1
+#define SOFTMAX_F32_SUPPORT 1
+
+/* Cephes single precision constants, ln(2) split in an exact and a small part */
+#define EXP_HI  88.0f /* keeps 2^n inside the exponent field */
+#define EXP_LO  -87.3365447504019f
+#define LOG2E   1.44269504088896341f
+#define LN2_HI  0.693359375f
+#define LN2_LO  -2.12194440e-4f
+#define SQRT_HF 0.707106781186547524f
+
+static inline float32x4_t
+Exp(float32x4_t x) {
+    x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(EXP_LO)), vdupq_n_f32(EXP_HI));
+
+    /* x = n * ln(2) + r with |r| <= ln(2) / 2 */
+    float32x4_t n = vrndnq_f32(vmulq_f32(x, vdupq_n_f32(LOG2E)));
+    float32x4_t r = vfmsq_f32(x, n, vdupq_n_f32(LN2_HI));
+    r = vfmsq_f32(r, n, vdupq_n_f32(LN2_LO));
+
+    float32x4_t p = vdupq_n_f32(1.9875691500e-4f);
+    p = vfmaq_f32(vdupq_n_f32(1.3981999507e-3f), p, r);
+    p = vfmaq_f32(vdupq_n_f32(8.3334519073e-3f), p, r);
+    p = vfmaq_f32(vdupq_n_f32(4.1665795894e-2f), p, r);
+    p = vfmaq_f32(vdupq_n_f32(1.6666665459e-1f), p, r);
+    p = vfmaq_f32(vdupq_n_f32(5.0000001201e-1f), p, r);
+    p = vfmaq_f32(r, p, vmulq_f32(r, r));
+    p = vaddq_f32(p, vdupq_n_f32(1.0f));
+
+    /* 2^n assembled in the exponent field */
+    int32x4_t scale = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+    return vmulq_f32(p, vreinterpretq_f32_s32(scale));
+}
+
+static inline float32x4_t
+Log(float32x4_t x) {
+    /* x = 2^e * m with m in [sqrt(1/2), sqrt(2)), inputs are positive */
+    float32x4_t one = vdupq_n_f32(1.0f);
+    int32x4_t bits = vreinterpretq_s32_f32(x);
+    float32x4_t e = vcvtq_f32_s32(vsubq_s32(vshrq_n_s32(bits, 23), vdupq_n_s32(126)));
+    float32x4_t m = vreinterpretq_f32_s32(
+        vorrq_s32(vandq_s32(bits, vdupq_n_s32(0x007FFFFF)), vdupq_n_s32(0x3F000000)));
+
+    uint32x4_t small = vcltq_f32(m, vdupq_n_f32(SQRT_HF));
+    e = vsubq_f32(e, vreinterpretq_f32_u32(vandq_u32(small, vreinterpretq_u32_f32(one))));
+    m = vaddq_f32(m, vreinterpretq_f32_u32(vandq_u32(small, vreinterpretq_u32_f32(m))));
+    float32x4_t f = vsubq_f32(m, one);
+
+    float32x4_t p = vdupq_n_f32(7.0376836292e-2f);
+    p = vfmaq_f32(vdupq_n_f32(-1.1514610310e-1f), p, f);
+    p = vfmaq_f32(vdupq_n_f32(1.1676998740e-1f), p, f);
+    p = vfmaq_f32(vdupq_n_f32(-1.2420140846e-1f), p, f);
+    p = vfmaq_f32(vdupq_n_f32(1.4249322787e-1f), p, f);
+    p = vfmaq_f32(vdupq_n_f32(-1.6668057665e-1f), p, f);
+    p = vfmaq_f32(vdupq_n_f32(2.0000714765e-1f), p, f);
+    p = vfmaq_f32(vdupq_n_f32(-2.4999993993e-1f), p, f);
+    p = vfmaq_f32(vdupq_n_f32(3.3333331174e-1f), p, f);
+
+    float32x4_t z = vmulq_f32(f, f);
+    float32x4_t y = vmulq_f32(vmulq_f32(p, f), z);
+    y = vfmaq_f32(y, e, vdupq_n_f32(LN2_LO));
+    y = vfmsq_f32(y, z, vdupq_n_f32(0.5f));
+
+    return vfmaq_f32(vaddq_f32(f, y), e, vdupq_n_f32(LN2_HI));
+}
+
+static inline float32x4_t
+Tanh(float32x4_t x) {
+    /* (e^2x - 1) / (e^2x + 1) */
+    float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t e = Exp(vaddq_f32(x, x));
+    return vdivq_f32(vsubq_f32(e, one), vaddq_f32(e, one));
+}
+
+static inline float32x4_t
+Sigmoid(float32x4_t x) {
+    float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t e = Exp(vnegq_f32(x));
+    return vdivq_f32(one, vaddq_f32(e, one));
+}
+
+static inline float32x4_t
+Rsqrt(float32x4_t x) {
+    /* Two Newton steps take the 8 bit estimate to full precision */
+    float32x4_t y = vrsqrteq_f32(x);
+    y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+    y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+    return y;
+}
+
+static void
+SoftmaxRow(const float *input, float *output) {
+    float32x4_t max = vdupq_n_f32(-INFINITY);
+    for (unsigned i = 0; i < MATH_ROW; i += 4) {
+        max = vmaxq_f32(max, vld1q_f32(input + i));
+    }
+    max = vdupq_n_f32(vmaxvq_f32(max));
+
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (unsigned i = 0; i < MATH_ROW; i += 4) {
+        float32x4_t e = Exp(vsubq_f32(vld1q_f32(input + i), max));
+        vst1q_f32(output + i, e);
+        sum = vaddq_f32(sum, e);
+    }
+
+    float32x4_t scale = vdupq_n_f32(1.0f / vaddvq_f32(sum));
+    for (unsigned i = 0; i < MATH_ROW; i += 4) {
+        vst1q_f32(output + i, vmulq_f32(vld1q_f32(output + i), scale));
+    }
+}
+
+template <typename Function>
+static Result
+MapBlock(uint64_t steps, bool positive, Function function) {
+    alignas(64) float input[MATH_BLOCK];
+    alignas(64) float output[MATH_BLOCK] = {};
+    MathInput(input, MATH_BLOCK, positive);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
+        for (; k < block; k++) {
+            for (unsigned i = 0; i < MATH_BLOCK; i += 16) {
+                vst1q_f32(output + i + 0, function(vld1q_f32(input + i + 0)));
+                vst1q_f32(output + i + 4, function(vld1q_f32(input + i + 4)));
+                vst1q_f32(output + i + 8, function(vld1q_f32(input + i + 8)));
+                vst1q_f32(output + i + 12, function(vld1q_f32(input + i + 12)));
+            }
+            /* Every step recomputes the same block, keep it from being hoisted */
+            __asm__ volatile("" : : "r"(output) : "memory");
+        }
+    }
+    steps = k;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps * MATH_BLOCK /* elements */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, output, MATH_CHECKED * sizeof(float));
+    return r;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+exp_f32_support() {
+#if EXP_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+log_f32_support() {
+#if LOG_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+tanh_f32_support() {
+#if TANH_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+sigmoid_f32_support() {
+#if SIGMOID_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+rsqrt_f32_support() {
+#if RSQRT_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+softmax_f32_support() {
+#if SOFTMAX_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+#if EXP_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+exp_f32(uint64_t steps) {
+    return MapBlock(steps, false, Exp);
+}
+#endif
+
+#if LOG_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+log_f32(uint64_t steps) {
+    return MapBlock(steps, true, Log);
+}
+#endif
+
+#if TANH_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+tanh_f32(uint64_t steps) {
+    return MapBlock(steps, false, Tanh);
+}
+#endif
+
+#if SIGMOID_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+sigmoid_f32(uint64_t steps) {
+    return MapBlock(steps, false, Sigmoid);
+}
+#endif
+
+#if RSQRT_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+rsqrt_f32(uint64_t steps) {
+    return MapBlock(steps, true, Rsqrt);
+}
+#endif
+
+#if SOFTMAX_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+softmax_f32(uint64_t steps) {
+    alignas(64) float input[MATH_BLOCK];
+    alignas(64) float output[MATH_BLOCK] = {};
+    MathInput(input, MATH_BLOCK, false);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
+        for (; k < block; k++) {
+            for (unsigned i = 0; i < MATH_BLOCK; i += MATH_ROW) {
+                SoftmaxRow(input + i, output + i);
+            }
+            __asm__ volatile("" : : "r"(output) : "memory");
+        }
+    }
+    steps = k;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps * MATH_BLOCK /* elements */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, output, MATH_CHECKED * sizeof(float));
+    return r;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterMathKernels(std::vector<Kernel> &registry) {
+#if EXP_F32_SUPPORT
+    registry.push_back({"exp_f32", "elems", exp_f32_support,
+                        [](const KernelParams &p) { return exp_f32(p.Steps); }, VerifyExp, 0,
+                        18 /* 2 clamp + 3 mul + round + 8 fma + cvt + 2 add + shl */});
+#endif
+#if LOG_F32_SUPPORT
+    registry.push_back({"log_f32", "elems", log_f32_support,
+                        [](const KernelParams &p) { return log_f32(p.Steps); }, VerifyLog, 0,
+                        26 /* 6 integer + cmp + cvt + 4 add + 11 fma + 3 mul */});
+#endif
+#if TANH_F32_SUPPORT
+    registry.push_back({"tanh_f32", "elems", tanh_f32_support,
+                        [](const KernelParams &p) { return tanh_f32(p.Steps); }, VerifyTanh, 0,
+                        22 /* add + exp + sub + add + div */});
+#endif
+#if SIGMOID_F32_SUPPORT
+    registry.push_back({"sigmoid_f32", "elems", sigmoid_f32_support,
+                        [](const KernelParams &p) { return sigmoid_f32(p.Steps); },
+                        VerifySigmoid, 0, 21 /* neg + exp + add + div */});
+#endif
+#if RSQRT_F32_SUPPORT
+    registry.push_back({"rsqrt_f32", "elems", rsqrt_f32_support,
+                        [](const KernelParams &p) { return rsqrt_f32(p.Steps); }, VerifyRsqrt, 0,
+                        7 /* rsqrte + 2 x (2 mul + rsqrts) */});
+#endif
+#if SOFTMAX_F32_SUPPORT
+    registry.push_back({"softmax_f32", "elems", softmax_f32_support,
+                        [](const KernelParams &p) { return softmax_f32(p.Steps); },
+                        VerifySoftmax, 0, 22 /* max + sub + exp + add + mul */});
+#endif
+}
@@ -0,0 +1,322 @@
+#include "vm_ops_mem.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include "vmopsmem_export.h"
+
+#if defined(__AVX512F__)
+#define EXP_F32_SUPPORT     1
+#define LOG_F32_SUPPORT     1
+#define TANH_F32_SUPPORT    1
+#define SIGMOID_F32_SUPPORT 1
+#define RSQRT_F32_SUPPORT   1
+#define SOFTMAX_F32_SUPPORT 1
+#else
+#define EXP_F32_SUPPORT     0
+#define LOG_F32_SUPPORT     0
+#define TANH_F32_SUPPORT    0
+#define SIGMOID_F32_SUPPORT 0
+#define RSQRT_F32_SUPPORT   0
+#define SOFTMAX_F32_SUPPORT 0
+#endif
+
+/* Cephes single precision constants, ln(2) split in an exact and a small part */
+#define EXP_HI   88.3762626647949f
+#define EXP_LO   -87.3365447504019f
+#define LOG2E    1.44269504088896341f
+#define LN2_HI   0.693359375f
+#define LN2_LO   -2.12194440e-4f
+#define SQRT_HF  0.707106781186547524f
+
+#if defined(__AVX512F__)
+static inline __m512
+Exp(__m512 x) {
+    x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(EXP_LO)), _mm512_set1_ps(EXP_HI));
+
+    /* x = n * ln(2) + r with |r| <= ln(2) / 2 */
+    __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(LOG2E)),
+                                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(LN2_HI), x);
+    r = _mm512_fnmadd_ps(n, _mm512_set1_ps(LN2_LO), r);
+
+    __m512 p = _mm512_set1_ps(1.9875691500e-4f);
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.3981999507e-3f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(8.3334519073e-3f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(4.1665795894e-2f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.6666665459e-1f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(5.0000001201e-1f));
+    p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), r);
+    p = _mm512_add_ps(p, _mm512_set1_ps(1.0f));
+
+    return _mm512_scalef_ps(p, n);
+}
+
+static inline __m512
+Log(__m512 x) {
+    /* x = 2^e * m with m in [sqrt(1/2), sqrt(2)) */
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 e = _mm512_add_ps(_mm512_getexp_ps(x), one);
+    __m512 m = _mm512_getmant_ps(x, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_src);
+    __mmask16 small = _mm512_cmp_ps_mask(m, _mm512_set1_ps(SQRT_HF), _CMP_LT_OQ);
+    m = _mm512_mask_add_ps(m, small, m, m);
+    e = _mm512_mask_sub_ps(e, small, e, one);
+    __m512 f = _mm512_sub_ps(m, one);
+
+    __m512 p = _mm512_set1_ps(7.0376836292e-2f);
+    p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(-1.1514610310e-1f));
+    p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(1.1676998740e-1f));
+    p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(-1.2420140846e-1f));
+    p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(1.4249322787e-1f));
+    p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(-1.6668057665e-1f));
+    p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(2.0000714765e-1f));
+    p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(-2.4999993993e-1f));
+    p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(3.3333331174e-1f));
+
+    __m512 z = _mm512_mul_ps(f, f);
+    __m512 y = _mm512_mul_ps(_mm512_mul_ps(p, f), z);
+    y = _mm512_fmadd_ps(e, _mm512_set1_ps(LN2_LO), y);
+    y = _mm512_fmadd_ps(_mm512_set1_ps(-0.5f), z, y);
+
+    return _mm512_fmadd_ps(e, _mm512_set1_ps(LN2_HI), _mm512_add_ps(f, y));
+}
+
+static inline __m512
+Tanh(__m512 x) {
+    /* (e^2x - 1) / (e^2x + 1) */
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 e = Exp(_mm512_add_ps(x, x));
+    return _mm512_div_ps(_mm512_sub_ps(e, one), _mm512_add_ps(e, one));
+}
+
+static inline __m512
+Sigmoid(__m512 x) {
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 e = Exp(_mm512_sub_ps(_mm512_setzero_ps(), x));
+    return _mm512_div_ps(one, _mm512_add_ps(e, one));
+}
+
+static inline __m512
+Rsqrt(__m512 x) {
+    /* One Newton step takes the 14 bit estimate to full precision */
+    __m512 y = _mm512_rsqrt14_ps(x);
+    __m512 t = _mm512_mul_ps(_mm512_mul_ps(x, _mm512_set1_ps(0.5f)), _mm512_mul_ps(y, y));
+    return _mm512_mul_ps(y, _mm512_sub_ps(_mm512_set1_ps(1.5f), t));
+}
+
+static void
+SoftmaxRow(const float *input, float *output) {
+    __m512 max = _mm512_set1_ps(-INFINITY);
+    for (unsigned i = 0; i < MATH_ROW; i += 16) {
+        max = _mm512_max_ps(max, _mm512_load_ps(input + i));
+    }
+    max = _mm512_set1_ps(_mm512_reduce_max_ps(max));
+
+    __m512 sum = _mm512_setzero_ps();
+    for (unsigned i = 0; i < MATH_ROW; i += 16) {
+        __m512 e = Exp(_mm512_sub_ps(_mm512_load_ps(input + i), max));
+        _mm512_store_ps(output + i, e);
+        sum = _mm512_add_ps(sum, e);
+    }
+
+    __m512 scale = _mm512_set1_ps(1.0f / _mm512_reduce_add_ps(sum));
+    for (unsigned i = 0; i < MATH_ROW; i += 16) {
+        _mm512_store_ps(output + i, _mm512_mul_ps(_mm512_load_ps(output + i), scale));
+    }
+}
+
+template <typename Function>
+static Result
+MapBlock(uint64_t steps, bool positive, Function function) {
+    alignas(64) float input[MATH_BLOCK];
+    alignas(64) float output[MATH_BLOCK] = {};
+    MathInput(input, MATH_BLOCK, positive);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
+        for (; k < block; k++) {
+            for (unsigned i = 0; i < MATH_BLOCK; i += 64) {
+                _mm512_store_ps(output + i + 0, function(_mm512_load_ps(input + i + 0)));
+                _mm512_store_ps(output + i + 16, function(_mm512_load_ps(input + i + 16)));
+                _mm512_store_ps(output + i + 32, function(_mm512_load_ps(input + i + 32)));
+                _mm512_store_ps(output + i + 48, function(_mm512_load_ps(input + i + 48)));
+            }
+            /* Every step recomputes the same block, keep it from being hoisted */
+            __asm__ volatile("" : : "r"(output) : "memory");
+        }
+    }
+    steps = k;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps * MATH_BLOCK /* elements */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, output, MATH_CHECKED * sizeof(float));
+    return r;
+}
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* VECTOR MATH */
+VMOPSMEM_EXPORT int32_t
+exp_f32_support() {
+#if EXP_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+log_f32_support() {
+#if LOG_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+tanh_f32_support() {
+#if TANH_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+sigmoid_f32_support() {
+#if SIGMOID_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+rsqrt_f32_support() {
+#if RSQRT_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+softmax_f32_support() {
+#if SOFTMAX_F32_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+#if EXP_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+exp_f32(uint64_t steps) {
+    return MapBlock(steps, false, Exp);
+}
+#endif
+
+#if LOG_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+log_f32(uint64_t steps) {
+    return MapBlock(steps, true, Log);
+}
+#endif
+
+#if TANH_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+tanh_f32(uint64_t steps) {
+    return MapBlock(steps, false, Tanh);
+}
+#endif
+
+#if SIGMOID_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+sigmoid_f32(uint64_t steps) {
+    return MapBlock(steps, false, Sigmoid);
+}
+#endif
+
+#if RSQRT_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+rsqrt_f32(uint64_t steps) {
+    return MapBlock(steps, true, Rsqrt);
+}
+#endif
+
+#if SOFTMAX_F32_SUPPORT
+VMOPSMEM_EXPORT Result
+softmax_f32(uint64_t steps) {
+    alignas(64) float input[MATH_BLOCK];
+    alignas(64) float output[MATH_BLOCK] = {};
+    MathInput(input, MATH_BLOCK, false);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
+        for (; k < block; k++) {
+            for (unsigned i = 0; i < MATH_BLOCK; i += MATH_ROW) {
+                SoftmaxRow(input + i, output + i);
+            }
+            __asm__ volatile("" : : "r"(output) : "memory");
+        }
+    }
+    steps = k;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps * MATH_BLOCK /* elements */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, output, MATH_CHECKED * sizeof(float));
+    return r;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterMathKernels(std::vector<Kernel> &registry) {
+#if EXP_F32_SUPPORT
+    registry.push_back({"exp_f32", "elems", exp_f32_support,
+                        [](const KernelParams &p) { return exp_f32(p.Steps); }, VerifyExp, 0,
+                        15 /* 2 clamp + 2 mul + round + 8 fma + add + scalef */});
+#endif
+#if LOG_F32_SUPPORT
+    registry.push_back({"log_f32", "elems", log_f32_support,
+                        [](const KernelParams &p) { return log_f32(p.Steps); }, VerifyLog, 0,
+                        22 /* getexp + getmant + cmp + 5 add + 11 fma + 3 mul */});
+#endif
+#if TANH_F32_SUPPORT
+    registry.push_back({"tanh_f32", "elems", tanh_f32_support,
+                        [](const KernelParams &p) { return tanh_f32(p.Steps); }, VerifyTanh, 0,
+                        19 /* add + exp + sub + add + div */});
+#endif
+#if SIGMOID_F32_SUPPORT
+    registry.push_back({"sigmoid_f32", "elems", sigmoid_f32_support,
+                        [](const KernelParams &p) { return sigmoid_f32(p.Steps); },
+                        VerifySigmoid, 0, 18 /* sub + exp + add + div */});
+#endif
+#if RSQRT_F32_SUPPORT
+    registry.push_back({"rsqrt_f32", "elems", rsqrt_f32_support,
+                        [](const KernelParams &p) { return rsqrt_f32(p.Steps); }, VerifyRsqrt, 0,
+                        6 /* rsqrt14 + 4 mul + sub */});
+#endif
+#if SOFTMAX_F32_SUPPORT
+    registry.push_back({"softmax_f32", "elems", softmax_f32_support,
+                        [](const KernelParams &p) { return softmax_f32(p.Steps); },
+                        VerifySoftmax, 0, 19 /* max + sub + exp + add + mul */});
+#endif
+}
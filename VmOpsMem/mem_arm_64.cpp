@@ -0,0 +1,592 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <arm_neon.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "vmopsmem_export.h"
+
+#define CACHE_LINE_SIZE 64
+
+/* MEMORY BANDWIDTH */
+#define MEM_LOAD_SUPPORT     1
+#define MEM_STORE_SUPPORT    1
+#define MEM_STORE_NT_SUPPORT 1
+#define MEM_RMW_SUPPORT      1
+#define MEM_TRIAD_SUPPORT    1
+#define MEM_GATHER_SUPPORT   1
+#define MEM_SCATTER_SUPPORT  1
+
+/* STRIDED WALK */
+#define MEM_STRIDE_SUPPORT 1
+
+static uint64_t
+DataCacheLineSize() {
+    uint64_t ctr;
+    __asm__ volatile("mrs	%[ctr], ctr_el0" : [ctr] "=r"(ctr));
+
+    /* CTR_EL0.DminLine is log2 of the number of 4 byte words */
+    return 4ull << ((ctr >> 16) & 0xF);
+}
+
+uint8_t *
+AllocBuffer(uint64_t &bytes, unsigned slot, uint64_t contents) {
+    /* Whole number of 4 x 64B lines so the unrolled loops need no tail */
+    bytes = (bytes + 4 * CACHE_LINE_SIZE - 1) & ~(uint64_t) (4 * CACHE_LINE_SIZE - 1);
+
+    bool fresh;
+    return SlotBuffer(slot, bytes, contents, fresh);
+}
+
+void
+FlushBuffer(const uint8_t *buffer, uint64_t bytes) {
+    uint64_t lineSize = DataCacheLineSize();
+    for (uint64_t i = 0; i < bytes; i += lineSize) {
+        __asm__ volatile("dc	civac, %[addr]" : : [addr] "r"(buffer + i) : "memory");
+    }
+    __asm__ volatile("dsb	ish" : : : "memory");
+}
+
+static inline uint64_t
+WalkOffset(uint64_t i, uint64_t count, uint64_t stride, int32_t walk, const uint32_t *pages) {
+    if (walk == WALK_BACKWARD) {
+        return (count - 1 - i) * stride;
+    }
+
+    uint64_t offset = i * stride;
+    if (walk == WALK_PAGES) {
+        return (uint64_t) pages[offset / WALK_PAGE_SIZE] * WALK_PAGE_SIZE +
+               offset % WALK_PAGE_SIZE;
+    }
+    return offset;
+}
+
+/* The latency walk adds every loaded value (all zero) into the next address */
+template <bool Dependent>
+static uint64_t
+StrideWalk(const uint8_t *buffer, uint64_t count, uint64_t stride, int32_t walk,
+           uint64_t prefetch, const uint32_t *pages, uint64_t sum) {
+    for (uint64_t i = 0; i < count; i++) {
+        if (prefetch != 0) {
+            /* Past the end the prefetches run into the start of the next pass */
+            uint64_t ahead = i + prefetch < count ? i + prefetch : i + prefetch - count;
+            const uint8_t *line = buffer + WalkOffset(ahead, count, stride, walk, pages);
+            __asm__ volatile("prfm	pldl1keep, [%[addr]]" : : [addr] "r"(line));
+        }
+
+        uint64_t offset = WalkOffset(i, count, stride, walk, pages) + (Dependent ? sum : 0);
+        sum += *(const uint64_t *) (buffer + offset);
+
+        /* One scalar load per access, the compiler may not vectorize the walk */
+        __asm__ volatile("" : "+r"(sum));
+    }
+    return sum;
+}
+
+template <bool Dependent>
+static Result
+StrideKernel(uint64_t bytes, uint64_t steps, int32_t flush, int32_t walk, int32_t stride,
+             int32_t prefetch) {
+    /* Whole pages, every access is an aligned 8 byte load */
+    bytes = std::max<uint64_t>((bytes + WALK_PAGE_SIZE - 1) & ~(uint64_t) (WALK_PAGE_SIZE - 1),
+                               WALK_PAGE_SIZE);
+    uint64_t step = stride > 0 ? stride & ~(int32_t) (sizeof(uint64_t) - 1) : CACHE_LINE_SIZE;
+    step = std::clamp<uint64_t>(step, sizeof(uint64_t), bytes);
+
+    bool fresh;
+    uint8_t *buffer = SlotBuffer(0, bytes, BUFFER_ZERO, fresh);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    static thread_local std::vector<uint32_t> pages;
+    if (pages.size() != bytes / WALK_PAGE_SIZE) {
+        pages = BuildPageOrder(bytes / WALK_PAGE_SIZE);
+    }
+    uint64_t count = bytes / step;
+    uint64_t ahead = std::max(prefetch, 0) % count;
+
+    uint64_t sum = 0;
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        sum = StrideWalk<Dependent>(buffer, count, step, walk, ahead, pages.data(), sum);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    /* Bandwidth counts the lines the walk pulls in, latency the loads */
+    uint64_t ops = steps * count * (Dependent ? 1 : std::min<uint64_t>(step, CACHE_LINE_SIZE));
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &sum, sizeof(sum));
+    return r;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+mem_load_support() {
+#if MEM_LOAD_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_store_support() {
+#if MEM_STORE_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_store_nt_support() {
+#if MEM_STORE_NT_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_rmw_support() {
+#if MEM_RMW_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_triad_support() {
+#if MEM_TRIAD_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_gather_support() {
+#if MEM_GATHER_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_scatter_support() {
+#if MEM_SCATTER_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_stride_support() {
+#if MEM_STRIDE_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+#if MEM_LOAD_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_load(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_ONES);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    uint64x2_t a = vdupq_n_u64(0);
+    uint64x2_t b = vdupq_n_u64(0);
+    uint64x2_t c = vdupq_n_u64(0);
+    uint64x2_t d = vdupq_n_u64(0);
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < bytes; i += 4 * CACHE_LINE_SIZE) {
+            for (uint64_t j = 0; j < 4 * CACHE_LINE_SIZE; j += CACHE_LINE_SIZE) {
+                uint64x2x4_t v = vld1q_u64_x4((const uint64_t *) (buffer + i + j));
+                a = vaddq_u64(a, v.val[0]);
+                b = vaddq_u64(b, v.val[1]);
+                c = vaddq_u64(c, v.val[2]);
+                d = vaddq_u64(d, v.val[3]);
+            }
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t res[2];
+    vst1q_u64(res, vaddq_u64(vaddq_u64(a, b), vaddq_u64(c, d)));
+
+    uint64_t ops = steps * bytes /* read */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, res, sizeof(res));
+    return r;
+}
+#endif
+
+#if MEM_STORE_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_store(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_FILLED);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    uint64x2x4_t v = {vdupq_n_u64(steps), vdupq_n_u64(steps), vdupq_n_u64(steps),
+                      vdupq_n_u64(steps)};
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < bytes; i += 4 * CACHE_LINE_SIZE) {
+            vst1q_u64_x4((uint64_t *) (buffer + i + 0 * CACHE_LINE_SIZE), v);
+            vst1q_u64_x4((uint64_t *) (buffer + i + 1 * CACHE_LINE_SIZE), v);
+            vst1q_u64_x4((uint64_t *) (buffer + i + 2 * CACHE_LINE_SIZE), v);
+            vst1q_u64_x4((uint64_t *) (buffer + i + 3 * CACHE_LINE_SIZE), v);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * bytes /* write */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, buffer, 64);
+    return r;
+}
+#endif
+
+#if MEM_STORE_NT_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_store_nt(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_FILLED);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    uint64x2_t a = vdupq_n_u64(steps);
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < bytes; i += CACHE_LINE_SIZE) {
+            __asm__ volatile("stnp	%q[a], %q[a], [%[addr]]"
+                             "\n\t"
+                             "stnp	%q[a], %q[a], [%[addr], #32]"
+                             :
+                             : [addr] "r"(buffer + i), [a] "w"(a)
+                             : "memory");
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * bytes /* write */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, buffer, 64);
+    return r;
+}
+#endif
+
+#if MEM_RMW_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_rmw(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_FILLED);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    uint64x2_t a = vdupq_n_u64(1);
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < bytes; i += CACHE_LINE_SIZE) {
+            uint64_t *p = (uint64_t *) (buffer + i);
+            uint64x2x4_t v = vld1q_u64_x4(p);
+            v.val[0] = vaddq_u64(v.val[0], a);
+            v.val[1] = vaddq_u64(v.val[1], a);
+            v.val[2] = vaddq_u64(v.val[2], a);
+            v.val[3] = vaddq_u64(v.val[3], a);
+            vst1q_u64_x4(p, v);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * bytes * 2 /* read + write */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, buffer, 64);
+    return r;
+}
+#endif
+
+#if MEM_TRIAD_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_triad(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint64_t arrayBytes = bytes / 3;
+    uint8_t *a = AllocBuffer(arrayBytes, 0, BUFFER_FILLED);
+    uint8_t *b = AllocBuffer(arrayBytes, 1, BUFFER_ONES);
+    uint8_t *c = AllocBuffer(arrayBytes, 2, BUFFER_ONES);
+    if (a == nullptr || b == nullptr || c == nullptr) {
+        return Result{};
+    }
+
+    float64x2_t s = vdupq_n_f64(3.0);
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(a, arrayBytes);
+            FlushBuffer(b, arrayBytes);
+            FlushBuffer(c, arrayBytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < arrayBytes; i += CACHE_LINE_SIZE) {
+            float64x2x4_t vb = vld1q_f64_x4((const double *) (b + i));
+            float64x2x4_t vc = vld1q_f64_x4((const double *) (c + i));
+            vb.val[0] = vfmaq_f64(vb.val[0], s, vc.val[0]);
+            vb.val[1] = vfmaq_f64(vb.val[1], s, vc.val[1]);
+            vb.val[2] = vfmaq_f64(vb.val[2], s, vc.val[2]);
+            vb.val[3] = vfmaq_f64(vb.val[3], s, vc.val[3]);
+            vst1q_f64_x4((double *) (a + i), vb);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * arrayBytes * 3 /* 2 x read + write */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, a, 64);
+    return r;
+}
+#endif
+
+/* RANDOM ACCESS, NEON has no gather so every lane is loaded on its own */
+#if MEM_GATHER_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_gather(uint64_t bytes, uint64_t steps, int32_t flush, int32_t pattern) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_ONES);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    const std::vector<uint32_t> &indices = GatherIndices(bytes, pattern);
+    const uint32_t *index = indices.data();
+    uint64_t count = indices.size();
+    auto table = (const uint32_t *) buffer;
+
+    uint32x4_t a = vdupq_n_u32(0);
+    uint32x4_t b = vdupq_n_u32(0);
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < count; i += 8) {
+            uint32x4_t va = vdupq_n_u32(0);
+            uint32x4_t vb = vdupq_n_u32(0);
+            va = vld1q_lane_u32(table + index[i + 0], va, 0);
+            vb = vld1q_lane_u32(table + index[i + 4], vb, 0);
+            va = vld1q_lane_u32(table + index[i + 1], va, 1);
+            vb = vld1q_lane_u32(table + index[i + 5], vb, 1);
+            va = vld1q_lane_u32(table + index[i + 2], va, 2);
+            vb = vld1q_lane_u32(table + index[i + 6], vb, 2);
+            va = vld1q_lane_u32(table + index[i + 3], va, 3);
+            vb = vld1q_lane_u32(table + index[i + 7], vb, 3);
+            a = vaddq_u32(a, va);
+            b = vaddq_u32(b, vb);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint32_t res[4];
+    vst1q_u32(res, vaddq_u32(a, b));
+
+    uint64_t ops = steps * count * sizeof(uint32_t) /* useful bytes read */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, res, sizeof(res));
+    return r;
+}
+#endif
+
+#if MEM_SCATTER_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_scatter(uint64_t bytes, uint64_t steps, int32_t flush, int32_t pattern) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_FILLED);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    const std::vector<uint32_t> &indices = GatherIndices(bytes, pattern);
+    const uint32_t *index = indices.data();
+    uint64_t count = indices.size();
+    auto table = (uint32_t *) buffer;
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        uint32x4_t a = vdupq_n_u32(k);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < count; i += 4) {
+            vst1q_lane_u32(table + index[i + 0], a, 0);
+            vst1q_lane_u32(table + index[i + 1], a, 1);
+            vst1q_lane_u32(table + index[i + 2], a, 2);
+            vst1q_lane_u32(table + index[i + 3], a, 3);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * count * sizeof(uint32_t) /* useful bytes written */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, buffer, 64);
+    return r;
+}
+#endif
+
+/* STRIDED WALK */
+#if MEM_STRIDE_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_stride(uint64_t bytes, uint64_t steps, int32_t flush, int32_t walk, int32_t stride,
+           int32_t prefetch) {
+    return StrideKernel<false>(bytes, steps, flush, walk, stride, prefetch);
+}
+
+VMOPSMEM_EXPORT Result
+mem_stride_lat(uint64_t bytes, uint64_t steps, int32_t flush, int32_t walk, int32_t stride,
+               int32_t prefetch) {
+    return StrideKernel<true>(bytes, steps, flush, walk, stride, prefetch);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterMemKernels(std::vector<Kernel> &registry) {
+#if MEM_LOAD_SUPPORT
+    registry.push_back({"mem_load", "bytes", mem_load_support,
+                        [](const KernelParams &p) {
+                            return mem_load(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_STORE_SUPPORT
+    registry.push_back({"mem_store", "bytes", mem_store_support,
+                        [](const KernelParams &p) {
+                            return mem_store(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_STORE_NT_SUPPORT
+    registry.push_back({"mem_store_nt", "bytes", mem_store_nt_support,
+                        [](const KernelParams &p) {
+                            return mem_store_nt(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_RMW_SUPPORT
+    registry.push_back({"mem_rmw", "bytes", mem_rmw_support,
+                        [](const KernelParams &p) {
+                            return mem_rmw(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_TRIAD_SUPPORT
+    registry.push_back({"mem_triad", "bytes", mem_triad_support,
+                        [](const KernelParams &p) {
+                            return mem_triad(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_GATHER_SUPPORT
+    registry.push_back({"mem_gather", "bytes", mem_gather_support,
+                        [](const KernelParams &p) {
+                            return mem_gather(p.Bytes, p.Steps, p.Flush, p.Pattern);
+                        }});
+#endif
+#if MEM_SCATTER_SUPPORT
+    registry.push_back({"mem_scatter", "bytes", mem_scatter_support,
+                        [](const KernelParams &p) {
+                            return mem_scatter(p.Bytes, p.Steps, p.Flush, p.Pattern);
+                        }});
+#endif
+#if MEM_STRIDE_SUPPORT
+    registry.push_back({"mem_stride", "bytes", mem_stride_support,
+                        [](const KernelParams &p) {
+                            return mem_stride(p.Bytes, p.Steps, p.Flush, p.Walk, p.Stride,
+                                              p.Prefetch);
+                        }});
+    registry.push_back({"mem_stride_lat", "loads", mem_stride_support,
+                        [](const KernelParams &p) {
+                            return mem_stride_lat(p.Bytes, p.Steps, p.Flush, p.Walk, p.Stride,
+                                                  p.Prefetch);
+                        }});
+#endif
+}
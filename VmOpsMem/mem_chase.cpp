@@ -0,0 +1,311 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <utility>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "vmopsmem_export.h"
+
+#define CACHE_LINE_SIZE 64
+
+/* WORKING SETS */
+struct BufferSlot {
+    uint8_t *Data = nullptr;
+    uint64_t Bytes = 0;
+    uint64_t Contents = BUFFER_FILLED;
+    uint64_t Seed = 0;
+
+    ~BufferSlot() { free(Data); }
+};
+
+static thread_local BufferSlot buffer_slots[BUFFER_SLOTS];
+
+/* Reallocated only on a new size, fresh asks the caller to fill in contents it builds itself */
+uint8_t *
+SlotBuffer(unsigned slot, uint64_t bytes, uint64_t contents, bool &fresh) {
+    BufferSlot &s = buffer_slots[slot];
+    bytes = (bytes + CACHE_LINE_SIZE - 1) & ~(uint64_t) (CACHE_LINE_SIZE - 1);
+
+    fresh = s.Data == nullptr || s.Bytes != bytes;
+    if (fresh) {
+        free(s.Data);
+        s.Data = (uint8_t *) aligned_alloc(CACHE_LINE_SIZE, bytes);
+        s.Bytes = s.Data != nullptr ? bytes : 0;
+        if (s.Data == nullptr) {
+            return nullptr;
+        }
+        std::memset(s.Data, contents == BUFFER_ZERO ? 0 : 1, bytes);
+    } else if ((contents == BUFFER_ONES || contents == BUFFER_ZERO) && s.Contents != contents) {
+        std::memset(s.Data, contents == BUFFER_ZERO ? 0 : 1, bytes);
+    } else if (contents >= BUFFER_CHAIN) {
+        /* Seeded inputs change with the seed */
+        fresh = s.Contents != contents || s.Seed != input_seed;
+    }
+
+    s.Contents = contents;
+    s.Seed = input_seed;
+    return s.Data;
+}
+
+/* POINTER CHASE */
+#define MEM_CHASE_SUPPORT 1
+
+/* Where every chain of every chain count stands, kept with the chain from one call to the next */
+static thread_local std::vector<uint8_t *> chain_heads;
+
+static inline unsigned
+HeadsBase(unsigned count) {
+    return (count - 1) * count / 2;
+}
+
+/* One cycle through every line, built once per thread and size, the heads of each chain count
+ * spread evenly along it */
+static uint8_t *
+PointerChain(uint64_t &bytes, uint8_t **&heads, unsigned count) {
+    uint64_t lines = bytes / CACHE_LINE_SIZE;
+    if (lines < 2) {
+        lines = 2;
+    }
+    bytes = lines * CACHE_LINE_SIZE;
+
+    bool fresh;
+    uint8_t *buffer = SlotBuffer(0, bytes, BUFFER_CHAIN, fresh);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+    if (fresh) {
+        /* Lines in shuffled order, each pointing to the next and the last back to the first */
+        std::vector<uint64_t> order(lines);
+        std::iota(order.begin(), order.end(), 0);
+
+        std::mt19937_64 rng(lines);
+        for (uint64_t i = lines - 1; i > 0; i--) {
+            std::uniform_int_distribution<uint64_t> pick(0, i);
+            std::swap(order[i], order[pick(rng)]);
+        }
+
+        for (uint64_t i = 0; i < lines; i++) {
+            *(uint8_t **) (buffer + order[i] * CACHE_LINE_SIZE) =
+                buffer + order[(i + 1) % lines] * CACHE_LINE_SIZE;
+        }
+
+        chain_heads.resize(HeadsBase(MLP_MAX_CHAINS + 1));
+        for (unsigned n = 1; n <= MLP_MAX_CHAINS; n++) {
+            for (unsigned c = 0; c < n; c++) {
+                chain_heads[HeadsBase(n) + c] = buffer + order[c * lines / n] * CACHE_LINE_SIZE;
+            }
+        }
+    }
+
+    /* The chains go on from where the last call left them, short calls walk new lines */
+    heads = chain_heads.data() + HeadsBase(count);
+    return buffer;
+}
+
+/* MEMORY LEVEL PARALLELISM */
+#define MEM_MLP_SUPPORT 1
+
+/* A fixed chain count keeps every pointer in a register once the inner loop is unrolled */
+template <unsigned Chains>
+static void
+ChaseChains(uint8_t **heads, uint64_t rounds) {
+    uint8_t *p[Chains];
+    std::copy_n(heads, Chains, p);
+
+    for (uint64_t k = 0; k < rounds; k++) {
+#pragma clang loop unroll(full)
+        for (unsigned c = 0; c < Chains; c++) {
+            p[c] = *(uint8_t **) p[c];
+        }
+    }
+
+    std::copy_n(p, Chains, heads);
+}
+
+template <size_t... Chains>
+static constexpr std::array<void (*)(uint8_t **, uint64_t), sizeof...(Chains)>
+ChaseTable(std::index_sequence<Chains...>) {
+    return {ChaseChains<Chains + 1>...};
+}
+
+static constexpr auto chase_chains = ChaseTable(std::make_index_sequence<MLP_MAX_CHAINS>());
+
+/* RANDOM ACCESS */
+#define CLUSTER_WINDOW 1024 /* elements, one 4KiB page */
+#define CLUSTER_RUN    16   /* consecutive indices drawn from the same window */
+#define ZIPF_SPREAD    2654435761ull /* prime, scatters the hot ranks over the table */
+#define GATHER_UNROLL  32 /* indices per iteration of the widest gather loop */
+
+std::vector<uint32_t>
+BuildIndices(uint64_t elements, uint64_t count, int32_t pattern) {
+    /* Gather and scatter take signed 32-bit indices */
+    elements = std::clamp<uint64_t>(elements, 1, INT32_MAX);
+
+    std::vector<uint32_t> indices(count);
+    std::mt19937_64 rng(elements);
+    std::uniform_int_distribution<uint64_t> uniform(0, elements - 1);
+    std::uniform_int_distribution<uint64_t> local(0, CLUSTER_WINDOW - 1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    uint64_t window = 0;
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (pattern == PATTERN_ZIPF) {
+            /* Inverse CDF of Zipf with s = 1, P(rank < r) = ln(r + 1) / ln(n + 1) */
+            auto rank = (uint64_t) std::exp(unit(rng) * std::log((double) elements + 1)) - 1;
+            rank = std::min(rank, elements - 1);
+            indices[i] = rank * ZIPF_SPREAD % elements;
+        } else if (pattern == PATTERN_CLUSTER) {
+            if (i % CLUSTER_RUN == 0) {
+                window = uniform(rng) / CLUSTER_WINDOW * CLUSTER_WINDOW;
+            }
+            indices[i] = std::min(window + local(rng), elements - 1);
+        } else {
+            indices[i] = uniform(rng);
+        }
+    }
+
+    return indices;
+}
+
+/* Indices of a pass over the whole working set, kept until the size or the pattern changes */
+const std::vector<uint32_t> &
+GatherIndices(uint64_t bytes, int32_t pattern) {
+    static thread_local std::vector<uint32_t> indices;
+    static thread_local uint64_t indexedBytes = 0;
+    static thread_local int32_t indexedPattern = -1;
+
+    if (bytes != indexedBytes || pattern != indexedPattern) {
+        uint64_t count = std::max<uint64_t>(bytes / CACHE_LINE_SIZE, GATHER_INDEX_COUNT);
+        count = (count + GATHER_UNROLL - 1) / GATHER_UNROLL * GATHER_UNROLL;
+        indices = BuildIndices(bytes / sizeof(uint32_t), count, pattern);
+        indexedBytes = bytes;
+        indexedPattern = pattern;
+    }
+    return indices;
+}
+
+/* Every page exactly once, the stream prefetchers stop at each page boundary */
+std::vector<uint32_t>
+BuildPageOrder(uint64_t pages) {
+    std::vector<uint32_t> order(pages);
+    std::iota(order.begin(), order.end(), 0);
+
+    std::mt19937_64 rng(pages);
+    for (uint64_t i = pages; i > 1; i--) {
+        std::uniform_int_distribution<uint64_t> pick(0, i - 1);
+        std::swap(order[i - 1], order[pick(rng)]);
+    }
+
+    return order;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+mem_chase_support() {
+#if MEM_CHASE_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+#if MEM_CHASE_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_chase(uint64_t bytes, uint64_t steps) {
+    uint8_t **heads;
+    uint8_t *buffer = PointerChain(bytes, heads, 1);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+    uint8_t *p = heads[0];
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+#pragma clang loop unroll_count(16)
+    for (uint64_t k = 0; k < steps; k++) {
+        p = *(uint8_t **) p;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    heads[0] = p;
+    uint64_t offset = p - buffer;
+
+    uint64_t ops = steps /* dependent loads */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &offset, sizeof(offset));
+    return r;
+}
+#endif
+
+VMOPSMEM_EXPORT int32_t
+mem_mlp_support() {
+#if MEM_MLP_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+#if MEM_MLP_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_mlp(uint64_t bytes, uint64_t steps, int32_t chains) {
+    chains = std::clamp(chains == 0 ? DEFAULT_MLP_CHAINS : chains, 1, MLP_MAX_CHAINS);
+
+    uint8_t **heads;
+    uint8_t *buffer = PointerChain(bytes, heads, chains);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    /* Steps are loads as for mem_chase, shared out over the chains */
+    uint64_t rounds = std::max<uint64_t>(steps / chains, 1);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    chase_chains[chains - 1](heads, rounds);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t offset = 0;
+    for (int32_t c = 0; c < chains; c++) {
+        offset ^= heads[c] - buffer;
+    }
+
+    uint64_t ops = rounds * chains /* loads, independent across chains */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &offset, sizeof(offset));
+    return r;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterChaseKernels(std::vector<Kernel> &registry) {
+#if MEM_CHASE_SUPPORT
+    registry.push_back({"mem_chase", "loads", mem_chase_support,
+                        [](const KernelParams &p) { return mem_chase(p.Bytes, p.Steps); }});
+#endif
+#if MEM_MLP_SUPPORT
+    registry.push_back({"mem_mlp", "loads", mem_mlp_support, [](const KernelParams &p) {
+                            return mem_mlp(p.Bytes, p.Steps, p.Chains);
+                        }});
+#endif
+}
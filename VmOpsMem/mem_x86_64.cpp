@@ -0,0 +1,580 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <immintrin.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "vmopsmem_export.h"
+
+#define CACHE_LINE_SIZE 64
+
+#if defined(__AVX512F__)
+#define MEM_LOAD_SUPPORT     1
+#define MEM_STORE_SUPPORT    1
+#define MEM_STORE_NT_SUPPORT 1
+#define MEM_RMW_SUPPORT      1
+#define MEM_TRIAD_SUPPORT    1
+#define MEM_GATHER_SUPPORT   1
+#define MEM_SCATTER_SUPPORT  1
+#else
+#define MEM_LOAD_SUPPORT     0
+#define MEM_STORE_SUPPORT    0
+#define MEM_STORE_NT_SUPPORT 0
+#define MEM_RMW_SUPPORT      0
+#define MEM_TRIAD_SUPPORT    0
+#define MEM_GATHER_SUPPORT   0
+#define MEM_SCATTER_SUPPORT  0
+#endif
+
+/* STRIDED WALK */
+#define MEM_STRIDE_SUPPORT 1
+
+uint8_t *
+AllocBuffer(uint64_t &bytes, unsigned slot, uint64_t contents) {
+    /* Whole number of 4 x 64B lines so the unrolled loops need no tail */
+    bytes = (bytes + 4 * CACHE_LINE_SIZE - 1) & ~(uint64_t) (4 * CACHE_LINE_SIZE - 1);
+
+    bool fresh;
+    return SlotBuffer(slot, bytes, contents, fresh);
+}
+
+void
+FlushBuffer(const uint8_t *buffer, uint64_t bytes) {
+    for (uint64_t i = 0; i < bytes; i += CACHE_LINE_SIZE) {
+#if defined(__CLFLUSHOPT__)
+        _mm_clflushopt((void *) (buffer + i));
+#else
+        _mm_clflush(buffer + i);
+#endif
+    }
+    _mm_sfence();
+}
+
+static inline uint64_t
+WalkOffset(uint64_t i, uint64_t count, uint64_t stride, int32_t walk, const uint32_t *pages) {
+    if (walk == WALK_BACKWARD) {
+        return (count - 1 - i) * stride;
+    }
+
+    uint64_t offset = i * stride;
+    if (walk == WALK_PAGES) {
+        return (uint64_t) pages[offset / WALK_PAGE_SIZE] * WALK_PAGE_SIZE +
+               offset % WALK_PAGE_SIZE;
+    }
+    return offset;
+}
+
+/* The latency walk adds every loaded value (all zero) into the next address */
+template <bool Dependent>
+static uint64_t
+StrideWalk(const uint8_t *buffer, uint64_t count, uint64_t stride, int32_t walk,
+           uint64_t prefetch, const uint32_t *pages, uint64_t sum) {
+    for (uint64_t i = 0; i < count; i++) {
+        if (prefetch != 0) {
+            /* Past the end the prefetches run into the start of the next pass */
+            uint64_t ahead = i + prefetch < count ? i + prefetch : i + prefetch - count;
+            _mm_prefetch((const char *) buffer + WalkOffset(ahead, count, stride, walk, pages),
+                         _MM_HINT_T0);
+        }
+
+        uint64_t offset = WalkOffset(i, count, stride, walk, pages) + (Dependent ? sum : 0);
+        sum += *(const uint64_t *) (buffer + offset);
+
+        /* One scalar load per access, the compiler may not vectorize the walk */
+        __asm__ volatile("" : "+r"(sum));
+    }
+    return sum;
+}
+
+template <bool Dependent>
+static Result
+StrideKernel(uint64_t bytes, uint64_t steps, int32_t flush, int32_t walk, int32_t stride,
+             int32_t prefetch) {
+    /* Whole pages, every access is an aligned 8 byte load */
+    bytes = std::max<uint64_t>((bytes + WALK_PAGE_SIZE - 1) & ~(uint64_t) (WALK_PAGE_SIZE - 1),
+                               WALK_PAGE_SIZE);
+    uint64_t step = stride > 0 ? stride & ~(int32_t) (sizeof(uint64_t) - 1) : CACHE_LINE_SIZE;
+    step = std::clamp<uint64_t>(step, sizeof(uint64_t), bytes);
+
+    bool fresh;
+    uint8_t *buffer = SlotBuffer(0, bytes, BUFFER_ZERO, fresh);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    static thread_local std::vector<uint32_t> pages;
+    if (pages.size() != bytes / WALK_PAGE_SIZE) {
+        pages = BuildPageOrder(bytes / WALK_PAGE_SIZE);
+    }
+    uint64_t count = bytes / step;
+    uint64_t ahead = std::max(prefetch, 0) % count;
+
+    uint64_t sum = 0;
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        sum = StrideWalk<Dependent>(buffer, count, step, walk, ahead, pages.data(), sum);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    /* Bandwidth counts the lines the walk pulls in, latency the loads */
+    uint64_t ops = steps * count * (Dependent ? 1 : std::min<uint64_t>(step, CACHE_LINE_SIZE));
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &sum, sizeof(sum));
+    return r;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* MEMORY BANDWIDTH */
+VMOPSMEM_EXPORT int32_t
+mem_load_support() {
+#if MEM_LOAD_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_store_support() {
+#if MEM_STORE_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_store_nt_support() {
+#if MEM_STORE_NT_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_rmw_support() {
+#if MEM_RMW_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_triad_support() {
+#if MEM_TRIAD_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_gather_support() {
+#if MEM_GATHER_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_scatter_support() {
+#if MEM_SCATTER_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+VMOPSMEM_EXPORT int32_t
+mem_stride_support() {
+#if MEM_STRIDE_SUPPORT
+    return 1;
+#endif
+    return 0;
+}
+
+#if MEM_LOAD_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_load(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_ONES);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    __m512i A = _mm512_setzero_si512();
+    __m512i B = _mm512_setzero_si512();
+    __m512i C = _mm512_setzero_si512();
+    __m512i D = _mm512_setzero_si512();
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < bytes; i += 4 * CACHE_LINE_SIZE) {
+            A = _mm512_add_epi64(A, _mm512_load_si512(buffer + i + 0 * CACHE_LINE_SIZE));
+            B = _mm512_add_epi64(B, _mm512_load_si512(buffer + i + 1 * CACHE_LINE_SIZE));
+            C = _mm512_add_epi64(C, _mm512_load_si512(buffer + i + 2 * CACHE_LINE_SIZE));
+            D = _mm512_add_epi64(D, _mm512_load_si512(buffer + i + 3 * CACHE_LINE_SIZE));
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    int64_t res[8];
+    _mm512_storeu_si512((__m512i *) res,
+                        _mm512_add_epi64(_mm512_add_epi64(A, B), _mm512_add_epi64(C, D)));
+
+    uint64_t ops = steps * bytes /* read */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, res, sizeof(res));
+    return r;
+}
+#endif
+
+#if MEM_STORE_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_store(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_FILLED);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    __m512i A = _mm512_set1_epi64(steps);
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < bytes; i += 4 * CACHE_LINE_SIZE) {
+            _mm512_store_si512(buffer + i + 0 * CACHE_LINE_SIZE, A);
+            _mm512_store_si512(buffer + i + 1 * CACHE_LINE_SIZE, A);
+            _mm512_store_si512(buffer + i + 2 * CACHE_LINE_SIZE, A);
+            _mm512_store_si512(buffer + i + 3 * CACHE_LINE_SIZE, A);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * bytes /* write */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, buffer, 64);
+    return r;
+}
+#endif
+
+#if MEM_STORE_NT_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_store_nt(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_FILLED);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    __m512i A = _mm512_set1_epi64(steps);
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < bytes; i += 4 * CACHE_LINE_SIZE) {
+            _mm512_stream_si512((__m512i *) (buffer + i + 0 * CACHE_LINE_SIZE), A);
+            _mm512_stream_si512((__m512i *) (buffer + i + 1 * CACHE_LINE_SIZE), A);
+            _mm512_stream_si512((__m512i *) (buffer + i + 2 * CACHE_LINE_SIZE), A);
+            _mm512_stream_si512((__m512i *) (buffer + i + 3 * CACHE_LINE_SIZE), A);
+        }
+        _mm_sfence();
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * bytes /* write */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, buffer, 64);
+    return r;
+}
+#endif
+
+#if MEM_RMW_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_rmw(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_FILLED);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    __m512i A = _mm512_set1_epi64(1);
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < bytes; i += 4 * CACHE_LINE_SIZE) {
+            uint8_t *p = buffer + i;
+            _mm512_store_si512(p + 0 * CACHE_LINE_SIZE,
+                               _mm512_add_epi64(_mm512_load_si512(p + 0 * CACHE_LINE_SIZE), A));
+            _mm512_store_si512(p + 1 * CACHE_LINE_SIZE,
+                               _mm512_add_epi64(_mm512_load_si512(p + 1 * CACHE_LINE_SIZE), A));
+            _mm512_store_si512(p + 2 * CACHE_LINE_SIZE,
+                               _mm512_add_epi64(_mm512_load_si512(p + 2 * CACHE_LINE_SIZE), A));
+            _mm512_store_si512(p + 3 * CACHE_LINE_SIZE,
+                               _mm512_add_epi64(_mm512_load_si512(p + 3 * CACHE_LINE_SIZE), A));
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * bytes * 2 /* read + write */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, buffer, 64);
+    return r;
+}
+#endif
+
+#if MEM_TRIAD_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_triad(uint64_t bytes, uint64_t steps, int32_t flush) {
+    uint64_t arrayBytes = bytes / 3;
+    uint8_t *a = AllocBuffer(arrayBytes, 0, BUFFER_FILLED);
+    uint8_t *b = AllocBuffer(arrayBytes, 1, BUFFER_ONES);
+    uint8_t *c = AllocBuffer(arrayBytes, 2, BUFFER_ONES);
+    if (a == nullptr || b == nullptr || c == nullptr) {
+        return Result{};
+    }
+
+    __m512d S = _mm512_set1_pd(3.0);
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(a, arrayBytes);
+            FlushBuffer(b, arrayBytes);
+            FlushBuffer(c, arrayBytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < arrayBytes; i += CACHE_LINE_SIZE) {
+            __m512d B = _mm512_load_pd(b + i);
+            __m512d C = _mm512_load_pd(c + i);
+            _mm512_store_pd(a + i, _mm512_fmadd_pd(S, C, B));
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * arrayBytes * 3 /* 2 x read + write */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, a, 64);
+    return r;
+}
+#endif
+
+/* RANDOM ACCESS */
+#if MEM_GATHER_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_gather(uint64_t bytes, uint64_t steps, int32_t flush, int32_t pattern) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_ONES);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    const std::vector<uint32_t> &indices = GatherIndices(bytes, pattern);
+    const uint32_t *index = indices.data();
+    uint64_t count = indices.size();
+
+    __m512i A = _mm512_setzero_si512();
+    __m512i B = _mm512_setzero_si512();
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < count; i += 32) {
+            __m512i IA = _mm512_loadu_si512(index + i);
+            __m512i IB = _mm512_loadu_si512(index + i + 16);
+            A = _mm512_add_epi32(A, _mm512_i32gather_epi32(IA, buffer, sizeof(uint32_t)));
+            B = _mm512_add_epi32(B, _mm512_i32gather_epi32(IB, buffer, sizeof(uint32_t)));
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    int32_t res[16];
+    _mm512_storeu_si512((__m512i *) res, _mm512_add_epi32(A, B));
+
+    uint64_t ops = steps * count * sizeof(uint32_t) /* useful bytes read */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, res, sizeof(res));
+    return r;
+}
+#endif
+
+#if MEM_SCATTER_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_scatter(uint64_t bytes, uint64_t steps, int32_t flush, int32_t pattern) {
+    uint8_t *buffer = AllocBuffer(bytes, 0, BUFFER_FILLED);
+    if (buffer == nullptr) {
+        return Result{};
+    }
+
+    const std::vector<uint32_t> &indices = GatherIndices(bytes, pattern);
+    const uint32_t *index = indices.data();
+    uint64_t count = indices.size();
+
+    std::chrono::nanoseconds duration{};
+
+    for (uint64_t k = 0; k < steps; k++) {
+        if (flush) {
+            FlushBuffer(buffer, bytes);
+        }
+
+        __m512i A = _mm512_set1_epi32(k);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < count; i += 32) {
+            __m512i IA = _mm512_loadu_si512(index + i);
+            __m512i IB = _mm512_loadu_si512(index + i + 16);
+            _mm512_i32scatter_epi32(buffer, IA, A, sizeof(uint32_t));
+            _mm512_i32scatter_epi32(buffer, IB, A, sizeof(uint32_t));
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    uint64_t ops = steps * count * sizeof(uint32_t) /* useful bytes written */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, buffer, 64);
+    return r;
+}
+#endif
+
+/* STRIDED WALK */
+#if MEM_STRIDE_SUPPORT
+VMOPSMEM_EXPORT Result
+mem_stride(uint64_t bytes, uint64_t steps, int32_t flush, int32_t walk, int32_t stride,
+           int32_t prefetch) {
+    return StrideKernel<false>(bytes, steps, flush, walk, stride, prefetch);
+}
+
+VMOPSMEM_EXPORT Result
+mem_stride_lat(uint64_t bytes, uint64_t steps, int32_t flush, int32_t walk, int32_t stride,
+               int32_t prefetch) {
+    return StrideKernel<true>(bytes, steps, flush, walk, stride, prefetch);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterMemKernels(std::vector<Kernel> &registry) {
+#if MEM_LOAD_SUPPORT
+    registry.push_back({"mem_load", "bytes", mem_load_support,
+                        [](const KernelParams &p) {
+                            return mem_load(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_STORE_SUPPORT
+    registry.push_back({"mem_store", "bytes", mem_store_support,
+                        [](const KernelParams &p) {
+                            return mem_store(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_STORE_NT_SUPPORT
+    registry.push_back({"mem_store_nt", "bytes", mem_store_nt_support,
+                        [](const KernelParams &p) {
+                            return mem_store_nt(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_RMW_SUPPORT
+    registry.push_back({"mem_rmw", "bytes", mem_rmw_support,
+                        [](const KernelParams &p) {
+                            return mem_rmw(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_TRIAD_SUPPORT
+    registry.push_back({"mem_triad", "bytes", mem_triad_support,
+                        [](const KernelParams &p) {
+                            return mem_triad(p.Bytes, p.Steps, p.Flush);
+                        }});
+#endif
+#if MEM_GATHER_SUPPORT
+    registry.push_back({"mem_gather", "bytes", mem_gather_support,
+                        [](const KernelParams &p) {
+                            return mem_gather(p.Bytes, p.Steps, p.Flush, p.Pattern);
+                        }});
+#endif
+#if MEM_SCATTER_SUPPORT
+    registry.push_back({"mem_scatter", "bytes", mem_scatter_support,
+                        [](const KernelParams &p) {
+                            return mem_scatter(p.Bytes, p.Steps, p.Flush, p.Pattern);
+                        }});
+#endif
+#if MEM_STRIDE_SUPPORT
+    registry.push_back({"mem_stride", "bytes", mem_stride_support,
+                        [](const KernelParams &p) {
+                            return mem_stride(p.Bytes, p.Steps, p.Flush, p.Walk, p.Stride,
+                                              p.Prefetch);
+                        }});
+    registry.push_back({"mem_stride_lat", "loads", mem_stride_support,
+                        [](const KernelParams &p) {
+                            return mem_stride_lat(p.Bytes, p.Steps, p.Flush, p.Walk, p.Stride,
+                                                  p.Prefetch);
+                        }});
+#endif
+}
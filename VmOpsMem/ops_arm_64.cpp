@@ -83,7 +83,20 @@ union MPIDR {
     };
 };
 
-static void
+#if defined(__ARM_FEATURE_BF16)
+static __bf16
+ToBF16(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t upper = bits >> 16;
+    __bf16 r;
+    std::memcpy(&r, &upper, sizeof(r));
+    return r;
+}
+#endif
+
+void
 MapCpuTopology(LogicalCore &core) {
     volatile MPIDR mpid;
     __asm__ volatile("mrs	%[mpid] ,	mpidr_el1"
@@ -102,7 +115,30 @@ MapCpuTopology(LogicalCore &core) {
     }
 }
 
-std::chrono::time_point<std::chrono::high_resolution_clock> start_time;
+/* Implementer, part and revision, the kernel emulates the MIDR read at EL0 */
+uint64_t
+CpuModel() {
+    uint64_t midr = 0;
+    if (getauxval(AT_HWCAP) & HWCAP_CPUID) {
+        __asm__ volatile("mrs	%0, midr_el1" : "=r"(midr));
+    }
+    return midr;
+}
+
+uint64_t
+SerializedTicks() {
+    /* isb keeps the counter read from being hoisted above or sunk below the measured code */
+    uint64_t ticks;
+    __asm__ volatile("isb\n\t"
+                     "mrs	%0, cntvct_el0\n\t"
+                     "isb"
+                     : "=r"(ticks)
+                     :
+                     : "memory");
+    return ticks;
+}
+
+int64_t start_time;
 
 std::vector<LogicalCore> processors;
 
@@ -110,34 +146,24 @@ std::vector<LogicalCore> processors;
 extern "C" {
 #endif
 
-extern VMOPSMEM_EXPORT void set_thread_affinity(int coreId);
-
 VMOPSMEM_EXPORT void
 init() {
-    unsigned OSProcessorCount = sysconf(_SC_NPROCESSORS_CONF);
-    processors.resize(OSProcessorCount);
-
-    processors.resize(OSProcessorCount);
-    cpu_set_t prevCpuSet;
-    pthread_getaffinity_np(thread, sizeof(prevCpuSet), &prevCpuSet);
-
-    for (unsigned i = 0; i < OSProcessorCount; ++i) {
-        cpu_set_t cpuset{};
-        CPU_ZERO(&cpuset);
-        CPU_SET(coreId, &cpuset);
-
-        pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset);
-
-        std::this_thread::yield();
-
-        LogicalCore &core = processors[i];
-        core.Index = i;
-        MapCpuTopology(core);
-    }
-
-    pthread_setaffinity_np(thread, sizeof(prevCpuSet), &prevCpuSet);
-
-    start_time = std::chrono::high_resolution_clock::now();
+    InitTopology();
+
+    kernels.clear();
+    RegisterOpsKernels(kernels);
+    RegisterMemKernels(kernels);
+    RegisterChaseKernels(kernels);
+    RegisterJitKernels(kernels);
+    RegisterMathKernels(kernels);
+    RegisterConvertKernels(kernels);
+    RegisterPagingKernels(kernels);
+    RegisterExitKernels(kernels);
+    RegisterSyscallKernels(kernels);
+    RegisterClockKernels(kernels);
+
+    SelectTimeSource();
+    start_time = SourceTime();
 }
 
 VMOPSMEM_EXPORT CpuResult
@@ -145,12 +171,11 @@ cpu_time() {
     uint64_t cycles;
     asm("mrs %0, cntvct_el0" : "=r"(cycles));
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    int64_t end_time = SourceTime();
 
     CpuResult r;
     r.Cycles = cycles;
-    r.Time = elapsed_time.count();
+    r.Time = end_time - start_time;
     return r;
 }
 
@@ -251,20 +276,29 @@ fma_f16_f32_support() {
 #if MMLA_S8_S32_SUPPORT
 VMOPSMEM_EXPORT Result
 mmla_s8_s32(uint64_t steps) {
-    const signed char src0[16] = {1, 2, 3, 4, 5, 6, 7, 8, 1, 2, 3, 4, 5, 6, 7, 8};
-    const signed char src1[16] = {1, 2, 3, 4, 5, 6, 7, 8, 1, 2, 3, 4, 5, 6, 7, 8};
+    signed char src0[16];
+    signed char src1[16];
     signed int res[4] = {0, 0, 0, 0};
 
+    for (unsigned i = 0; i < 16; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
     int8x16_t a = vld1q_s8(src0);
     int8x16_t b = vld1q_s8(src1);
     int32x4_t c = vld1q_s32(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vmmlaq_s32(c, a, b);
+        for (; k < block; k++) {
+            c = vmmlaq_s32(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -283,20 +317,29 @@ mmla_s8_s32(uint64_t steps) {
 #if MMLA_BF16_F32_SUPPORT
 VMOPSMEM_EXPORT Result
 mmla_bf16_f32(uint64_t steps) {
-    const __bf16 src0[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
-    const __bf16 src1[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
+    __bf16 src0[8];
+    __bf16 src1[8];
     float res[4] = {0.0, 0.0, 0.0, 0.0};
 
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = ToBF16(SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE));
+        src1[i] = ToBF16(SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE));
+    }
+
     bfloat16x8_t a = vld1q_bf16(src0);
     bfloat16x8_t b = vld1q_bf16(src1);
     float32x4_t c = vld1q_f32(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vbfmmlaq_f32(c, a, b);
+        for (; k < block; k++) {
+            c = vbfmmlaq_f32(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -315,20 +358,29 @@ mmla_bf16_f32(uint64_t steps) {
 #if MLA_F32_F32_SUPPORT
 VMOPSMEM_EXPORT Result
 mla_f32_f32(uint64_t steps) {
-    const float src0[4] = {1.0, 2.0, 3.0, 4.0};
-    const float src1[4] = {1.0, 2.0, 3.0, 4.0};
+    float src0[4];
+    float src1[4];
     float res[4] = {0.0, 0.0, 0.0, 0.0};
 
+    for (unsigned i = 0; i < 4; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
     float32x4_t a = vld1q_f32(src0);
     float32x4_t b = vld1q_f32(src1);
     float32x4_t c = vld1q_f32(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vmlaq_f32(c, a, b);
+        for (; k < block; k++) {
+            c = vmlaq_f32(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -347,20 +399,29 @@ mla_f32_f32(uint64_t steps) {
 #if MLA_BF16_F32_SUPPORT
 VMOPSMEM_EXPORT Result
 mla_bf16_f32(uint64_t steps) {
-    const __bf16 src0[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
-    const __bf16 src1[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
+    __bf16 src0[8];
+    __bf16 src1[8];
     float res[4] = {0.0, 0.0, 0.0, 0.0};
 
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = ToBF16(SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE));
+        src1[i] = ToBF16(SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE));
+    }
+
     bfloat16x8_t a = vld1q_bf16(src0);
     bfloat16x8_t b = vld1q_bf16(src1);
     float32x4_t c = vld1q_f32(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vbfmlalbq_f32(c, a, b);
+        for (; k < block; k++) {
+            c = vbfmlalbq_f32(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -379,20 +440,29 @@ mla_bf16_f32(uint64_t steps) {
 #if MLA_S8_S16_SUPPORT
 VMOPSMEM_EXPORT Result
 mla_s8_s16(uint64_t steps) {
-    const signed char src0[8] = {1, 2, 3, 4, 5, 6, 7, 8};
-    const signed char src1[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    signed char src0[8];
+    signed char src1[8];
     signed short res[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
     int8x8_t a = vld1_s8(src0);
     int8x8_t b = vld1_s8(src1);
     int16x8_t c = vld1q_s16(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vmlal_s8(c, a, b);
+        for (; k < block; k++) {
+            c = vmlal_s8(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -411,20 +481,29 @@ mla_s8_s16(uint64_t steps) {
 #if DOT_BF16_F32_SUPPORT
 VMOPSMEM_EXPORT Result
 dot_bf16_f32(uint64_t steps) {
-    const __bf16 src0[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
-    const __bf16 src1[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
+    __bf16 src0[8];
+    __bf16 src1[8];
     float res[4] = {0.0, 0.0, 0.0, 0.0};
 
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = ToBF16(SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE));
+        src1[i] = ToBF16(SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE));
+    }
+
     bfloat16x8_t a = vld1q_bf16(src0);
     bfloat16x8_t b = vld1q_bf16(src1);
     float32x4_t c = vld1q_f32(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vbfdotq_f32(c, a, b);
+        for (; k < block; k++) {
+            c = vbfdotq_f32(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -443,20 +522,29 @@ dot_bf16_f32(uint64_t steps) {
 #if DOT_S8_S32_SUPPORT
 VMOPSMEM_EXPORT Result
 dot_s8_s32(uint64_t steps) {
-    const signed char src0[16] = {1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4};
-    const signed char src1[16] = {1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4};
+    signed char src0[16];
+    signed char src1[16];
     signed int res[4] = {0, 0, 0, 0};
 
+    for (unsigned i = 0; i < 16; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
     int8x16_t a = vld1q_s8(src0);
     int8x16_t b = vld1q_s8(src1);
     int32x4_t c = vld1q_s32(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vdotq_s32(c, a, b);
+        for (; k < block; k++) {
+            c = vdotq_s32(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -475,20 +563,29 @@ dot_s8_s32(uint64_t steps) {
 #if FMA_F32_F32_SUPPORT
 VMOPSMEM_EXPORT Result
 fma_f32_f32(uint64_t steps) {
-    const float src0[4] = {1.0, 2.0, 3.0, 4.0};
-    const float src1[4] = {1.0, 2.0, 3.0, 4.0};
+    float src0[4];
+    float src1[4];
     float res[4] = {0.0, 0.0, 0.0, 0.0};
 
+    for (unsigned i = 0; i < 4; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
     float32x4_t a = vld1q_f32(src0);
     float32x4_t b = vld1q_f32(src1);
     float32x4_t c = vld1q_f32(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vfmaq_f32(c, a, b);
+        for (; k < block; k++) {
+            c = vfmaq_f32(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -507,20 +604,29 @@ fma_f32_f32(uint64_t steps) {
 #if FMA_F16_F32_SUPPORT
 VMOPSMEM_EXPORT Result
 fma_f16_f32(uint64_t steps) {
-    const __fp16 src0[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
-    const __fp16 src1[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
+    __fp16 src0[8];
+    __fp16 src1[8];
     float res[8] = {0.0, 0.0, 0.0, 0.0};
 
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = (__fp16) (float) SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = (__fp16) (float) SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
     float16x8_t a = vld1q_f16(src0);
     float16x8_t b = vld1q_f16(src1);
     float32x4_t c = vld1q_f32(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vfmlalq_low_f16(c, a, b);
+        for (; k < block; k++) {
+            c = vfmlalq_low_f16(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -539,20 +645,29 @@ fma_f16_f32(uint64_t steps) {
 #if FMA_F16_F16_SUPPORT
 VMOPSMEM_EXPORT Result
 fma_f16_f16(uint64_t steps) {
-    const __fp16 src0[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
-    const __fp16 src1[8] = {1.0, 2.0, 3.0, 4.0, 1.0, 2.0, 3.0, 4.0};
+    __fp16 src0[8];
+    __fp16 src1[8];
     __fp16 res[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
 
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = (__fp16) (float) SeededValue(0, i, -1, 1);
+        src1[i] = (__fp16) (float) SeededValue(1, i, -1, 1);
+    }
+
     float16x8_t a = vld1q_f16(src0);
     float16x8_t b = vld1q_f16(src1);
     float16x8_t c = vld1q_f16(res);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        c = vfmaq_f16(c, a, b);
+        for (; k < block; k++) {
+            c = vfmaq_f16(c, a, b);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -571,3 +686,525 @@ fma_f16_f16(uint64_t steps) {
 #ifdef __cplusplus
 }
 #endif
+
+static std::vector<int64_t>
+ReferenceDots(unsigned outputs, unsigned depth, unsigned (*a)(unsigned, unsigned),
+              unsigned (*b)(unsigned, unsigned), int32_t range, std::vector<int64_t> *bounds) {
+    std::vector<int64_t> dots(outputs);
+    if (bounds != nullptr) {
+        bounds->assign(outputs, 0);
+    }
+
+    for (unsigned i = 0; i < outputs; i++) {
+        for (unsigned k = 0; k < depth; k++) {
+            int64_t x = SeededValue(0, a(i, k), -range, range);
+            int64_t y = SeededValue(1, b(i, k), -range, range);
+            dots[i] += x * y;
+            if (bounds != nullptr) {
+                (*bounds)[i] += std::abs(x * y);
+            }
+        }
+    }
+    return dots;
+}
+
+#if MMLA_S8_S32_SUPPORT
+static int32_t
+VerifyMmlaS8S32(uint64_t steps, const Result &result) {
+    /* C[i][j] += sum(k) A[i][k] * B[j][k], 2x8 by 8x2 */
+    auto dots = ReferenceDots(
+        4, 8, [](unsigned i, unsigned k) { return (i / 2) * 8 + k; },
+        [](unsigned i, unsigned k) { return (i % 2) * 8 + k; }, INPUT_RANGE, nullptr);
+    return VerifyIntOutput(result, dots, sizeof(int32_t), steps);
+}
+#endif
+
+#if MMLA_BF16_F32_SUPPORT
+static int32_t
+VerifyMmlaBF16F32(uint64_t steps, const Result &result) {
+    /* C[i][j] += sum(k) A[i][k] * B[j][k], 2x4 by 4x2 */
+    std::vector<int64_t> bounds;
+    auto dots = ReferenceDots(
+        4, 4, [](unsigned i, unsigned k) { return (i / 2) * 4 + k; },
+        [](unsigned i, unsigned k) { return (i % 2) * 4 + k; }, INPUT_RANGE, &bounds);
+    return VerifyFloatOutput(result, dots, bounds, sizeof(float), steps);
+}
+#endif
+
+#if MLA_F32_F32_SUPPORT
+static int32_t
+VerifyMlaF32F32(uint64_t steps, const Result &result) {
+    /* C[i] += A[i] * B[i] */
+    std::vector<int64_t> bounds;
+    auto dots = ReferenceDots(
+        4, 1, [](unsigned i, unsigned k) { return i; }, [](unsigned i, unsigned k) { return i; },
+        INPUT_RANGE, &bounds);
+    return VerifyFloatOutput(result, dots, bounds, sizeof(float), steps);
+}
+#endif
+
+#if MLA_BF16_F32_SUPPORT
+static int32_t
+VerifyMlaBF16F32(uint64_t steps, const Result &result) {
+    /* C[i] += A[2 * i] * B[2 * i] */
+    std::vector<int64_t> bounds;
+    auto dots = ReferenceDots(
+        4, 1, [](unsigned i, unsigned k) { return 2 * i; },
+        [](unsigned i, unsigned k) { return 2 * i; }, INPUT_RANGE, &bounds);
+    return VerifyFloatOutput(result, dots, bounds, sizeof(float), steps);
+}
+#endif
+
+#if MLA_S8_S16_SUPPORT
+static int32_t
+VerifyMlaS8S16(uint64_t steps, const Result &result) {
+    /* C[i] += A[i] * B[i], 16-bit accumulators */
+    auto dots = ReferenceDots(
+        8, 1, [](unsigned i, unsigned k) { return i; }, [](unsigned i, unsigned k) { return i; },
+        INPUT_RANGE, nullptr);
+    return VerifyIntOutput(result, dots, sizeof(int16_t), steps);
+}
+#endif
+
+#if DOT_BF16_F32_SUPPORT
+static int32_t
+VerifyDotBF16F32(uint64_t steps, const Result &result) {
+    /* C[i] += A[2 * i] * B[2 * i] + A[2 * i + 1] * B[2 * i + 1] */
+    std::vector<int64_t> bounds;
+    auto dots = ReferenceDots(
+        4, 2, [](unsigned i, unsigned k) { return 2 * i + k; },
+        [](unsigned i, unsigned k) { return 2 * i + k; }, INPUT_RANGE, &bounds);
+    return VerifyFloatOutput(result, dots, bounds, sizeof(float), steps);
+}
+#endif
+
+#if DOT_S8_S32_SUPPORT
+static int32_t
+VerifyDotS8S32(uint64_t steps, const Result &result) {
+    /* C[i] += sum(k) A[4 * i + k] * B[4 * i + k] */
+    auto dots = ReferenceDots(
+        4, 4, [](unsigned i, unsigned k) { return 4 * i + k; },
+        [](unsigned i, unsigned k) { return 4 * i + k; }, INPUT_RANGE, nullptr);
+    return VerifyIntOutput(result, dots, sizeof(int32_t), steps);
+}
+#endif
+
+#if FMA_F32_F32_SUPPORT
+static int32_t
+VerifyFmaF32F32(uint64_t steps, const Result &result) {
+    /* C[i] += A[i] * B[i] */
+    std::vector<int64_t> bounds;
+    auto dots = ReferenceDots(
+        4, 1, [](unsigned i, unsigned k) { return i; }, [](unsigned i, unsigned k) { return i; },
+        INPUT_RANGE, &bounds);
+    return VerifyFloatOutput(result, dots, bounds, sizeof(float), steps);
+}
+#endif
+
+#if FMA_F16_F16_SUPPORT
+static int32_t
+VerifyFmaF16F16(uint64_t steps, const Result &result) {
+    /* C[i] += A[i] * B[i], fp16 accumulators */
+    std::vector<int64_t> bounds;
+    auto dots = ReferenceDots(
+        8, 1, [](unsigned i, unsigned k) { return i; }, [](unsigned i, unsigned k) { return i; },
+        1, &bounds);
+    return VerifyFloatOutput(result, dots, bounds, sizeof(uint16_t), steps);
+}
+#endif
+
+#if FMA_F16_F32_SUPPORT
+static int32_t
+VerifyFmaF16F32(uint64_t steps, const Result &result) {
+    /* C[i] += A[i] * B[i], low half of the fp16 inputs */
+    std::vector<int64_t> bounds;
+    auto dots = ReferenceDots(
+        4, 1, [](unsigned i, unsigned k) { return i; }, [](unsigned i, unsigned k) { return i; },
+        INPUT_RANGE, &bounds);
+    return VerifyFloatOutput(result, dots, bounds, sizeof(float), steps);
+}
+#endif
+
+/* LATENCY AND THROUGHPUT CHAINS */
+#define CHAIN_COUNT 12
+#define LOAD_ROUNDS 4
+
+/* What runs next to the independent chains of the measured instruction */
+enum class Pairing { None, Load, Fma };
+
+template <Pairing P, typename S, typename V, typename Inst>
+static Result
+RunChains(uint64_t steps, S a, S b, V c, Inst inst, uint64_t opsPerInst) {
+    /* L1 resident copies of the first operand, so loads return the same data */
+    alignas(64) S loads[LOAD_ROUNDS * CHAIN_COUNT];
+    for (S &slot : loads) {
+        slot = a;
+    }
+    __asm__ volatile("" : : "r"(loads) : "memory");
+
+    V acc[CHAIN_COUNT];
+    float32x4_t fma[CHAIN_COUNT];
+    float32x4_t one = vdupq_n_f32(1.0f);
+    for (unsigned j = 0; j < CHAIN_COUNT; j++) {
+        acc[j] = c;
+        fma[j] = vdupq_n_f32(0.0f);
+        /* Hide that the chains start out equal, otherwise they are folded into one */
+        __asm__ volatile("" : "+w"(acc[j]), "+w"(fma[j]));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
+        for (; k < block; k++) {
+            const S *round = loads + (k % LOAD_ROUNDS) * CHAIN_COUNT;
+#pragma clang loop unroll(full)
+            for (unsigned j = 0; j < CHAIN_COUNT; j++) {
+                if constexpr (P == Pairing::Load) {
+                    acc[j] = inst(acc[j], round[j], b);
+                } else {
+                    acc[j] = inst(acc[j], a, b);
+                }
+                if constexpr (P == Pairing::Fma) {
+                    fma[j] = vfmaq_f32(fma[j], one, one);
+                }
+            }
+        }
+    }
+    steps = k;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    for (unsigned j = 0; j < CHAIN_COUNT; j++) {
+        __asm__ volatile("" : : "w"(acc[j]), "w"(fma[j]));
+    }
+
+    uint64_t ops = steps * CHAIN_COUNT * opsPerInst;
+
+    /* Every chain computes the same values as the single chain kernel */
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &acc[0], sizeof(acc[0]));
+    return r;
+}
+
+#if MMLA_S8_S32_SUPPORT
+template <Pairing P>
+static Result
+MmlaS8S32Chains(const KernelParams &params) {
+    signed char src0[16];
+    signed char src1[16];
+
+    for (unsigned i = 0; i < 16; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1q_s8(src0), vld1q_s8(src1), vdupq_n_s32(0),
+        [](int32x4_t c, int8x16_t a, int8x16_t b) { return vmmlaq_s32(c, a, b); }, 8 * 4);
+}
+#endif
+
+#if MMLA_BF16_F32_SUPPORT
+template <Pairing P>
+static Result
+MmlaBF16F32Chains(const KernelParams &params) {
+    __bf16 src0[8];
+    __bf16 src1[8];
+
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = ToBF16(SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE));
+        src1[i] = ToBF16(SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE));
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1q_bf16(src0), vld1q_bf16(src1), vdupq_n_f32(0.0f),
+        [](float32x4_t c, bfloat16x8_t a, bfloat16x8_t b) { return vbfmmlaq_f32(c, a, b); }, 4 * 4);
+}
+#endif
+
+#if MLA_F32_F32_SUPPORT
+template <Pairing P>
+static Result
+MlaF32F32Chains(const KernelParams &params) {
+    float src0[4];
+    float src1[4];
+
+    for (unsigned i = 0; i < 4; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1q_f32(src0), vld1q_f32(src1), vdupq_n_f32(0.0f),
+        [](float32x4_t c, float32x4_t a, float32x4_t b) { return vmlaq_f32(c, a, b); }, 2 * 4);
+}
+#endif
+
+#if MLA_BF16_F32_SUPPORT
+template <Pairing P>
+static Result
+MlaBF16F32Chains(const KernelParams &params) {
+    __bf16 src0[8];
+    __bf16 src1[8];
+
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = ToBF16(SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE));
+        src1[i] = ToBF16(SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE));
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1q_bf16(src0), vld1q_bf16(src1), vdupq_n_f32(0.0f),
+        [](float32x4_t c, bfloat16x8_t a, bfloat16x8_t b) {
+            return vbfmlalbq_f32(c, a, b);
+        },
+        4 * 4);
+}
+#endif
+
+#if MLA_S8_S16_SUPPORT
+template <Pairing P>
+static Result
+MlaS8S16Chains(const KernelParams &params) {
+    signed char src0[8];
+    signed char src1[8];
+
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1_s8(src0), vld1_s8(src1), vdupq_n_s16(0),
+        [](int16x8_t c, int8x8_t a, int8x8_t b) { return vmlal_s8(c, a, b); }, 8 * 4);
+}
+#endif
+
+#if DOT_BF16_F32_SUPPORT
+template <Pairing P>
+static Result
+DotBF16F32Chains(const KernelParams &params) {
+    __bf16 src0[8];
+    __bf16 src1[8];
+
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = ToBF16(SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE));
+        src1[i] = ToBF16(SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE));
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1q_bf16(src0), vld1q_bf16(src1), vdupq_n_f32(0.0f),
+        [](float32x4_t c, bfloat16x8_t a, bfloat16x8_t b) { return vbfdotq_f32(c, a, b); }, 4 * 4);
+}
+#endif
+
+#if DOT_S8_S32_SUPPORT
+template <Pairing P>
+static Result
+DotS8S32Chains(const KernelParams &params) {
+    signed char src0[16];
+    signed char src1[16];
+
+    for (unsigned i = 0; i < 16; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1q_s8(src0), vld1q_s8(src1), vdupq_n_s32(0),
+        [](int32x4_t c, int8x16_t a, int8x16_t b) { return vdotq_s32(c, a, b); }, 8 * 4);
+}
+#endif
+
+#if FMA_F32_F32_SUPPORT
+template <Pairing P>
+static Result
+FmaF32F32Chains(const KernelParams &params) {
+    float src0[4];
+    float src1[4];
+
+    for (unsigned i = 0; i < 4; i++) {
+        src0[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1q_f32(src0), vld1q_f32(src1), vdupq_n_f32(0.0f),
+        [](float32x4_t c, float32x4_t a, float32x4_t b) { return vfmaq_f32(c, a, b); }, 2 * 4);
+}
+#endif
+
+#if FMA_F16_F16_SUPPORT
+template <Pairing P>
+static Result
+FmaF16F16Chains(const KernelParams &params) {
+    __fp16 src0[8];
+    __fp16 src1[8];
+
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = (__fp16) (float) SeededValue(0, i, -1, 1);
+        src1[i] = (__fp16) (float) SeededValue(1, i, -1, 1);
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1q_f16(src0), vld1q_f16(src1), vdupq_n_f16(0.0f),
+        [](float16x8_t c, float16x8_t a, float16x8_t b) { return vfmaq_f16(c, a, b); }, 2 * 8);
+}
+#endif
+
+#if FMA_F16_F32_SUPPORT
+template <Pairing P>
+static Result
+FmaF16F32Chains(const KernelParams &params) {
+    __fp16 src0[8];
+    __fp16 src1[8];
+
+    for (unsigned i = 0; i < 8; i++) {
+        src0[i] = (__fp16) (float) SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src1[i] = (__fp16) (float) SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
+    return RunChains<P>(
+        params.Steps, vld1q_f16(src0), vld1q_f16(src1), vdupq_n_f32(0.0f),
+        [](float32x4_t c, float16x8_t a, float16x8_t b) {
+            return vfmlalq_low_f16(c, a, b);
+        },
+        4 * 4);
+}
+#endif
+
+void
+RegisterOpsKernels(std::vector<Kernel> &registry) {
+#if MMLA_S8_S32_SUPPORT
+    registry.push_back({"mmla_s8_s32", "ops", mmla_s8_s32_support,
+                        [](const KernelParams &p) { return mmla_s8_s32(p.Steps); },
+                        VerifyMmlaS8S32, 32 /* 8 x 4 */});
+#endif
+#if MMLA_BF16_F32_SUPPORT
+    registry.push_back({"mmla_bf16_f32", "ops", mmla_bf16_f32_support,
+                        [](const KernelParams &p) { return mmla_bf16_f32(p.Steps); },
+                        VerifyMmlaBF16F32, 16 /* 4 x 4 */});
+#endif
+#if MLA_F32_F32_SUPPORT
+    registry.push_back({"mla_f32_f32", "ops", mla_f32_f32_support,
+                        [](const KernelParams &p) { return mla_f32_f32(p.Steps); },
+                        VerifyMlaF32F32, 8 /* 2 x 4 */});
+#endif
+#if MLA_BF16_F32_SUPPORT
+    registry.push_back({"mla_bf16_f32", "ops", mla_bf16_f32_support,
+                        [](const KernelParams &p) { return mla_bf16_f32(p.Steps); },
+                        VerifyMlaBF16F32, 16 /* 4 x 4 */});
+#endif
+#if MLA_S8_S16_SUPPORT
+    registry.push_back({"mla_s8_s16", "ops", mla_s8_s16_support,
+                        [](const KernelParams &p) { return mla_s8_s16(p.Steps); },
+                        VerifyMlaS8S16, 32 /* 8 x 4 */});
+#endif
+#if DOT_BF16_F32_SUPPORT
+    registry.push_back({"dot_bf16_f32", "ops", dot_bf16_f32_support,
+                        [](const KernelParams &p) { return dot_bf16_f32(p.Steps); },
+                        VerifyDotBF16F32, 16 /* 4 x 4 */});
+#endif
+#if DOT_S8_S32_SUPPORT
+    registry.push_back({"dot_s8_s32", "ops", dot_s8_s32_support,
+                        [](const KernelParams &p) { return dot_s8_s32(p.Steps); },
+                        VerifyDotS8S32, 32 /* 8 x 4 */});
+#endif
+#if FMA_F32_F32_SUPPORT
+    registry.push_back({"fma_f32_f32", "ops", fma_f32_f32_support,
+                        [](const KernelParams &p) { return fma_f32_f32(p.Steps); },
+                        VerifyFmaF32F32, 8 /* 2 x 4 */});
+#endif
+#if FMA_F16_F16_SUPPORT
+    registry.push_back({"fma_f16_f16", "ops", fma_f16_f16_support,
+                        [](const KernelParams &p) { return fma_f16_f16(p.Steps); },
+                        VerifyFmaF16F16, 16 /* 2 x 8 */});
+#endif
+#if FMA_F16_F32_SUPPORT
+    registry.push_back({"fma_f16_f32", "ops", fma_f16_f32_support,
+                        [](const KernelParams &p) { return fma_f16_f32(p.Steps); },
+                        VerifyFmaF16F32, 16 /* 4 x 4 */});
+#endif
+    /* Independent chains, alone and paired with loads or FMAs, for the instruction table */
+#if MMLA_S8_S32_SUPPORT
+    registry.push_back({"mmla_s8_s32_tput", "ops", mmla_s8_s32_support,
+                        MmlaS8S32Chains<Pairing::None>, VerifyMmlaS8S32, 32});
+    registry.push_back({"mmla_s8_s32_load", "ops", mmla_s8_s32_support,
+                        MmlaS8S32Chains<Pairing::Load>, VerifyMmlaS8S32, 32});
+    registry.push_back({"mmla_s8_s32_fma", "ops", mmla_s8_s32_support,
+                        MmlaS8S32Chains<Pairing::Fma>, VerifyMmlaS8S32, 32});
+#endif
+#if MMLA_BF16_F32_SUPPORT
+    registry.push_back({"mmla_bf16_f32_tput", "ops", mmla_bf16_f32_support,
+                        MmlaBF16F32Chains<Pairing::None>, VerifyMmlaBF16F32, 16});
+    registry.push_back({"mmla_bf16_f32_load", "ops", mmla_bf16_f32_support,
+                        MmlaBF16F32Chains<Pairing::Load>, VerifyMmlaBF16F32, 16});
+    registry.push_back({"mmla_bf16_f32_fma", "ops", mmla_bf16_f32_support,
+                        MmlaBF16F32Chains<Pairing::Fma>, VerifyMmlaBF16F32, 16});
+#endif
+#if MLA_F32_F32_SUPPORT
+    registry.push_back({"mla_f32_f32_tput", "ops", mla_f32_f32_support,
+                        MlaF32F32Chains<Pairing::None>, VerifyMlaF32F32, 8});
+    registry.push_back({"mla_f32_f32_load", "ops", mla_f32_f32_support,
+                        MlaF32F32Chains<Pairing::Load>, VerifyMlaF32F32, 8});
+    registry.push_back({"mla_f32_f32_fma", "ops", mla_f32_f32_support,
+                        MlaF32F32Chains<Pairing::Fma>, VerifyMlaF32F32, 8});
+#endif
+#if MLA_BF16_F32_SUPPORT
+    registry.push_back({"mla_bf16_f32_tput", "ops", mla_bf16_f32_support,
+                        MlaBF16F32Chains<Pairing::None>, VerifyMlaBF16F32, 16});
+    registry.push_back({"mla_bf16_f32_load", "ops", mla_bf16_f32_support,
+                        MlaBF16F32Chains<Pairing::Load>, VerifyMlaBF16F32, 16});
+    registry.push_back({"mla_bf16_f32_fma", "ops", mla_bf16_f32_support,
+                        MlaBF16F32Chains<Pairing::Fma>, VerifyMlaBF16F32, 16});
+#endif
+#if MLA_S8_S16_SUPPORT
+    registry.push_back({"mla_s8_s16_tput", "ops", mla_s8_s16_support,
+                        MlaS8S16Chains<Pairing::None>, VerifyMlaS8S16, 32});
+    registry.push_back({"mla_s8_s16_load", "ops", mla_s8_s16_support,
+                        MlaS8S16Chains<Pairing::Load>, VerifyMlaS8S16, 32});
+    registry.push_back({"mla_s8_s16_fma", "ops", mla_s8_s16_support,
+                        MlaS8S16Chains<Pairing::Fma>, VerifyMlaS8S16, 32});
+#endif
+#if DOT_BF16_F32_SUPPORT
+    registry.push_back({"dot_bf16_f32_tput", "ops", dot_bf16_f32_support,
+                        DotBF16F32Chains<Pairing::None>, VerifyDotBF16F32, 16});
+    registry.push_back({"dot_bf16_f32_load", "ops", dot_bf16_f32_support,
+                        DotBF16F32Chains<Pairing::Load>, VerifyDotBF16F32, 16});
+    registry.push_back({"dot_bf16_f32_fma", "ops", dot_bf16_f32_support,
+                        DotBF16F32Chains<Pairing::Fma>, VerifyDotBF16F32, 16});
+#endif
+#if DOT_S8_S32_SUPPORT
+    registry.push_back({"dot_s8_s32_tput", "ops", dot_s8_s32_support,
+                        DotS8S32Chains<Pairing::None>, VerifyDotS8S32, 32});
+    registry.push_back({"dot_s8_s32_load", "ops", dot_s8_s32_support,
+                        DotS8S32Chains<Pairing::Load>, VerifyDotS8S32, 32});
+    registry.push_back({"dot_s8_s32_fma", "ops", dot_s8_s32_support,
+                        DotS8S32Chains<Pairing::Fma>, VerifyDotS8S32, 32});
+#endif
+#if FMA_F32_F32_SUPPORT
+    registry.push_back({"fma_f32_f32_tput", "ops", fma_f32_f32_support,
+                        FmaF32F32Chains<Pairing::None>, VerifyFmaF32F32, 8});
+    registry.push_back({"fma_f32_f32_load", "ops", fma_f32_f32_support,
+                        FmaF32F32Chains<Pairing::Load>, VerifyFmaF32F32, 8});
+    registry.push_back({"fma_f32_f32_fma", "ops", fma_f32_f32_support,
+                        FmaF32F32Chains<Pairing::Fma>, VerifyFmaF32F32, 8});
+#endif
+#if FMA_F16_F16_SUPPORT
+    registry.push_back({"fma_f16_f16_tput", "ops", fma_f16_f16_support,
+                        FmaF16F16Chains<Pairing::None>, VerifyFmaF16F16, 16});
+    registry.push_back({"fma_f16_f16_load", "ops", fma_f16_f16_support,
+                        FmaF16F16Chains<Pairing::Load>, VerifyFmaF16F16, 16});
+    registry.push_back({"fma_f16_f16_fma", "ops", fma_f16_f16_support,
+                        FmaF16F16Chains<Pairing::Fma>, VerifyFmaF16F16, 16});
+#endif
+#if FMA_F16_F32_SUPPORT
+    registry.push_back({"fma_f16_f32_tput", "ops", fma_f16_f32_support,
+                        FmaF16F32Chains<Pairing::None>, VerifyFmaF16F32, 16});
+    registry.push_back({"fma_f16_f32_load", "ops", fma_f16_f32_support,
+                        FmaF16F32Chains<Pairing::Load>, VerifyFmaF16F32, 16});
+    registry.push_back({"fma_f16_f32_fma", "ops", fma_f16_f32_support,
+                        FmaF16F32Chains<Pairing::Fma>, VerifyFmaF16F32, 16});
+#endif
+}
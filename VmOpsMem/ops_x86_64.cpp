@@ -95,11 +95,18 @@ struct Features {
     } EDX;
 };
 
-std::chrono::time_point<std::chrono::high_resolution_clock> start_time;
+int64_t start_time;
 
 std::vector<LogicalCore> processors;
 Features features;
 
+static uint16_t
+ToBF16Bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits >> 16;
+}
+
 inline unsigned short
 FindMaskWidth(unsigned short maxCount) {
     unsigned short maskWidth = 0, count = (maxCount - 1);
@@ -127,7 +134,7 @@ QueryFeatures() {
                      : "%rax", "%rbx", "%rcx", "%rdx");
 }
 
-static void
+void
 MapCpuTopology(LogicalCore &core) {
     unsigned short SMT_Mask_Width;
     unsigned short CORE_Mask_Width;
@@ -199,6 +206,29 @@ MapCpuTopology(LogicalCore &core) {
         (leaf1_ebx.Init_APIC_ID & PKG_Select_Mask) >> (CORE_Mask_Width + SMT_Mask_Width);
 }
 
+/* The vendor ("Genu", "Auth", ...) and the family, model and stepping signature */
+uint64_t
+CpuModel() {
+    uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+    __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0), "c"(0));
+    uint32_t vendor = ebx;
+    __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1), "c"(0));
+    return ((uint64_t) vendor << 32) | eax;
+}
+
+uint64_t
+SerializedTicks() {
+    /* lfence waits for earlier instructions to retire and holds back the later ones */
+    uint32_t lo, hi;
+    __asm__ volatile("lfence\n\t"
+                     "rdtsc\n\t"
+                     "lfence"
+                     : "=a"(lo), "=d"(hi)
+                     :
+                     : "memory");
+    return ((uint64_t) hi << 32) | lo;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -208,32 +238,22 @@ init() {
     syscall(SYS_arch_prctl, ARCH_REQ_XCOMP_PERM, XFEATURE_XTILEDATA);
 
     QueryFeatures();
-
-    pthread_t thread = pthread_self();
-    unsigned OSProcessorCount = sysconf(_SC_NPROCESSORS_CONF);
-
-    processors.resize(OSProcessorCount);
-    cpu_set_t prevCpuSet;
-    pthread_getaffinity_np(thread, sizeof(prevCpuSet), &prevCpuSet);
-
-    for (unsigned coreId = 0; coreId < OSProcessorCount; ++coreId) {
-        cpu_set_t cpuset{};
-        CPU_ZERO(&cpuset);
-        CPU_SET(coreId, &cpuset);
-
-        pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset);
-
-        std::this_thread::yield();
-
-        LogicalCore &core = processors[coreId];
-        core.Index = coreId;
-
-        MapCpuTopology(core);
-    }
-
-    pthread_setaffinity_np(thread, sizeof(prevCpuSet), &prevCpuSet);
-
-    start_time = std::chrono::high_resolution_clock::now();
+    InitTopology();
+
+    kernels.clear();
+    RegisterOpsKernels(kernels);
+    RegisterMemKernels(kernels);
+    RegisterChaseKernels(kernels);
+    RegisterJitKernels(kernels);
+    RegisterMathKernels(kernels);
+    RegisterConvertKernels(kernels);
+    RegisterPagingKernels(kernels);
+    RegisterExitKernels(kernels);
+    RegisterSyscallKernels(kernels);
+    RegisterClockKernels(kernels);
+
+    SelectTimeSource();
+    start_time = SourceTime();
 }
 
 VMOPSMEM_EXPORT CpuResult
@@ -241,12 +261,11 @@ cpu_time() {
     uint32_t lo, hi;
     __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    int64_t end_time = SourceTime();
 
     CpuResult r;
     r.Cycles = ((uint64_t) hi << 32) | lo;
-    r.Time = elapsed_time.count();
+    r.Time = end_time - start_time;
     return r;
 }
 
@@ -297,20 +316,29 @@ amx_s8_s32(uint64_t steps) {
     tile_info.rows[2] = 16;
     _tile_loadconfig(&tile_info);
 
-    int8_t src1[1024] = {};
-    int8_t src2[1024] = {};
+    int8_t src1[1024];
+    int8_t src2[1024];
     int32_t res[256] = {};
 
+    for (unsigned i = 0; i < 1024; i++) {
+        src1[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src2[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
     _tile_loadd(1, src1, 64);
     _tile_loadd(2, src2, 64);
     _tile_loadd(0, res, 64);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(16)
-    for (uint64_t k = 0; k < steps; k++) {
-        _tile_dpbssd(0, 1, 2);
+        for (; k < block; k++) {
+            _tile_dpbssd(0, 1, 2);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -340,20 +368,30 @@ amx_bf16_f32(uint64_t steps) {
     tile_info.rows[2] = 16;
     _tile_loadconfig(&tile_info);
 
-    __bf16 src1[512] = {};
-    __bf16 src2[512] = {};
+    /* bf16 bit patterns */
+    uint16_t src1[512];
+    uint16_t src2[512];
     float res[256] = {};
 
+    for (unsigned i = 0; i < 512; i++) {
+        src1[i] = ToBF16Bits(SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE));
+        src2[i] = ToBF16Bits(SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE));
+    }
+
     _tile_loadd(1, src1, 64);
     _tile_loadd(2, src2, 64);
     _tile_loadd(0, res, 64);
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        _tile_dpbf16ps(0, 1, 2);
+        for (; k < block; k++) {
+            _tile_dpbf16ps(0, 1, 2);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -373,9 +411,14 @@ amx_bf16_f32(uint64_t steps) {
 #if VNN_S8_S32_SUPPORT
 VMOPSMEM_EXPORT Result
 vnn_s8_s32(uint64_t steps) {
-    int src1[16] = {};
-    int src2[16] = {};
-    int res[16] = {};
+    int8_t src1[64];
+    uint8_t src2[64];
+    int32_t res[16] = {};
+
+    for (unsigned i = 0; i < 64; i++) {
+        src1[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src2[i] = SeededValue(1, i, 0, INPUT_RANGE);
+    }
 
     __m512i A, B, C;
     A = _mm512_loadu_si512((__m512i *) &src1);
@@ -384,10 +427,14 @@ vnn_s8_s32(uint64_t steps) {
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(1024)
-    for (uint64_t k = 0; k < steps; k++) {
-        C = _mm512_dpbusd_epi32(C, B, A);
+        for (; k < block; k++) {
+            C = _mm512_dpbusd_epi32(C, B, A);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -407,9 +454,15 @@ vnn_s8_s32(uint64_t steps) {
 #if VNN_F16_F32_SUPPORT
 VMOPSMEM_EXPORT Result
 vnn_f16_f32(uint64_t steps) {
-    __fp16 src1[32] = {};
-    __fp16 src2[32] = {};
-    float res[32] = {};
+    /* vpdpwssd multiplies signed 16-bit words */
+    int16_t src1[32];
+    int16_t src2[32];
+    int32_t res[16] = {};
+
+    for (unsigned i = 0; i < 32; i++) {
+        src1[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src2[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
 
     __m512i A, B, C;
     A = _mm512_loadu_si512((__m512i *) &src1);
@@ -418,10 +471,14 @@ vnn_f16_f32(uint64_t steps) {
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
 #pragma clang loop unroll_count(32)
-    for (uint64_t k = 0; k < steps; k++) {
-        C = _mm512_dpwssd_epi32(C, B, A);
+        for (; k < block; k++) {
+            C = _mm512_dpwssd_epi32(C, B, A);
+        }
     }
+    steps = k;
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -441,3 +498,345 @@ vnn_f16_f32(uint64_t steps) {
 #ifdef __cplusplus
 }
 #endif
+
+#if AMX_S8_S32_SUPPORT
+static int32_t
+VerifyAmxS8S32(uint64_t steps, const Result &result) {
+    /* C[m][n] += sum(k) A[m][k] * B[k / 4][n * 4 + k % 4] */
+    std::vector<int64_t> dots(16 * 16);
+    for (unsigned m = 0; m < 16; m++) {
+        for (unsigned n = 0; n < 16; n++) {
+            for (unsigned k = 0; k < 64; k++) {
+                int64_t a = SeededValue(0, m * 64 + k, -INPUT_RANGE, INPUT_RANGE);
+                int64_t b = SeededValue(1, (k / 4) * 64 + n * 4 + k % 4, -INPUT_RANGE, INPUT_RANGE);
+                dots[m * 16 + n] += a * b;
+            }
+        }
+    }
+    return VerifyIntOutput(result, dots, sizeof(int32_t), steps);
+}
+#endif
+
+#if AMX_BF16_F32_SUPPORT
+static int32_t
+VerifyAmxBF16F32(uint64_t steps, const Result &result) {
+    /* C[m][n] += sum(k) A[m][k] * B[k / 2][n * 2 + k % 2] */
+    std::vector<int64_t> dots(16 * 16);
+    std::vector<int64_t> bounds(16 * 16);
+    for (unsigned m = 0; m < 16; m++) {
+        for (unsigned n = 0; n < 16; n++) {
+            for (unsigned k = 0; k < 32; k++) {
+                int64_t a = SeededValue(0, m * 32 + k, -INPUT_RANGE, INPUT_RANGE);
+                int64_t b = SeededValue(1, (k / 2) * 32 + n * 2 + k % 2, -INPUT_RANGE, INPUT_RANGE);
+                dots[m * 16 + n] += a * b;
+                bounds[m * 16 + n] += std::abs(a * b);
+            }
+        }
+    }
+    return VerifyFloatOutput(result, dots, bounds, sizeof(float), steps);
+}
+#endif
+
+#if VNN_S8_S32_SUPPORT
+static int32_t
+VerifyVnnS8S32(uint64_t steps, const Result &result) {
+    /* C[i] += sum(j) u8(B[4 * i + j]) * s8(A[4 * i + j]) */
+    std::vector<int64_t> dots(16);
+    for (unsigned i = 0; i < 16; i++) {
+        for (unsigned j = 0; j < 4; j++) {
+            int64_t a = SeededValue(0, 4 * i + j, -INPUT_RANGE, INPUT_RANGE);
+            int64_t b = SeededValue(1, 4 * i + j, 0, INPUT_RANGE);
+            dots[i] += a * b;
+        }
+    }
+    return VerifyIntOutput(result, dots, sizeof(int32_t), steps);
+}
+#endif
+
+#if VNN_F16_F32_SUPPORT
+static int32_t
+VerifyVnnF16F32(uint64_t steps, const Result &result) {
+    /* C[i] += B[2 * i] * A[2 * i] + B[2 * i + 1] * A[2 * i + 1] */
+    std::vector<int64_t> dots(16);
+    for (unsigned i = 0; i < 16; i++) {
+        for (unsigned j = 0; j < 2; j++) {
+            int64_t a = SeededValue(0, 2 * i + j, -INPUT_RANGE, INPUT_RANGE);
+            int64_t b = SeededValue(1, 2 * i + j, -INPUT_RANGE, INPUT_RANGE);
+            dots[i] += a * b;
+        }
+    }
+    return VerifyIntOutput(result, dots, sizeof(int32_t), steps);
+}
+#endif
+
+/* LATENCY AND THROUGHPUT CHAINS */
+#define CHAIN_COUNT     12
+#define TILE_CHAIN_COUNT 4
+#define LOAD_ROUNDS     4
+
+/* What runs next to the independent chains of the measured instruction */
+enum class Pairing { None, Load, Fma };
+
+template <Pairing P, typename V, typename Inst>
+static Result
+RunChains(uint64_t steps, V a, V b, V c, Inst inst, uint64_t opsPerInst) {
+    /* L1 resident copies of the first operand, so loads return the same data */
+    alignas(64) V loads[LOAD_ROUNDS * CHAIN_COUNT];
+    for (V &slot : loads) {
+        slot = a;
+    }
+    __asm__ volatile("" : : "r"(loads) : "memory");
+
+    V acc[CHAIN_COUNT];
+    __m512 fma[CHAIN_COUNT];
+    __m512 one = _mm512_set1_ps(1.0f);
+    for (unsigned j = 0; j < CHAIN_COUNT; j++) {
+        acc[j] = c;
+        fma[j] = _mm512_setzero_ps();
+        /* Hide that the chains start out equal, otherwise they are folded into one */
+        __asm__ volatile("" : "+v"(acc[j]), "+v"(fma[j]));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
+        for (; k < block; k++) {
+            const V *round = loads + (k % LOAD_ROUNDS) * CHAIN_COUNT;
+#pragma clang loop unroll(full)
+            for (unsigned j = 0; j < CHAIN_COUNT; j++) {
+                if constexpr (P == Pairing::Load) {
+                    acc[j] = inst(acc[j], round[j], b);
+                } else {
+                    acc[j] = inst(acc[j], a, b);
+                }
+                if constexpr (P == Pairing::Fma) {
+                    fma[j] = _mm512_fmadd_ps(fma[j], one, one);
+                }
+            }
+        }
+    }
+    steps = k;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    for (unsigned j = 0; j < CHAIN_COUNT; j++) {
+        __asm__ volatile("" : : "v"(acc[j]), "v"(fma[j]));
+    }
+
+    uint64_t ops = steps * CHAIN_COUNT * opsPerInst;
+
+    /* Every chain computes the same values as the single chain kernel */
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &acc[0], sizeof(acc[0]));
+    return r;
+}
+
+#if AMX_S8_S32_SUPPORT || AMX_BF16_F32_SUPPORT
+/* Tile numbers have to be literals for the tile intrinsics */
+#define TILE_DOT(_bf16, _dst, _src1, _src2)                                                        \
+    if constexpr (_bf16) {                                                                         \
+        _tile_dpbf16ps(_dst, _src1, _src2);                                                        \
+    } else {                                                                                       \
+        _tile_dpbssd(_dst, _src1, _src2);                                                          \
+    }
+
+template <Pairing P, bool BF16>
+static Result
+RunTileChains(uint64_t steps, const void *src1, const void *src2, uint64_t opsPerInst) {
+    tile_config_t tile_info{};
+    tile_info.paletteId = 1;
+    for (unsigned t = 0; t < 8; t++) {
+        tile_info.cols[t] = 64;
+        tile_info.rows[t] = 16;
+    }
+    _tile_loadconfig(&tile_info);
+
+    /* Accumulators in tiles 0-3, operands in 4-5, reloaded operands in 6-7 */
+    int32_t res[256] = {};
+    _tile_loadd(0, res, 64);
+    _tile_loadd(1, res, 64);
+    _tile_loadd(2, res, 64);
+    _tile_loadd(3, res, 64);
+    _tile_loadd(4, src1, 64);
+    _tile_loadd(5, src2, 64);
+
+    __m512 fma[TILE_CHAIN_COUNT];
+    __m512 one = _mm512_set1_ps(1.0f);
+    for (unsigned j = 0; j < TILE_CHAIN_COUNT; j++) {
+        fma[j] = _mm512_setzero_ps();
+        __asm__ volatile("" : "+v"(fma[j]));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint64_t k = 0;
+    for (uint64_t block = NextSlice(0, steps); k < block; block = NextSlice(k, steps)) {
+        for (; k < block; k++) {
+            if constexpr (P == Pairing::Load) {
+                _tile_loadd(6, src1, 64);
+                TILE_DOT(BF16, 0, 6, 5)
+                _tile_loadd(7, src1, 64);
+                TILE_DOT(BF16, 1, 7, 5)
+                _tile_loadd(6, src1, 64);
+                TILE_DOT(BF16, 2, 6, 5)
+                _tile_loadd(7, src1, 64);
+                TILE_DOT(BF16, 3, 7, 5)
+            } else {
+                TILE_DOT(BF16, 0, 4, 5)
+                TILE_DOT(BF16, 1, 4, 5)
+                TILE_DOT(BF16, 2, 4, 5)
+                TILE_DOT(BF16, 3, 4, 5)
+            }
+            if constexpr (P == Pairing::Fma) {
+                for (unsigned j = 0; j < TILE_CHAIN_COUNT; j++) {
+                    fma[j] = _mm512_fmadd_ps(fma[j], one, one);
+                }
+            }
+        }
+    }
+    steps = k;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    _tile_stored(0, res, 64);
+    _tile_release();
+
+    for (unsigned j = 0; j < TILE_CHAIN_COUNT; j++) {
+        __asm__ volatile("" : : "v"(fma[j]));
+    }
+
+    uint64_t ops = steps * TILE_CHAIN_COUNT * opsPerInst;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, res, sizeof(res));
+    return r;
+}
+#endif
+
+#if AMX_S8_S32_SUPPORT
+template <Pairing P>
+static Result
+AmxS8S32Chains(const KernelParams &params) {
+    int8_t src1[1024];
+    int8_t src2[1024];
+
+    for (unsigned i = 0; i < 1024; i++) {
+        src1[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src2[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
+    return RunTileChains<P, false>(params.Steps, src1, src2, 128 * 16 * 16);
+}
+#endif
+
+#if AMX_BF16_F32_SUPPORT
+template <Pairing P>
+static Result
+AmxBF16F32Chains(const KernelParams &params) {
+    uint16_t src1[512];
+    uint16_t src2[512];
+
+    for (unsigned i = 0; i < 512; i++) {
+        src1[i] = ToBF16Bits(SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE));
+        src2[i] = ToBF16Bits(SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE));
+    }
+
+    return RunTileChains<P, true>(params.Steps, src1, src2, 64 * 16 * 16);
+}
+#endif
+
+#if VNN_S8_S32_SUPPORT
+template <Pairing P>
+static Result
+VnnS8S32Chains(const KernelParams &params) {
+    int8_t src1[64];
+    uint8_t src2[64];
+
+    for (unsigned i = 0; i < 64; i++) {
+        src1[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src2[i] = SeededValue(1, i, 0, INPUT_RANGE);
+    }
+
+    return RunChains<P>(
+        params.Steps, _mm512_loadu_si512(src1), _mm512_loadu_si512(src2), _mm512_setzero_si512(),
+        [](__m512i c, __m512i a, __m512i b) { return _mm512_dpbusd_epi32(c, b, a); }, 8 * 16);
+}
+#endif
+
+#if VNN_F16_F32_SUPPORT
+template <Pairing P>
+static Result
+VnnF16F32Chains(const KernelParams &params) {
+    int16_t src1[32];
+    int16_t src2[32];
+
+    for (unsigned i = 0; i < 32; i++) {
+        src1[i] = SeededValue(0, i, -INPUT_RANGE, INPUT_RANGE);
+        src2[i] = SeededValue(1, i, -INPUT_RANGE, INPUT_RANGE);
+    }
+
+    return RunChains<P>(
+        params.Steps, _mm512_loadu_si512(src1), _mm512_loadu_si512(src2), _mm512_setzero_si512(),
+        [](__m512i c, __m512i a, __m512i b) { return _mm512_dpwssd_epi32(c, b, a); }, 4 * 16);
+}
+#endif
+
+void
+RegisterOpsKernels(std::vector<Kernel> &registry) {
+#if AMX_S8_S32_SUPPORT
+    registry.push_back({"amx_s8_s32", "ops", amx_s8_s32_support,
+                        [](const KernelParams &p) { return amx_s8_s32(p.Steps); },
+                        VerifyAmxS8S32, 32768 /* 128 x 16 x 16 */});
+#endif
+#if AMX_BF16_F32_SUPPORT
+    registry.push_back({"amx_bf16_f32", "ops", amx_bf16_f32_support,
+                        [](const KernelParams &p) { return amx_bf16_f32(p.Steps); },
+                        VerifyAmxBF16F32, 16384 /* 64 x 16 x 16 */});
+#endif
+#if VNN_S8_S32_SUPPORT
+    registry.push_back({"vnn_s8_s32", "ops", vnn_s8_s32_support,
+                        [](const KernelParams &p) { return vnn_s8_s32(p.Steps); },
+                        VerifyVnnS8S32, 128 /* 8 x 16 */});
+#endif
+#if VNN_F16_F32_SUPPORT
+    registry.push_back({"vnn_f16_f32", "ops", vnn_f16_f32_support,
+                        [](const KernelParams &p) { return vnn_f16_f32(p.Steps); },
+                        VerifyVnnF16F32, 64 /* 4 x 16 */});
+#endif
+    /* Independent chains, alone and paired with loads or FMAs, for the instruction table */
+#if AMX_S8_S32_SUPPORT
+    registry.push_back({"amx_s8_s32_tput", "ops", amx_s8_s32_support,
+                        AmxS8S32Chains<Pairing::None>, VerifyAmxS8S32, 32768});
+    registry.push_back({"amx_s8_s32_load", "ops", amx_s8_s32_support,
+                        AmxS8S32Chains<Pairing::Load>, VerifyAmxS8S32, 32768});
+    registry.push_back({"amx_s8_s32_fma", "ops", amx_s8_s32_support,
+                        AmxS8S32Chains<Pairing::Fma>, VerifyAmxS8S32, 32768});
+#endif
+#if AMX_BF16_F32_SUPPORT
+    registry.push_back({"amx_bf16_f32_tput", "ops", amx_bf16_f32_support,
+                        AmxBF16F32Chains<Pairing::None>, VerifyAmxBF16F32, 16384});
+    registry.push_back({"amx_bf16_f32_load", "ops", amx_bf16_f32_support,
+                        AmxBF16F32Chains<Pairing::Load>, VerifyAmxBF16F32, 16384});
+    registry.push_back({"amx_bf16_f32_fma", "ops", amx_bf16_f32_support,
+                        AmxBF16F32Chains<Pairing::Fma>, VerifyAmxBF16F32, 16384});
+#endif
+#if VNN_S8_S32_SUPPORT
+    registry.push_back({"vnn_s8_s32_tput", "ops", vnn_s8_s32_support,
+                        VnnS8S32Chains<Pairing::None>, VerifyVnnS8S32, 128});
+    registry.push_back({"vnn_s8_s32_load", "ops", vnn_s8_s32_support,
+                        VnnS8S32Chains<Pairing::Load>, VerifyVnnS8S32, 128});
+    registry.push_back({"vnn_s8_s32_fma", "ops", vnn_s8_s32_support,
+                        VnnS8S32Chains<Pairing::Fma>, VerifyVnnS8S32, 128});
+#endif
+#if VNN_F16_F32_SUPPORT
+    registry.push_back({"vnn_f16_f32_tput", "ops", vnn_f16_f32_support,
+                        VnnF16F32Chains<Pairing::None>, VerifyVnnF16F32, 64});
+    registry.push_back({"vnn_f16_f32_load", "ops", vnn_f16_f32_support,
+                        VnnF16F32Chains<Pairing::Load>, VerifyVnnF16F32, 64});
+    registry.push_back({"vnn_f16_f32_fma", "ops", vnn_f16_f32_support,
+                        VnnF16F32Chains<Pairing::Fma>, VerifyVnnF16F32, 64});
+#endif
+}
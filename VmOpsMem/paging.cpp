@@ -0,0 +1,385 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "vmopsmem_export.h"
+
+/* Mapping the fault kernel touches before unmapping it and mapping the next one */
+#define VM_FAULT_REGION (64ull * 1024 * 1024)
+
+static uint64_t
+PageSize() {
+    static const uint64_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+/* PMD size of transparent huge pages, 0 when they are disabled */
+static uint64_t
+HugePageSize() {
+    static const uint64_t size = []() -> uint64_t {
+        char line[256] = {};
+        FILE *file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (file == nullptr) {
+            return 0;
+        }
+        bool enabled = fgets(line, sizeof(line), file) != nullptr &&
+                       std::strstr(line, "[never]") == nullptr;
+        fclose(file);
+
+        unsigned long long bytes = 0;
+        file = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+        if (file == nullptr) {
+            return 0;
+        }
+        if (fscanf(file, "%llu", &bytes) != 1) {
+            bytes = 0;
+        }
+        fclose(file);
+        return enabled ? bytes : 0;
+    }();
+    return size;
+}
+
+/* A mapping aligned to its page size, huge pages are requested with MADV_HUGEPAGE */
+struct Mapping {
+    uint8_t *Base = nullptr;
+    uint64_t Length = 0;
+    uint8_t *Data = nullptr;
+};
+
+template <bool Huge>
+static Mapping
+MapRegion(uint64_t bytes) {
+    uint64_t align = Huge ? HugePageSize() : PageSize();
+
+    Mapping m;
+    m.Length = bytes + (Huge ? align : 0);
+    void *base = mmap(nullptr, m.Length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                      0);
+    if (base == MAP_FAILED) {
+        return Mapping{};
+    }
+    m.Base = (uint8_t *) base;
+    m.Data = (uint8_t *) (((uintptr_t) base + align - 1) & ~(uintptr_t) (align - 1));
+    if (Huge) {
+        madvise(m.Data, bytes, MADV_HUGEPAGE);
+    }
+    return m;
+}
+
+/* AnonHugePages of the mapping holding addr, what THP actually backed of it */
+static uint64_t
+HugeBackedBytes(const void *addr) {
+    FILE *file = fopen("/proc/self/smaps", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+
+    char line[256];
+    bool inside = false;
+    uint64_t bytes = 0;
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        unsigned long long begin = 0, end = 0, kb = 0;
+        if (sscanf(line, "%llx-%llx ", &begin, &end) == 2) {
+            inside = begin <= (uintptr_t) addr && (uintptr_t) addr < end;
+        } else if (inside && sscanf(line, "AnonHugePages: %llu kB", &kb) == 1) {
+            bytes = kb * 1024;
+            break;
+        }
+    }
+    fclose(file);
+    return bytes;
+}
+
+/* One write per page, every one of them is a first-touch fault */
+static uint64_t
+TouchPages(uint8_t *data, uint64_t pages, uint64_t page, uint64_t value) {
+    for (uint64_t i = 0; i < pages; i++) {
+        *(volatile uint64_t *) (data + i * page) = value + i;
+    }
+    return pages;
+}
+
+template <bool Huge>
+static uint64_t
+RegionBytes(uint64_t bytes, uint64_t fallback) {
+    uint64_t page = Huge ? HugePageSize() : PageSize();
+    bytes = bytes != 0 ? bytes : fallback;
+    return std::max<uint64_t>((bytes + page - 1) / page, 1) * page;
+}
+
+template <bool Huge>
+static Result
+FaultKernel(uint64_t bytes, uint64_t steps, bool verify = false) {
+    uint64_t page = Huge ? HugePageSize() : PageSize();
+    bytes = RegionBytes<Huge>(bytes, VM_FAULT_REGION);
+
+    uint64_t faults = 0;
+    uint64_t backing[2] = {}; /* huge page backed and touched bytes of the first mapping */
+    std::chrono::nanoseconds duration{};
+
+    /* Steps are faults, spread over as many fresh mappings as they need */
+    while (faults < steps) {
+        Mapping m = MapRegion<Huge>(bytes);
+        if (m.Base == nullptr) {
+            return Result{};
+        }
+        uint64_t pages = std::min(bytes / page, steps - faults);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        faults += TouchPages(m.Data, pages, page, faults);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        duration += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+        /* MADV_HUGEPAGE is a hint, fragmented memory or the defrag policy fall back to 4K.
+         * Reading smaps takes the mm lock, timed runs of other threads must not wait for it */
+        if (Huge && verify && faults == pages) {
+            backing[0] = HugeBackedBytes(m.Data);
+            backing[1] = pages * page;
+        }
+
+        munmap(m.Base, m.Length);
+    }
+
+    auto r = Result{duration.count(), faults};
+    std::memcpy(r.Output, &faults, sizeof(faults));
+    std::memcpy(r.Output + sizeof(faults), backing, sizeof(backing));
+    return r;
+}
+
+/* Every page of the huge fault kernel was a huge page, or it measured 4K faults. Unchecked
+ * runs gather no backing and match */
+static int32_t
+VerifyHugeBacking(uint64_t steps, const Result &result) {
+    uint64_t backing[2];
+    std::memcpy(backing, result.Output + sizeof(uint64_t), sizeof(backing));
+    return backing[0] >= backing[1] ? VERIFY_MATCH : VERIFY_MISMATCH;
+}
+
+/* Map, fault in and unmap, the unmap flushes the TLB of every core running this process */
+template <bool Huge>
+static Result
+MapKernel(uint64_t bytes, uint64_t steps) {
+    uint64_t page = Huge ? HugePageSize() : PageSize();
+    bytes = RegionBytes<Huge>(bytes, page);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t k = 0; k < steps; k++) {
+        Mapping m = MapRegion<Huge>(bytes);
+        if (m.Base == nullptr) {
+            return Result{};
+        }
+        TouchPages(m.Data, bytes / page, page, k);
+        munmap(m.Base, m.Length);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps /* mmap and munmap pairs */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &ops, sizeof(ops));
+    return r;
+}
+
+/* The way allocators hand memory back: fault the range in, then drop it with MADV_DONTNEED */
+template <bool Huge>
+static Result
+MadviseKernel(uint64_t bytes, uint64_t steps) {
+    uint64_t page = Huge ? HugePageSize() : PageSize();
+    bytes = RegionBytes<Huge>(bytes, page);
+
+    Mapping m = MapRegion<Huge>(bytes);
+    if (m.Base == nullptr) {
+        return Result{};
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t k = 0; k < steps; k++) {
+        TouchPages(m.Data, bytes / page, page, k);
+        madvise(m.Data, bytes, MADV_DONTNEED);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    munmap(m.Base, m.Length);
+
+    uint64_t ops = steps /* madvise calls */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &ops, sizeof(ops));
+    return r;
+}
+
+static int64_t
+Now() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+/* Phases of the shootdown probe, the responders file their stalls under the current one */
+#define SHOOTDOWN_BASELINE 0
+#define SHOOTDOWN_FLUSH    1
+#define SHOOTDOWN_DONE     2
+
+/* Unmaps one page per call for the whole phase, touched pages leave TLB entries to flush */
+static void
+UnmapLoop(bool touch, int64_t duration, uint64_t &unmaps, int64_t &time) {
+    uint64_t page = PageSize();
+    int64_t end = Now() + duration;
+    while (Now() < end) {
+        void *data = mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                          0);
+        if (data == MAP_FAILED) {
+            return;
+        }
+        if (touch) {
+            *(volatile uint64_t *) data = unmaps;
+        }
+
+        int64_t start = Now();
+        munmap(data, page);
+        time += Now() - start;
+        unmaps++;
+    }
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+vm_fault_support() {
+    return 1;
+}
+
+VMOPSMEM_EXPORT int32_t
+vm_huge_support() {
+    return HugePageSize() != 0;
+}
+
+VMOPSMEM_EXPORT Result
+vm_fault(uint64_t bytes, uint64_t steps) {
+    return FaultKernel<false>(bytes, steps);
+}
+
+VMOPSMEM_EXPORT Result
+vm_fault_huge(uint64_t bytes, uint64_t steps) {
+    return FaultKernel<true>(bytes, steps);
+}
+
+VMOPSMEM_EXPORT Result
+vm_map(uint64_t bytes, uint64_t steps) {
+    return MapKernel<false>(bytes, steps);
+}
+
+VMOPSMEM_EXPORT Result
+vm_map_huge(uint64_t bytes, uint64_t steps) {
+    return MapKernel<true>(bytes, steps);
+}
+
+VMOPSMEM_EXPORT Result
+vm_madvise(uint64_t bytes, uint64_t steps) {
+    return MadviseKernel<false>(bytes, steps);
+}
+
+VMOPSMEM_EXPORT Result
+vm_madvise_huge(uint64_t bytes, uint64_t steps) {
+    return MadviseKernel<true>(bytes, steps);
+}
+
+VMOPSMEM_EXPORT ShootdownResult
+tlb_shootdown(int32_t initiator, const int32_t *responders, unsigned count, int64_t duration,
+              int64_t threshold) {
+    ShootdownResult r{};
+    r.Responders = count;
+
+    std::atomic<unsigned> ready{0};
+    std::atomic<int32_t> phase{SHOOTDOWN_BASELINE};
+    std::vector<uint64_t> stalls(2 * count);
+    std::vector<int64_t> stallTime(2 * count);
+
+    /* Responders only read the clock, any gap is time the core spent elsewhere */
+    std::vector<std::thread> threads;
+    threads.reserve(count + 1);
+    for (unsigned i = 0; i < count; i++) {
+        threads.emplace_back([&, i]() {
+            set_thread_affinity(responders[i]);
+            ready.fetch_add(1);
+
+            int64_t prev = Now();
+            int32_t current;
+            while ((current = phase.load(std::memory_order_relaxed)) != SHOOTDOWN_DONE) {
+                int64_t now = Now();
+                int64_t gap = now - prev;
+                prev = now;
+                if (gap >= threshold) {
+                    stalls[2 * i + current]++;
+                    stallTime[2 * i + current] += gap;
+                }
+            }
+        });
+    }
+
+    /* A thread of its own, the caller's affinity is never touched */
+    threads.emplace_back([&]() {
+        set_thread_affinity(initiator);
+        while (ready.load() < count) {
+            std::this_thread::yield();
+        }
+
+        UnmapLoop(false, duration, r.BaselineUnmaps, r.BaselineTime);
+        phase.store(SHOOTDOWN_FLUSH);
+        UnmapLoop(true, duration, r.Unmaps, r.UnmapTime);
+        phase.store(SHOOTDOWN_DONE);
+    });
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        r.BaselineStalls += stalls[2 * i + SHOOTDOWN_BASELINE];
+        r.BaselineStallTime += stallTime[2 * i + SHOOTDOWN_BASELINE];
+        r.Stalls += stalls[2 * i + SHOOTDOWN_FLUSH];
+        r.StallTime += stallTime[2 * i + SHOOTDOWN_FLUSH];
+    }
+    return r;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterPagingKernels(std::vector<Kernel> &registry) {
+    registry.push_back({"vm_fault", "faults", vm_fault_support,
+                        [](const KernelParams &p) { return vm_fault(p.Bytes, p.Steps); }});
+    registry.push_back({"vm_fault_huge", "faults", vm_huge_support,
+                        [](const KernelParams &p) {
+                            return FaultKernel<true>(p.Bytes, p.Steps, p.Verify);
+                        },
+                        VerifyHugeBacking});
+    registry.push_back({"vm_map", "ops", vm_fault_support,
+                        [](const KernelParams &p) { return vm_map(p.Bytes, p.Steps); }});
+    registry.push_back({"vm_map_huge", "ops", vm_huge_support,
+                        [](const KernelParams &p) { return vm_map_huge(p.Bytes, p.Steps); }});
+    registry.push_back({"vm_madvise", "ops", vm_fault_support,
+                        [](const KernelParams &p) { return vm_madvise(p.Bytes, p.Steps); }});
+    registry.push_back({"vm_madvise_huge", "ops", vm_huge_support,
+                        [](const KernelParams &p) { return vm_madvise_huge(p.Bytes, p.Steps); }});
+}
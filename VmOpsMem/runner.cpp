@@ -0,0 +1,260 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "vmopsmem_export.h"
+
+/* Calibration calls shorter than this are dominated by timer and setup noise */
+#define CALIBRATE_MIN_TIME  1000000
+#define CALIBRATE_MAX_STEPS (1ull << 40)
+
+/* Best of several calls, the minimum filters out preemption and frequency ramps */
+#define INST_TIME_SAMPLES 5
+
+std::vector<Kernel> kernels;
+int64_t sample_time = DEFAULT_SAMPLE_TIME;
+
+const Kernel *
+FindKernel(const char *name) {
+    if (name == nullptr) {
+        return nullptr;
+    }
+
+    for (const Kernel &kernel : kernels) {
+        if (std::strcmp(kernel.Name, name) == 0) {
+            return &kernel;
+        }
+    }
+    return nullptr;
+}
+
+uint64_t
+CalibrateSteps(const Kernel &kernel, KernelParams params, int64_t target) {
+    params.Steps = 1;
+
+    while (true) {
+        Result r = kernel.Run(params);
+        if (r.Time >= CALIBRATE_MIN_TIME || params.Steps >= CALIBRATE_MAX_STEPS) {
+            double scale = (double) target / std::max<int64_t>(r.Time, 1);
+            return std::max<uint64_t>(1, params.Steps * scale);
+        }
+
+        /* Grow geometrically, but jump straight to the right magnitude for fast kernels */
+        uint64_t growth = CALIBRATE_MIN_TIME / std::max<int64_t>(r.Time, 1);
+        params.Steps *= std::clamp<uint64_t>(growth, 2, 1024);
+    }
+}
+
+static void
+RunUntil(const Kernel &kernel, const KernelParams &params, const std::atomic<int32_t> &stop,
+         KernelJob &job) {
+    job.Time = job.Elapsed = job.DiscardedTime = job.LostTime = 0;
+    job.Ops = job.Iterations = job.Cycles = job.Preempted = job.Discarded = job.Mismatches = 0;
+
+    /* Run whole chunks so every sample has the same length, at least one of them */
+    do {
+        SchedStats statsStart = sched_stats();
+        CpuResult timeStart = cpu_time();
+        Result r = kernel.Run(params);
+        CpuResult timeEnd = cpu_time();
+        SchedStats statsEnd = sched_stats();
+
+        if (job.Verify && kernel.Verify != nullptr &&
+            kernel.Verify(params.Steps, r) == VERIFY_MISMATCH) {
+            job.Mismatches++;
+        }
+
+        /* Waiting on the run queue or stolen by the hypervisor, a tick is not worth a discard */
+        int64_t elapsed = timeEnd.Time - timeStart.Time;
+        int64_t lost = (statsEnd.WaitTime - statsStart.WaitTime) +
+                       (statsEnd.StealTime - statsStart.StealTime);
+        bool preempted = lost > PREEMPTED_FRACTION * elapsed;
+        job.Preempted += preempted;
+        job.LostTime += lost;
+        if (preempted && job.Discard) {
+            job.Discarded++;
+            job.DiscardedTime += r.Time;
+            continue;
+        }
+
+        job.Time += r.Time;
+        job.Ops += r.Ops;
+        job.Cycles += timeEnd.Cycles - timeStart.Cycles;
+        job.Elapsed += elapsed;
+        job.Iterations++;
+    } while (!stop.load(std::memory_order_relaxed));
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern VMOPSMEM_EXPORT void set_thread_affinity(int coreId);
+extern VMOPSMEM_EXPORT void set_thread_priority();
+
+VMOPSMEM_EXPORT unsigned
+kernel_count() {
+    return kernels.size();
+}
+
+VMOPSMEM_EXPORT const char *
+kernel_name(unsigned index) {
+    if (index >= kernels.size()) {
+        return nullptr;
+    }
+    return kernels[index].Name;
+}
+
+VMOPSMEM_EXPORT const char *
+kernel_unit(const char *name) {
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr) {
+        return nullptr;
+    }
+    return kernel->Unit;
+}
+
+VMOPSMEM_EXPORT int32_t
+kernel_support(const char *name) {
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr) {
+        return 0;
+    }
+    return kernel->Support();
+}
+
+VMOPSMEM_EXPORT uint64_t
+kernel_ops_per_inst(const char *name) {
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr) {
+        return 0;
+    }
+    return kernel->OpsPerInst;
+}
+
+VMOPSMEM_EXPORT uint64_t
+kernel_ops_per_elem(const char *name) {
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr) {
+        return 0;
+    }
+    return kernel->OpsPerElem;
+}
+
+VMOPSMEM_EXPORT double
+kernel_inst_time(const char *name) {
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr || !kernel->Support() || kernel->OpsPerInst == 0) {
+        return 0;
+    }
+
+    KernelParams params{};
+    params.Steps = CalibrateSteps(*kernel, params, sample_time);
+
+    double best = 0;
+    for (unsigned i = 0; i < INST_TIME_SAMPLES; i++) {
+        Result r = kernel->Run(params);
+        if (r.Ops == 0) {
+            continue;
+        }
+
+        /* ns per instruction, the kernel counts ops rather than instructions */
+        double time = (double) r.Time * kernel->OpsPerInst / r.Ops;
+        if (best == 0 || time < best) {
+            best = time;
+        }
+    }
+    return best;
+}
+
+VMOPSMEM_EXPORT Result
+run_kernel(const char *name, const KernelParams *params) {
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr || !kernel->Support()) {
+        return Result{};
+    }
+    return kernel->Run(*params);
+}
+
+VMOPSMEM_EXPORT void
+set_sample_time(int64_t time) {
+    sample_time = time > 0 ? time : DEFAULT_SAMPLE_TIME;
+}
+
+VMOPSMEM_EXPORT uint64_t
+calibrate_steps(const char *name, const KernelParams *params) {
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr || !kernel->Support()) {
+        return 0;
+    }
+    return CalibrateSteps(*kernel, *params, sample_time);
+}
+
+VMOPSMEM_EXPORT int32_t
+run_kernels(KernelJob *jobs, unsigned count) {
+    std::vector<const Kernel *> selected(count);
+    for (unsigned i = 0; i < count; i++) {
+        selected[i] = FindKernel(jobs[i].Name);
+        if (selected[i] == nullptr || !selected[i]->Support()) {
+            return -1;
+        }
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    /* All threads are pinned (and calibrated) before any of them starts its kernel */
+    std::atomic<unsigned> ready{0};
+    std::atomic<int32_t> stop{0};
+    std::vector<std::thread> threads;
+    threads.reserve(count);
+
+    for (unsigned i = 0; i < count; i++) {
+        threads.emplace_back([&, i]() {
+            KernelJob &job = jobs[i];
+            set_thread_affinity(job.CoreId);
+            set_thread_priority();
+
+            KernelParams params{job.Steps, job.Bytes, job.Flush, job.Pattern, job.Chains,
+                                job.Walk, job.Stride, job.Prefetch, job.Verify};
+            if (params.Steps == 0) {
+                params.Steps = CalibrateSteps(*selected[i], params, sample_time);
+                job.Steps = params.Steps;
+            }
+
+            ready.fetch_add(1);
+            while (ready.load() < count) {
+                std::this_thread::yield();
+            }
+
+            RunUntil(*selected[i], params, stop, job);
+        });
+    }
+
+    /* A single deadline for every job, so all cores stop together */
+    int64_t duration = 0;
+    for (unsigned i = 0; i < count; i++) {
+        duration = std::max(duration, jobs[i].Duration);
+    }
+
+    while (ready.load() < count) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::nanoseconds(duration));
+    stop.store(1, std::memory_order_relaxed);
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,178 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "vmopsmem_export.h"
+
+static int64_t
+Now() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+static long
+Futex(std::atomic<uint32_t> *word, int op, uint32_t value) {
+    return syscall(SYS_futex, (uint32_t *) word, op, value, nullptr, nullptr, 0);
+}
+
+template <typename Call>
+static Result
+SyscallKernel(uint64_t steps, Call call) {
+    long value = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t k = 0; k < steps; k++) {
+        value += call();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    uint64_t ops = steps /* syscalls */;
+
+    auto r = Result{duration.count(), ops};
+    std::memcpy(r.Output, &value, sizeof(value));
+    return r;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT int32_t
+sys_support() {
+    return 1;
+}
+
+/* Raw syscall, glibc no longer caches the pid but other libcs may */
+VMOPSMEM_EXPORT Result
+sys_getpid(uint64_t steps) {
+    return SyscallKernel(steps, []() { return syscall(SYS_getpid); });
+}
+
+/* Nothing else runnable on the pinned core, the scheduler returns straight away */
+VMOPSMEM_EXPORT Result
+sys_sched_yield(uint64_t steps) {
+    return SyscallKernel(steps, []() { return (long) sched_yield(); });
+}
+
+/* A wake without waiters, the futex hash lookup and nothing else */
+VMOPSMEM_EXPORT Result
+sys_futex_wake(uint64_t steps) {
+    std::atomic<uint32_t> word{0};
+    return SyscallKernel(steps, [&]() { return Futex(&word, FUTEX_WAKE_PRIVATE, 1); });
+}
+
+VMOPSMEM_EXPORT PingPongResult
+futex_pingpong(int32_t first, int32_t second, int64_t duration, uint64_t *histogram,
+               unsigned buckets) {
+    PingPongResult r{};
+    r.MinWake = INT64_MAX;
+
+    /* Whose turn it is, the other thread sleeps on the word until it flips */
+    std::atomic<uint32_t> turn{0};
+    std::atomic<int64_t> stamp{0};
+    std::atomic<int32_t> stop{0};
+    std::atomic<unsigned> ready{0};
+
+    std::vector<uint64_t> counts(2 * buckets);
+    int64_t wakeups[2] = {}, wakeTime[2] = {}, minWake[2] = {INT64_MAX, INT64_MAX},
+            maxWake[2] = {};
+
+    auto player = [&](unsigned self, int32_t core) {
+        set_thread_affinity(core);
+        set_thread_priority();
+        ready.fetch_add(1);
+        while (ready.load() < 2) {
+            std::this_thread::yield();
+        }
+
+        int64_t end = Now() + duration; /* the first player decides when to stop */
+        while (true) {
+            uint32_t current;
+            while ((current = turn.load()) != self && !stop.load()) {
+                Futex(&turn, FUTEX_WAIT_PRIVATE, current);
+            }
+            if (stop.load()) {
+                break;
+            }
+
+            /* One way: from the other side's wake call to this side running again */
+            int64_t now = Now();
+            if (int64_t sent = stamp.load(); sent != 0) {
+                int64_t wake = now - sent;
+                wakeups[self]++;
+                wakeTime[self] += wake;
+                minWake[self] = std::min(minWake[self], wake);
+                maxWake[self] = std::max(maxWake[self], wake);
+
+                /* log2 buckets of the wake-up latency in ns */
+                unsigned bucket = 63 - __builtin_clzll((uint64_t) wake | 1);
+                if (buckets > 0) {
+                    counts[self * buckets + std::min(bucket, buckets - 1)]++;
+                }
+            }
+
+            /* The turn flips on the way out too, or the other side could sleep through it */
+            if (self == 0 && now >= end) {
+                stop.store(1);
+                turn.store(1 - self);
+                Futex(&turn, FUTEX_WAKE_PRIVATE, 1);
+                break;
+            }
+
+            stamp.store(Now());
+            turn.store(1 - self);
+            Futex(&turn, FUTEX_WAKE_PRIVATE, 1);
+        }
+    };
+
+    int64_t start = Now();
+    std::thread a(player, 0, first);
+    std::thread b(player, 1, second);
+    a.join();
+    b.join();
+    r.Time = Now() - start;
+
+    for (unsigned self = 0; self < 2; self++) {
+        r.Wakeups += wakeups[self];
+        r.WakeTime += wakeTime[self];
+        r.MinWake = std::min(r.MinWake, minWake[self]);
+        r.MaxWake = std::max(r.MaxWake, maxWake[self]);
+    }
+    if (r.Wakeups == 0) {
+        r.MinWake = 0;
+    }
+
+    for (unsigned i = 0; histogram != nullptr && i < buckets; i++) {
+        histogram[i] = counts[i] + counts[buckets + i];
+    }
+    return r;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+void
+RegisterSyscallKernels(std::vector<Kernel> &registry) {
+    registry.push_back({"sys_getpid", "calls", sys_support,
+                        [](const KernelParams &p) { return sys_getpid(p.Steps); }, nullptr, 1});
+    registry.push_back({"sys_sched_yield", "calls", sys_support,
+                        [](const KernelParams &p) { return sys_sched_yield(p.Steps); }, nullptr,
+                        1});
+    registry.push_back({"sys_futex_wake", "calls", sys_support,
+                        [](const KernelParams &p) { return sys_futex_wake(p.Steps); }, nullptr,
+                        1});
+}
@@ -0,0 +1,251 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#define TOPOLOGY_CACHE_VERSION 1
+
+#define FNV_OFFSET 0xCBF29CE484222325ull
+#define FNV_PRIME  0x100000001B3ull
+
+/* Of the CPUs InitTopology found, every cache file is keyed on it */
+static uint64_t cache_fingerprint = 0;
+
+static uint64_t
+Fnv1a(uint64_t hash, const std::string &text) {
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * FNV_PRIME;
+    }
+    return (hash ^ 0xFF) * FNV_PRIME;
+}
+
+static std::string
+ReadFirstLine(const char *path) {
+    char line[256] = {};
+    FILE *file = fopen(path, "r");
+    if (file != nullptr) {
+        if (fgets(line, sizeof(line), file) == nullptr) {
+            line[0] = '\0';
+        }
+        fclose(file);
+    }
+    return line;
+}
+
+/* CPUs this process may run on: the cpuset of its cgroup, minus offline CPUs */
+static std::vector<unsigned>
+AllowedCpus() {
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    unsigned count = std::max<long>(configured, CPU_SETSIZE);
+
+    cpu_set_t *mask = CPU_ALLOC(count);
+    size_t size = CPU_ALLOC_SIZE(count);
+    CPU_ZERO_S(size, mask);
+
+    std::vector<unsigned> cpus;
+    if (sched_getaffinity(0, size, mask) == 0) {
+        for (unsigned cpu = 0; cpu < count; cpu++) {
+            if (CPU_ISSET_S(cpu, size, mask)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    CPU_FREE(mask);
+    return cpus;
+}
+
+/* Topology changes with the boot (resize), the CPU model or the cpuset. Live migration keeps
+ * the boot, only the model tells another host type apart */
+static uint64_t
+TopologyFingerprint(const std::vector<unsigned> &cpus) {
+    uint64_t hash = Fnv1a(FNV_OFFSET, std::to_string(TOPOLOGY_CACHE_VERSION));
+    hash = Fnv1a(hash, std::to_string(CpuModel()));
+
+    utsname name{};
+    if (uname(&name) == 0) {
+        hash = Fnv1a(hash, name.nodename);
+        hash = Fnv1a(hash, name.release);
+        hash = Fnv1a(hash, name.machine);
+    }
+    hash = Fnv1a(hash, ReadFirstLine("/proc/sys/kernel/random/boot_id"));
+
+    for (unsigned cpu : cpus) {
+        hash = Fnv1a(hash, std::to_string(cpu));
+    }
+    return hash;
+}
+
+/* One file per kind, "" without a home or with VMOPSMEM_NO_CACHE set to anything but 0 */
+std::string
+CachePath(const char *kind) {
+    const char *off = getenv("VMOPSMEM_NO_CACHE");
+    if (off != nullptr && off[0] != '\0' && std::strcmp(off, "0") != 0) {
+        return "";
+    }
+
+    std::string dir;
+    if (const char *cache = getenv("XDG_CACHE_HOME"); cache != nullptr && cache[0] != '\0') {
+        dir = cache;
+    } else if (const char *home = getenv("HOME"); home != nullptr && home[0] != '\0') {
+        dir = std::string(home) + "/.cache";
+    } else {
+        return "";
+    }
+    dir += "/vmopsmem";
+
+    char name[64];
+    snprintf(name, sizeof(name), "/%s-%016llx", kind, (unsigned long long) cache_fingerprint);
+    return dir + name;
+}
+
+static bool
+LoadTopology(const std::string &path, const std::vector<unsigned> &cpus,
+             std::vector<LogicalCore> &cores) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+
+    cores.clear();
+    LogicalCore core{};
+    while (fscanf(file, "%u %u %u %u", &core.Index, &core.PackageID, &core.CoreID,
+                  &core.ThreadID) == 4) {
+        cores.push_back(core);
+    }
+    fclose(file);
+
+    /* A stale or truncated file falls back to probing */
+    if (cores.size() != cpus.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < cores.size(); i++) {
+        if (cores[i].Index != cpus[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Concurrent init() calls each write their own file and the last rename wins */
+void
+SaveCache(const std::string &path, const std::string &contents) {
+    std::string dir = path.substr(0, path.rfind('/'));
+    mkdir(dir.substr(0, dir.rfind('/')).c_str(), 0755);
+    mkdir(dir.c_str(), 0755);
+
+    std::string temp = path + "." + std::to_string(getpid());
+    FILE *file = fopen(temp.c_str(), "w");
+    if (file == nullptr) {
+        return;
+    }
+    fputs(contents.c_str(), file);
+    if (fclose(file) != 0 || rename(temp.c_str(), path.c_str()) != 0) {
+        unlink(temp.c_str());
+        return;
+    }
+
+    /* Files of earlier boots are never read again, a file being written for this one stays */
+    std::string keep = path.substr(path.rfind('/') + 1);
+    std::string kind = keep.substr(0, keep.rfind('-') + 1);
+    if (DIR *entries = opendir(dir.c_str()); entries != nullptr) {
+        while (dirent *entry = readdir(entries)) {
+            std::string name = entry->d_name;
+            if (name.rfind(kind, 0) == 0 && name.rfind(keep, 0) != 0) {
+                unlink((dir + "/" + name).c_str());
+            }
+        }
+        closedir(entries);
+    }
+}
+
+static void
+SaveTopology(const std::string &path, const std::vector<LogicalCore> &cores) {
+    std::string contents;
+    for (const LogicalCore &core : cores) {
+        char line[64];
+        snprintf(line, sizeof(line), "%u %u %u %u\n", core.Index, core.PackageID, core.CoreID,
+                 core.ThreadID);
+        contents += line;
+    }
+    SaveCache(path, contents);
+}
+
+static std::vector<LogicalCore>
+ProbeTopology(const std::vector<unsigned> &cpus) {
+    std::vector<LogicalCore> probed(cpus.size());
+    std::vector<char> valid(cpus.size());
+
+    /* One short-lived pinned thread per CPU, the caller's affinity is never touched */
+    std::vector<std::thread> threads;
+    threads.reserve(cpus.size());
+    for (size_t i = 0; i < cpus.size(); i++) {
+        threads.emplace_back([&, i]() {
+            cpu_set_t *mask = CPU_ALLOC(cpus[i] + 1);
+            size_t size = CPU_ALLOC_SIZE(cpus[i] + 1);
+            CPU_ZERO_S(size, mask);
+            CPU_SET_S(cpus[i], size, mask);
+            bool pinned = pthread_setaffinity_np(pthread_self(), size, mask) == 0 &&
+                          sched_getcpu() == (int) cpus[i];
+            CPU_FREE(mask);
+            if (!pinned) {
+                return;
+            }
+
+            probed[i].Index = cpus[i];
+            MapCpuTopology(probed[i]);
+            valid[i] = 1;
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    /* CPUs that went offline since the affinity was read are dropped */
+    std::vector<LogicalCore> cores;
+    for (size_t i = 0; i < cpus.size(); i++) {
+        if (valid[i]) {
+            cores.push_back(probed[i]);
+        }
+    }
+    return cores;
+}
+
+void
+InitTopology() {
+    std::vector<unsigned> cpus = AllowedCpus();
+    cache_fingerprint = TopologyFingerprint(cpus);
+    std::string path = CachePath("topology");
+
+    if (!path.empty() && LoadTopology(path, cpus, processors)) {
+        return;
+    }
+
+    processors = ProbeTopology(cpus);
+    if (!path.empty() && processors.size() == cpus.size()) {
+        SaveTopology(path, processors);
+    }
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT unsigned
+logical_core_count() {
+    return processors.size();
+}
+
+#ifdef __cplusplus
+}
+#endif
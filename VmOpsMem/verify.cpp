@@ -0,0 +1,130 @@
+#include "vm_ops_mem.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "vmopsmem_export.h"
+
+/* Exact integer range of the accumulator type (fp32 24 bits, fp16 11 bits) */
+#define F32_EXACT_LIMIT (1ll << 24)
+#define F16_EXACT_LIMIT (1ll << 11)
+
+uint64_t input_seed = 0x5EED;
+
+float
+HalfToFloat(uint16_t bits) {
+    int exponent = (bits >> 10) & 0x1F;
+    int mantissa = bits & 0x3FF;
+    float value;
+
+    if (exponent == 0) {
+        value = std::ldexp((float) mantissa, -24);
+    } else if (exponent == 0x1F) {
+        value = mantissa ? NAN : INFINITY;
+    } else {
+        value = std::ldexp((float) (mantissa | 0x400), exponent - 25);
+    }
+
+    return (bits & 0x8000) ? -value : value;
+}
+
+int32_t
+SeededValue(uint64_t stream, uint64_t index, int32_t lo, int32_t hi) {
+    /* splitmix64 over (seed, stream, index) */
+    uint64_t z = input_seed + stream * 0x9E3779B97F4A7C15ull + (index + 1) * 0xD1B54A32D192ED03ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z = z ^ (z >> 31);
+
+    return lo + (int32_t) (z % (uint64_t) (hi - lo + 1));
+}
+
+int32_t
+VerifyIntOutput(const Result &result, const std::vector<int64_t> &dots, unsigned width,
+                uint64_t steps) {
+    for (size_t i = 0; i < dots.size(); i++) {
+        /* Accumulators wrap around, so compare modulo 2^(8 * width) */
+        uint64_t mask = width >= 8 ? ~0ull : (1ull << (8 * width)) - 1;
+        uint64_t expected = (steps * (uint64_t) dots[i]) & mask;
+
+        uint64_t value = 0;
+        std::memcpy(&value, result.Output + i * width, width);
+
+        if (value != expected) {
+            return VERIFY_MISMATCH;
+        }
+    }
+    return VERIFY_MATCH;
+}
+
+int32_t
+VerifyFloatOutput(const Result &result, const std::vector<int64_t> &dots,
+                  const std::vector<int64_t> &bounds, unsigned width, uint64_t steps) {
+    int64_t limit = width == sizeof(uint16_t) ? F16_EXACT_LIMIT : F32_EXACT_LIMIT;
+
+    for (size_t i = 0; i < dots.size(); i++) {
+        /* Every partial sum must stay an exactly representable integer */
+        if (bounds[i] != 0 && steps > (uint64_t) (limit / bounds[i])) {
+            return VERIFY_UNCHECKED;
+        }
+    }
+
+    for (size_t i = 0; i < dots.size(); i++) {
+        float expected = (float) ((int64_t) steps * dots[i]);
+
+        float value;
+        if (width == sizeof(uint16_t)) {
+            uint16_t bits;
+            std::memcpy(&bits, result.Output + i * width, sizeof(bits));
+            value = HalfToFloat(bits);
+        } else {
+            std::memcpy(&value, result.Output + i * width, sizeof(value));
+        }
+
+        if (value != expected) {
+            return VERIFY_MISMATCH;
+        }
+    }
+    return VERIFY_MATCH;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT void
+set_input_seed(uint64_t seed) {
+    input_seed = seed;
+}
+
+VMOPSMEM_EXPORT int32_t
+verify_result(const char *name, uint64_t steps, const Result *result) {
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr || kernel->Verify == nullptr) {
+        return VERIFY_UNCHECKED;
+    }
+    return kernel->Verify(steps, *result);
+}
+
+VMOPSMEM_EXPORT int32_t
+verify_kernel(const char *name, uint64_t steps) {
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr || kernel->Verify == nullptr || !kernel->Support()) {
+        return VERIFY_UNCHECKED;
+    }
+
+    if (steps == 0) {
+        steps = VERIFY_STEPS;
+    }
+
+    KernelParams params{};
+    params.Steps = steps;
+    params.Verify = 1;
+
+    Result r = kernel->Run(params);
+    return kernel->Verify(steps, r);
+}
+
+#ifdef __cplusplus
+}
+#endif
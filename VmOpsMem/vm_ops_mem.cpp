@@ -1,7 +1,43 @@
 
 #include "vm_ops_mem.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
 #include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+static uint64_t
+ReadCpuStealTime(int cpu) {
+    FILE *file = fopen("/proc/stat", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "cpu%d ", cpu);
+
+    uint64_t steal = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if (strncmp(line, prefix, strlen(prefix)) != 0) {
+            continue;
+        }
+
+        unsigned long long user, nice, system, idle, iowait, irq, softirq, ticks;
+        if (sscanf(line + strlen(prefix), "%llu %llu %llu %llu %llu %llu %llu %llu", &user, &nice,
+                   &system, &idle, &iowait, &irq, &softirq, &ticks) == 8) {
+            steal = ticks * (1000000000ull / sysconf(_SC_CLK_TCK));
+        }
+        break;
+    }
+
+    fclose(file);
+    return steal;
+}
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,9 +89,73 @@ set_thread_priority() {
     pthread_setschedparam(pthread_self(), policy, &param);
 }
 
+VMOPSMEM_EXPORT SchedStats
+sched_stats() {
+    SchedStats stats{};
+
+    FILE *file = fopen("/proc/thread-self/schedstat", "r");
+    if (file != nullptr) {
+        unsigned long long runTime, waitTime, timeslices;
+        if (fscanf(file, "%llu %llu %llu", &runTime, &waitTime, &timeslices) == 3) {
+            stats.RunTime = runTime;
+            stats.WaitTime = waitTime;
+            stats.Timeslices = timeslices;
+        }
+        fclose(file);
+    }
+
+    rusage usage{};
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+        stats.VoluntarySwitches = usage.ru_nvcsw;
+        stats.InvoluntarySwitches = usage.ru_nivcsw;
+    }
+
+    int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        stats.StealTime = ReadCpuStealTime(cpu);
+    }
+
+    return stats;
+}
+
+VMOPSMEM_EXPORT JitterResult
+jitter_scan(int64_t duration, int64_t threshold, uint64_t *histogram, unsigned buckets) {
+    JitterResult r{};
+
+    auto start = std::chrono::steady_clock::now();
+    auto prev = start;
+    auto end = start + std::chrono::nanoseconds(duration);
+
+    while (prev < end) {
+        auto now = std::chrono::steady_clock::now();
+        int64_t gap = std::chrono::duration_cast<std::chrono::nanoseconds>(now - prev).count();
+        prev = now;
+        r.Iterations++;
+
+        if (gap < threshold) {
+            continue;
+        }
+
+        r.Gaps++;
+        r.GapTime += gap;
+        if (gap > r.MaxGap) {
+            r.MaxGap = gap;
+        }
+
+        /* log2 buckets of the gap length in ns */
+        unsigned bucket = 63 - __builtin_clzll((uint64_t) gap | 1);
+        if (histogram != nullptr && buckets > 0) {
+            histogram[bucket < buckets ? bucket : buckets - 1]++;
+        }
+    }
+
+    r.Time = std::chrono::duration_cast<std::chrono::nanoseconds>(prev - start).count();
+    return r;
+}
+
 VMOPSMEM_EXPORT void
 logical_cores(LogicalCore *logicalCores, unsigned OSProcessorCount) {
-    for (unsigned i = 0; i < OSProcessorCount; i++) {
+    for (unsigned i = 0; i < OSProcessorCount && i < processors.size(); i++) {
         logicalCores[i] = processors[i];
     }
 }
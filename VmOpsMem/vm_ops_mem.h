@@ -1,10 +1,107 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "vmopsmem_export.h"
 
+#define VERIFY_UNCHECKED -1
+#define VERIFY_MISMATCH  0
+#define VERIFY_MATCH     1
+
+#define VERIFY_STEPS 1031
+#define INPUT_RANGE  4
+
+/* Target length of one calibrated kernel call in ns */
+#define DEFAULT_SAMPLE_TIME 10000000
+
+/* Calls that lost more than this fraction of their time to the scheduler count as preempted */
+#define PREEMPTED_FRACTION 0.01
+
+/* Register files of the JIT, every mix entry gets its own block of accumulators */
+#define JIT_VECTOR  0
+#define JIT_TILE    1
+#define JIT_GPR     2
+#define JIT_CLASSES 3
+
+/* Memory operand of a JIT instruction, addressed from the cursor */
+#define JIT_MEM_NONE  0
+#define JIT_MEM_LOAD  1
+#define JIT_MEM_STORE 2
+
+#define DEFAULT_JIT_UNROLL       4
+#define DEFAULT_JIT_ACCUMULATORS 8
+
+#define JIT_OK          0
+#define JIT_BAD_MIX     -1 /* syntax error or unknown instruction */
+#define JIT_UNSUPPORTED -2 /* instruction not available on this CPU */
+#define JIT_TOO_LARGE   -3 /* out of registers or memory offsets */
+#define JIT_MAP_FAILED  -4
+
+/* Per-thread working sets of the memory kernels, kept from one call to the next */
+#define BUFFER_SLOTS 3
+
+/* What a working set holds, from BUFFER_CHAIN on the kernel fills it itself */
+#define BUFFER_FILLED    0 /* anything, the kernel writes over it */
+#define BUFFER_ONES      1 /* every byte 1, read only */
+#define BUFFER_ZERO      2
+#define BUFFER_CHAIN     3
+#define BUFFER_F32_INPUT 4
+#define BUFFER_S8_INPUT  5
+
+/* Index locality of the gather and scatter kernels */
+#define PATTERN_UNIFORM 0
+#define PATTERN_ZIPF    1
+#define PATTERN_CLUSTER 2
+
+/* Fewest indices per pass, larger working sets get one 4 byte lookup per cache line */
+#define GATHER_INDEX_COUNT (64 * 1024)
+
+/* Independent pointer chains of mem_mlp, 0 picks the default */
+#define DEFAULT_MLP_CHAINS 16
+#define MLP_MAX_CHAINS     32
+
+/* Walk of the mem_stride kernels, a 0 stride picks one cache line */
+#define WALK_FORWARD   0
+#define WALK_BACKWARD  1
+#define WALK_PAGES     2 /* forward inside every page, the pages in random order */
+#define WALK_PAGE_SIZE 4096
+
+/* Vector math kernels work on an L1 resident block, softmax row by row */
+#define MATH_BLOCK   1024
+#define MATH_ROW     256
+#define MATH_CHECKED 256 /* leading outputs copied to the result */
+
+/* Conversion kernels, quantized as q = round(x / scale) + zero point */
+#define QUANT_SCALE      0.5f
+#define QUANT_ZERO_POINT 3
+#define CONVERT_PATTERN  1024 /* seeded inputs, repeated over the whole buffer */
+#define CONVERT_CHECKED  256  /* leading outputs copied to the result */
+
+/* What the core does before the warm-up trace starts the kernel */
+#define WARMUP_IDLE   0
+#define WARMUP_SCALAR 1
+
+#define DEFAULT_WARMUP_IDLE  100000000 /* longer than the license hysteresis of the calibration */
+#define DEFAULT_WARMUP_TIME  50000000  /* of the kernel trace and of the relaxation trace each */
+#define DEFAULT_WARMUP_SLICE 10000
+
+/* TLB shootdown probe, both of its phases run this long */
+#define DEFAULT_SHOOTDOWN_TIME      500000000
+#define DEFAULT_SHOOTDOWN_THRESHOLD 250 /* ns, well above a clock read */
+
+/* Futex ping-pong between two pinned threads */
+#define DEFAULT_PINGPONG_TIME 500000000
+
+/* Clock checks, the counter skew of every pair of CPUs and its drift against CLOCK_MONOTONIC */
+#define DEFAULT_SKEW_TIME      20000000
+#define DEFAULT_DRIFT_TIME     2000000000
+#define DEFAULT_DRIFT_INTERVAL 100000000
+
+/* time_source_clock() when cpu_time reads the counter itself, scaled by its measured rate */
+#define TIME_SOURCE_COUNTER -1
+
 struct Result {
     int64_t Time;
     uint64_t Ops;
@@ -16,6 +113,85 @@ struct CpuResult {
     uint64_t Cycles;
 };
 
+struct SchedStats {
+    uint64_t RunTime;
+    uint64_t WaitTime;
+    uint64_t Timeslices;
+    uint64_t VoluntarySwitches;
+    uint64_t InvoluntarySwitches;
+    uint64_t StealTime;
+};
+
+struct JitterResult {
+    int64_t Time;
+    uint64_t Iterations;
+    uint64_t Gaps;
+    int64_t GapTime;
+    int64_t MaxGap;
+};
+
+struct WarmupParams {
+    int64_t Idle;
+    int64_t Duration;
+    int64_t Slice;
+    uint64_t Bytes; /* working set, as in KernelParams */
+    int32_t Lead;   /* WARMUP_IDLE or WARMUP_SCALAR */
+};
+
+struct WarmupSample {
+    int64_t Time; /* slice start, from the first kernel slice */
+    int64_t Length;
+    uint64_t Ops; /* kernel ops, then scalar probe iterations once the kernel stopped */
+};
+
+struct WarmupResult {
+    int64_t SettleTime; /* first kernel slice until the rate holds at the steady rate */
+    uint64_t ThrottledOps;
+    int64_t ThrottledTime;
+    uint64_t SteadyOps;
+    int64_t SteadyTime;
+    int64_t RelaxTime; /* kernel stop until the scalar probe is back to full speed */
+    uint64_t Slices;   /* kernel slices, the relaxation slices follow them */
+    uint64_t RelaxSlices;
+};
+
+struct ShootdownResult {
+    uint64_t Responders;
+    uint64_t Unmaps; /* of touched pages, each one flushes the TLB of the responders */
+    int64_t UnmapTime;
+    uint64_t BaselineUnmaps; /* of untouched pages, nothing to flush */
+    int64_t BaselineTime;
+    uint64_t Stalls; /* responder clock gaps over the threshold, summed over the responders */
+    int64_t StallTime;
+    uint64_t BaselineStalls;
+    int64_t BaselineStallTime;
+};
+
+struct PingPongResult {
+    int64_t Time;
+    uint64_t Wakeups; /* one way, both directions */
+    int64_t WakeTime; /* from the wake call to the woken thread running */
+    int64_t MinWake;
+    int64_t MaxWake;
+};
+
+struct SkewResult {
+    uint64_t Rounds;
+    int64_t MinOffset; /* ticks, bounds of the second counter minus the first */
+    int64_t MaxOffset;
+    int64_t RoundTrip;  /* shortest, the offset is only known to within it */
+    uint64_t Backwards; /* reads below one the other CPU took before them */
+};
+
+struct DriftResult {
+    int64_t Time;
+    uint64_t Intervals;
+    double Frequency; /* ticks per second over the whole run */
+    double MinFrequency;
+    double MaxFrequency;
+    double Drift; /* ppm per second, slope of the interval frequencies */
+};
+
 struct LogicalCore {
     unsigned Index;
     unsigned PackageID;
@@ -23,4 +199,202 @@ struct LogicalCore {
     unsigned ThreadID;
 };
 
+struct KernelParams {
+    uint64_t Steps;
+    uint64_t Bytes;
+    int32_t Flush;
+    int32_t Pattern;
+    int32_t Chains;
+    int32_t Walk;
+    int32_t Stride;
+    int32_t Prefetch; /* accesses ahead, 0 for none */
+    int32_t Verify;   /* the output gets checked, some kernels only gather it then */
+};
+
+struct Kernel {
+    const char *Name;
+    const char *Unit;
+    int32_t (*Support)();
+    Result (*Run)(const KernelParams &params);
+    int32_t (*Verify)(uint64_t steps, const Result &result);
+    uint64_t OpsPerInst; /* 0 for kernels that are not a single instruction */
+    uint64_t OpsPerElem; /* arithmetic ops per element of the "elems" kernels */
+};
+
+/* Set while warmup_trace traces a running kernel: the compute kernel loops run in blocks of
+ * Steps and call Next with the steps done after every block, false stops the kernel early */
+struct SliceHook {
+    uint64_t Steps;
+    bool (*Next)(void *context, uint64_t done);
+    void *Context;
+};
+
+struct KernelJob {
+    const char *Name;
+    int32_t CoreId;
+    int32_t Flush;
+    int32_t Pattern;
+    int32_t Chains;
+    int32_t Walk;
+    int32_t Stride;
+    int32_t Prefetch;
+    uint64_t Steps;
+    uint64_t Bytes;
+    int64_t Duration;
+    int32_t Verify;  /* check every call against the reference model */
+    int32_t Discard; /* leave preempted calls out of the totals */
+
+    int64_t Time;
+    uint64_t Ops;
+    uint64_t Iterations;
+    uint64_t Cycles;  /* CPU counter over the kept calls */
+    int64_t Elapsed;  /* time source over the kept calls, Cycles / Elapsed is the frequency */
+    uint64_t Preempted;
+    uint64_t Discarded;
+    int64_t DiscardedTime;
+    int64_t LostTime; /* runnable but descheduled by the guest or the hypervisor */
+    uint64_t Mismatches;
+};
+
+struct JitSlot;
+
+struct JitOp {
+    const char *Name;
+    int32_t Class;
+    int32_t Memory;
+    int32_t (*Support)();
+    void (*Emit)(std::vector<uint8_t> &code, const JitSlot &slot);
+};
+
+struct JitSlot {
+    const JitOp *Op;
+    unsigned Reg;    /* accumulator, unused by stores */
+    uint32_t Offset; /* from the cursor, loads and stores only */
+};
+
+/* Generated code is called as a function of this type */
+typedef void (*JitFunction)(uint64_t iterations, uint8_t *begin, uint8_t *end,
+                            const void *operands, void *output, uint64_t stride);
+
+struct JitTarget {
+    std::vector<JitOp> Ops;
+    std::vector<unsigned> Registers[JIT_CLASSES]; /* allocatable, fixed operands excluded */
+    uint32_t MaxOffset;
+    void (*Emit)(std::vector<uint8_t> &code, const std::vector<JitSlot> &body);
+    void (*Enter)(const std::vector<JitSlot> &body);
+    void (*Exit)(const std::vector<JitSlot> &body);
+};
+
 extern std::vector<LogicalCore> processors;
+extern std::vector<Kernel> kernels;
+extern uint64_t input_seed;
+extern int64_t sample_time;
+extern const JitTarget jit_target;
+extern thread_local SliceHook slice_hook;
+
+void MapCpuTopology(LogicalCore &core);
+uint64_t CpuModel();
+void InitTopology();
+std::string CachePath(const char *kind);
+void SaveCache(const std::string &path, const std::string &contents);
+uint64_t SerializedTicks();
+void SelectTimeSource();
+int64_t SourceTime();
+
+const Kernel *FindKernel(const char *name);
+uint64_t CalibrateSteps(const Kernel &kernel, KernelParams params, int64_t target);
+uint64_t NextSlice(uint64_t done, uint64_t steps);
+
+int32_t SeededValue(uint64_t stream, uint64_t index, int32_t lo, int32_t hi);
+float HalfToFloat(uint16_t bits);
+int32_t VerifyIntOutput(const Result &result, const std::vector<int64_t> &dots, unsigned width,
+                        uint64_t steps);
+int32_t VerifyFloatOutput(const Result &result, const std::vector<int64_t> &dots,
+                          const std::vector<int64_t> &bounds, unsigned width, uint64_t steps);
+std::vector<uint32_t> BuildIndices(uint64_t elements, uint64_t count, int32_t pattern);
+const std::vector<uint32_t> &GatherIndices(uint64_t bytes, int32_t pattern);
+std::vector<uint32_t> BuildPageOrder(uint64_t pages);
+uint8_t *SlotBuffer(unsigned slot, uint64_t bytes, uint64_t contents, bool &fresh);
+uint8_t *AllocBuffer(uint64_t &bytes, unsigned slot, uint64_t contents);
+void FlushBuffer(const uint8_t *buffer, uint64_t bytes);
+
+void MathInput(float *input, unsigned count, bool positive);
+int32_t VerifyExp(uint64_t steps, const Result &result);
+int32_t VerifyLog(uint64_t steps, const Result &result);
+int32_t VerifyTanh(uint64_t steps, const Result &result);
+int32_t VerifySigmoid(uint64_t steps, const Result &result);
+int32_t VerifyRsqrt(uint64_t steps, const Result &result);
+int32_t VerifySoftmax(uint64_t steps, const Result &result);
+
+void ConvertInput(float *input, uint64_t count);
+void QuantInput(int8_t *input, uint64_t count);
+int32_t VerifyBf16(uint64_t steps, const Result &result);
+int32_t VerifyF16(uint64_t steps, const Result &result);
+int32_t VerifyQuant(uint64_t steps, const Result &result);
+int32_t VerifyDequant(uint64_t steps, const Result &result);
+
+void RegisterOpsKernels(std::vector<Kernel> &registry);
+void RegisterMemKernels(std::vector<Kernel> &registry);
+void RegisterChaseKernels(std::vector<Kernel> &registry);
+void RegisterJitKernels(std::vector<Kernel> &registry);
+void RegisterMathKernels(std::vector<Kernel> &registry);
+void RegisterConvertKernels(std::vector<Kernel> &registry);
+void RegisterPagingKernels(std::vector<Kernel> &registry);
+void RegisterExitKernels(std::vector<Kernel> &registry);
+void RegisterSyscallKernels(std::vector<Kernel> &registry);
+void RegisterClockKernels(std::vector<Kernel> &registry);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT void init();
+VMOPSMEM_EXPORT int arm_build();
+VMOPSMEM_EXPORT int x86_build();
+VMOPSMEM_EXPORT int debug_build();
+VMOPSMEM_EXPORT CpuResult cpu_time();
+
+VMOPSMEM_EXPORT void set_thread_affinity(int coreId);
+VMOPSMEM_EXPORT void set_thread_priority();
+VMOPSMEM_EXPORT unsigned logical_core_count();
+VMOPSMEM_EXPORT void logical_cores(LogicalCore *logicalCores, unsigned OSProcessorCount);
+
+VMOPSMEM_EXPORT SchedStats sched_stats();
+VMOPSMEM_EXPORT JitterResult jitter_scan(int64_t duration, int64_t threshold, uint64_t *histogram,
+                                         unsigned buckets);
+VMOPSMEM_EXPORT WarmupResult warmup_trace(const char *name, const WarmupParams *params,
+                                          WarmupSample *samples, unsigned count);
+VMOPSMEM_EXPORT ShootdownResult tlb_shootdown(int32_t initiator, const int32_t *responders,
+                                              unsigned count, int64_t duration,
+                                              int64_t threshold);
+VMOPSMEM_EXPORT PingPongResult futex_pingpong(int32_t first, int32_t second, int64_t duration,
+                                              uint64_t *histogram, unsigned buckets);
+VMOPSMEM_EXPORT const char *clock_source();
+VMOPSMEM_EXPORT int32_t time_source_clock();
+VMOPSMEM_EXPORT int32_t clock_counter_based();
+VMOPSMEM_EXPORT SkewResult counter_skew(int32_t first, int32_t second, int64_t duration);
+VMOPSMEM_EXPORT DriftResult counter_drift(int64_t duration, int64_t interval);
+
+VMOPSMEM_EXPORT unsigned kernel_count();
+VMOPSMEM_EXPORT const char *kernel_name(unsigned index);
+VMOPSMEM_EXPORT const char *kernel_unit(const char *name);
+VMOPSMEM_EXPORT int32_t kernel_support(const char *name);
+VMOPSMEM_EXPORT uint64_t kernel_ops_per_inst(const char *name);
+VMOPSMEM_EXPORT uint64_t kernel_ops_per_elem(const char *name);
+VMOPSMEM_EXPORT double kernel_inst_time(const char *name);
+VMOPSMEM_EXPORT Result run_kernel(const char *name, const KernelParams *params);
+VMOPSMEM_EXPORT int32_t run_kernels(KernelJob *jobs, unsigned count);
+VMOPSMEM_EXPORT void set_sample_time(int64_t time);
+VMOPSMEM_EXPORT uint64_t calibrate_steps(const char *name, const KernelParams *params);
+
+VMOPSMEM_EXPORT int32_t jit_support();
+VMOPSMEM_EXPORT const char *jit_instructions();
+VMOPSMEM_EXPORT int32_t set_jit_mix(const char *mix, uint32_t unroll, uint32_t accumulators);
+
+VMOPSMEM_EXPORT void set_input_seed(uint64_t seed);
+VMOPSMEM_EXPORT int32_t verify_result(const char *name, uint64_t steps, const Result *result);
+VMOPSMEM_EXPORT int32_t verify_kernel(const char *name, uint64_t steps);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,242 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "vmopsmem_export.h"
+
+/* Settled once this many slices in a row run within 5% of the steady rate */
+#define WARMUP_TOLERANCE 0.95
+#define WARMUP_STABLE    8
+
+#define PROBE_CALIBRATE_ITERATIONS (1ull << 20)
+
+/* Upper bound of the traced kernel call, in calibrated slices per slice of the trace */
+#define TRACE_HEADROOM 4
+
+thread_local SliceHook slice_hook{};
+
+/* Kernel trace in progress, the slice hook context */
+struct SliceTrace {
+    std::vector<WarmupSample> *Trace;
+    uint64_t Origin;
+    uint64_t Prev;
+    uint64_t Done; /* steps of the current call at the previous block end */
+    uint64_t Ticks;
+    double OpsPerStep;
+};
+
+static int64_t
+Now() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+/* Dependent multiply-add chain, its rate follows the core clock and nothing else */
+static void
+ScalarProbe(uint64_t iterations) {
+    uint64_t x = iterations;
+    for (uint64_t i = 0; i < iterations; i++) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        __asm__ volatile("" : "+r"(x));
+    }
+}
+
+static uint64_t
+CalibrateProbe(int64_t slice) {
+    int64_t start = Now();
+    ScalarProbe(PROBE_CALIBRATE_ITERATIONS);
+    int64_t time = std::max<int64_t>(Now() - start, 1);
+    return std::max<uint64_t>(1, PROBE_CALIBRATE_ITERATIONS * slice / time);
+}
+
+/* Slices run back to back, one counter read ends a slice and starts the next */
+template <typename Function>
+static uint64_t
+TraceSlices(std::vector<WarmupSample> &trace, uint64_t origin, uint64_t begin, uint64_t ticks,
+            Function slice) {
+    uint64_t prev = begin;
+    do {
+        uint64_t ops = slice();
+        uint64_t now = SerializedTicks();
+        trace.push_back({(int64_t) (prev - origin), (int64_t) (now - prev), ops});
+        prev = now;
+    } while (prev - begin < ticks);
+    return prev;
+}
+
+/* Same sample as TraceSlices, but taken at a block end inside the running kernel */
+static bool
+TraceBlock(void *context, uint64_t done) {
+    SliceTrace &t = *(SliceTrace *) context;
+    uint64_t now = SerializedTicks();
+    uint64_t ops = (done - t.Done) * t.OpsPerStep;
+    t.Trace->push_back({(int64_t) (t.Prev - t.Origin), (int64_t) (now - t.Prev), ops});
+    t.Prev = now;
+    t.Done = done;
+    return now - t.Origin < t.Ticks;
+}
+
+/* Ops of one step if the kernel loop goes through NextSlice, 0 if it can only be traced call
+ * by call */
+static double
+TracedOpsPerStep(const Kernel &kernel, KernelParams params) {
+    bool called = false;
+    auto probe = [](void *context, uint64_t) {
+        *(bool *) context = true;
+        return false;
+    };
+    slice_hook = {1, probe, &called};
+    params.Steps = 2;
+    Result r = kernel.Run(params);
+    slice_hook = {};
+    return called ? r.Ops : 0;
+}
+
+static double
+SliceRate(const WarmupSample &sample) {
+    return (double) sample.Ops / std::max<int64_t>(sample.Length, 1);
+}
+
+/* Median of the second half, the first half may still be ramping */
+static double
+SteadyRate(const WarmupSample *samples, size_t count) {
+    std::vector<double> rates;
+    for (size_t i = count / 2; i < count; i++) {
+        rates.push_back(SliceRate(samples[i]));
+    }
+    std::nth_element(rates.begin(), rates.begin() + rates.size() / 2, rates.end());
+    return rates[rates.size() / 2];
+}
+
+static size_t
+SettleIndex(const WarmupSample *samples, size_t count) {
+    double steady = SteadyRate(samples, count);
+
+    size_t run = 0;
+    for (size_t i = 0; i < count; i++) {
+        run = SliceRate(samples[i]) >= WARMUP_TOLERANCE * steady ? run + 1 : 0;
+        if (run == WARMUP_STABLE) {
+            return i + 1 - WARMUP_STABLE;
+        }
+    }
+
+    /* Too noisy to ever hold the rate, the steady part is what the median was taken from */
+    return count / 2;
+}
+
+uint64_t
+NextSlice(uint64_t done, uint64_t steps) {
+    if (slice_hook.Steps == 0) {
+        return steps;
+    }
+    if (done > 0 && !slice_hook.Next(slice_hook.Context, done)) {
+        return done;
+    }
+    return std::min(steps, done + slice_hook.Steps);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMOPSMEM_EXPORT WarmupResult
+warmup_trace(const char *name, const WarmupParams *params, WarmupSample *samples,
+             unsigned count) {
+    WarmupResult r{};
+
+    const Kernel *kernel = FindKernel(name);
+    if (kernel == nullptr || !kernel->Support() || params->Slice <= 0 || params->Duration <= 0) {
+        return r;
+    }
+
+    /* The counter is converted to ns over the calibrations and the lead-in */
+    int64_t clockStart = Now();
+    uint64_t tickStart = SerializedTicks();
+
+    KernelParams kernelParams{};
+    kernelParams.Bytes = params->Bytes;
+    kernelParams.Steps = CalibrateSteps(*kernel, kernelParams, params->Slice);
+    /* A memory kernel without a working set does nothing, there is no ramp to trace */
+    if (kernel->Run(kernelParams).Ops == 0) {
+        return r;
+    }
+    uint64_t iterations = CalibrateProbe(params->Slice);
+    double opsPerStep = TracedOpsPerStep(*kernel, kernelParams);
+
+    /* Calibration ran the kernel as well, the lead-in has to outlast the frequency hysteresis */
+    if (params->Lead == WARMUP_SCALAR) {
+        int64_t end = Now() + params->Idle;
+        while (Now() < end) {
+            ScalarProbe(iterations);
+        }
+    } else {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(params->Idle));
+    }
+
+    double tickTime =
+        (double) (Now() - clockStart) / std::max<uint64_t>(SerializedTicks() - tickStart, 1);
+    uint64_t ticks = params->Duration / tickTime;
+
+    /* Room for slices shorter than calibrated, nothing is reallocated while tracing */
+    std::vector<WarmupSample> trace;
+    trace.reserve(4 * (params->Duration / params->Slice + WARMUP_STABLE));
+
+    /* A traced kernel runs through the whole trace in one call, the tile configuration and
+     * any other setup happen once as in a real run. Other kernels are called once a slice */
+    uint64_t origin = SerializedTicks();
+    uint64_t stop = origin;
+    if (opsPerStep > 0) {
+        SliceTrace t{&trace, origin, origin, 0, ticks, opsPerStep};
+        KernelParams runParams = kernelParams;
+        runParams.Steps *= TRACE_HEADROOM * (params->Duration / params->Slice + 1);
+
+        slice_hook = {kernelParams.Steps, TraceBlock, &t};
+        while (t.Prev - origin < ticks) {
+            t.Done = 0;
+            kernel->Run(runParams);
+        }
+        slice_hook = {};
+        stop = t.Prev;
+    } else {
+        stop = TraceSlices(trace, origin, origin, ticks,
+                           [&]() { return kernel->Run(kernelParams).Ops; });
+    }
+    size_t slices = trace.size();
+    TraceSlices(trace, origin, stop, ticks, [&]() {
+        ScalarProbe(iterations);
+        return iterations;
+    });
+
+    for (WarmupSample &sample : trace) {
+        sample.Time = sample.Time * tickTime;
+        sample.Length = sample.Length * tickTime;
+    }
+
+    size_t settle = SettleIndex(trace.data(), slices);
+    r.SettleTime = trace[settle].Time;
+    for (size_t i = 0; i < slices; i++) {
+        if (i < settle) {
+            r.ThrottledOps += trace[i].Ops;
+            r.ThrottledTime += trace[i].Length;
+        } else {
+            r.SteadyOps += trace[i].Ops;
+            r.SteadyTime += trace[i].Length;
+        }
+    }
+
+    size_t relax = SettleIndex(trace.data() + slices, trace.size() - slices);
+    r.RelaxTime = trace[slices + relax].Time - trace[slices].Time;
+    r.Slices = slices;
+    r.RelaxSlices = trace.size() - slices;
+
+    if (samples != nullptr) {
+        std::copy_n(trace.begin(), std::min<size_t>(count, trace.size()), samples);
+    }
+    return r;
+}
+
+#ifdef __cplusplus
+}
+#endif
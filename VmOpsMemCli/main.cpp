@@ -0,0 +1,1588 @@
+#include "vm_ops_mem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_MEM_SIZE      (256ull * 1024 * 1024)
+#define DEFAULT_SWEEP_MIN     (32ull * 1024)
+#define CHASE_LINE_SIZE       64
+#define DEFAULT_REPORT_TIME   60
+#define DEFAULT_KERNEL_STEPS  0
+#define DEFAULT_MEMORY_PASSES 0
+#define SWEEP_MAX_STRIDE      (2 * WALK_PAGE_SIZE)
+#define SWEEP_MAX_PREFETCH    64
+#define PINGPONG_BUCKETS      40
+#define JITTER_BUCKETS        40
+#define DEFAULT_JITTER_THRESHOLD 10000
+
+enum class Format { Text, Json, Csv };
+enum class Sweep { None, Cores, Size, Chains, Stride, Prefetch };
+
+struct Options {
+    double Report = DEFAULT_REPORT_TIME;
+    uint64_t Steps = DEFAULT_KERNEL_STEPS;
+    double SampleTime = DEFAULT_SAMPLE_TIME / 1e6;
+    unsigned Cores = 0;
+    std::vector<std::string> Ops;
+    bool Mem = false;
+    uint64_t MemSize = DEFAULT_MEM_SIZE;
+    uint64_t MemPasses = DEFAULT_MEMORY_PASSES;
+    bool MemFlush = false;
+    int32_t Pattern = PATTERN_UNIFORM;
+    int32_t Chains = 0;
+    int32_t Walk = WALK_FORWARD;
+    int32_t Stride = 0;
+    int32_t Prefetch = 0;
+    bool Paging = false;
+    uint64_t VmSize = 0;
+    bool Exits = false;
+    bool Verify = false;
+    bool DiscardPreempted = false;
+    double Jitter = 0;
+    uint64_t JitterThreshold = DEFAULT_JITTER_THRESHOLD;
+    std::vector<std::string> Mix;
+    uint64_t MixSteps = 0;
+    bool Seed = false;
+    uint64_t SeedValue = 0;
+    uint64_t Rounds = 0;
+    Sweep SweepMode = Sweep::None;
+    uint64_t SweepMin = DEFAULT_SWEEP_MIN;
+    Format Output = Format::Text;
+    bool Topology = false;
+    bool List = false;
+    bool Table = false;
+    bool Warmup = false;
+    int32_t WarmupLead = WARMUP_IDLE;
+    double WarmupTime = DEFAULT_WARMUP_TIME / 1e6;
+    double WarmupSlice = DEFAULT_WARMUP_SLICE / 1e3;
+    bool Shootdown = false;
+    double ShootdownTime = DEFAULT_SHOOTDOWN_TIME / 1e6;
+    uint64_t ShootdownThreshold = DEFAULT_SHOOTDOWN_THRESHOLD;
+    bool PingPong = false;
+    double PingPongTime = DEFAULT_PINGPONG_TIME / 1e6;
+    bool Clocks = false;
+    double SkewTime = DEFAULT_SKEW_TIME / 1e6;
+    double DriftTime = DEFAULT_DRIFT_TIME / 1e6;
+    std::string Jit;
+    uint64_t JitUnroll = DEFAULT_JIT_UNROLL;
+    uint64_t JitAccumulators = DEFAULT_JIT_ACCUMULATORS;
+    uint64_t JitSize = 0;
+};
+
+struct Sample {
+    std::string Name;
+    std::string Unit;
+    unsigned Cores;
+    uint64_t Steps;
+    uint64_t Bytes;
+    double Time;
+    uint64_t Ops;
+    uint64_t Iterations;
+    double Peak;
+    std::map<unsigned, double> Packages;
+    int32_t Chains = 0;
+    double InFlight = 0;
+    int32_t Walk = WALK_FORWARD;
+    int32_t Stride = 0;
+    int32_t Prefetch = 0;
+    uint64_t Preempted = 0;
+    uint64_t Discarded = 0;
+    double LostTime = 0; /* per core */
+};
+
+static void
+PrintUsage(const char *program) {
+    std::printf("Usage: %s [options]\n"
+                "  -r, --report SEC          Seconds per report (default %d)\n"
+                "  -s, --steps N             Kernel steps per call (default 0, calibrated)\n"
+                "      --sample-time MS      Length of one calibrated kernel call (default %g)\n"
+                "  -c, --cores N             Physical cores to use (default all)\n"
+                "  -o, --ops NAME...         Kernels to run (default all compute kernels)\n"
+                "  -m, --mem                 Also run the memory and precision conversion kernels\n"
+                "      --mem-size BYTES      Memory kernel working set (default 256MiB)\n"
+                "      --mem-passes N        Working set passes per call (default %d, calibrated)\n"
+                "      --mem-flush           Flush the working set before every pass\n"
+                "      --pattern uniform|zipf|cluster\n"
+                "                            Index locality of mem_gather and mem_scatter\n"
+                "      --chains N            Independent chains of mem_mlp (default %d, max %d)\n"
+                "      --walk forward|backward|pages\n"
+                "                            Access order of mem_stride and mem_stride_lat\n"
+                "      --stride BYTES        Distance between their loads (default 64)\n"
+                "      --prefetch N          Software prefetch N accesses ahead (default 0, none)\n"
+                "      --paging              Also run the page fault and mapping kernels\n"
+                "      --vm-size BYTES       Their region (default 64MiB to fault, a page to map)\n"
+                "      --exits               Also time traps, syscalls and clock reads\n"
+                "  -v, --verify              Check every kernel call against the reference models\n"
+                "      --discard-preempted   Drop the calls that lost over 1%% to the scheduler\n"
+                "  -j, --jitter SEC          Scan for scheduling gaps before every kernel\n"
+                "      --jitter-threshold NS\n"
+                "                            Shortest gap counted (default %d)\n"
+                "      --mix NAME[:N|P%%]...\n"
+                "                            Co-schedule kernels, each on N cores or P%% of them,\n"
+                "                            and compare with every group running alone\n"
+                "      --mix-steps N         Steps of the compute kernels of the mix (default 0)\n"
+                "      --seed N              Seed for the kernel inputs\n"
+                "  -n, --rounds N            Reports per kernel before exiting (0 runs forever)\n"
+                "      --sweep cores|size|chains|stride|prefetch\n"
+                "                            Sweep the core count, the memory working set, the\n"
+                "                            mem_mlp chains on one core and on a whole socket, or\n"
+                "                            the stride or prefetch distance of the strided walks\n"
+                "      --sweep-min BYTES     Smallest working set of the sweep (default 32KiB)\n"
+                "  -f, --format text|json|csv\n"
+                "  -t, --topology            Print the system topology and exit\n"
+                "  -l, --list                List the kernels and exit\n"
+                "      --table               Print the instruction latency/throughput table\n"
+                "      --warmup idle|scalar  Trace the kernel ramp-up after idling or scalar code\n"
+                "      --warmup-time MS      Kernel and relaxation trace length (default %g)\n"
+                "      --warmup-slice US     Length of one trace slice (default %g)\n"
+                "      --shootdown           Measure the TLB shootdowns of munmap on other cores\n"
+                "      --shootdown-time MS   Length of the baseline and flush phases (default %g)\n"
+                "      --shootdown-threshold NS\n"
+                "                            Shortest responder stall counted (default %d)\n"
+                "      --pingpong            Futex wake-up latency between pinned threads\n"
+                "      --pingpong-time MS    Length of every pairing (default %g)\n"
+                "      --clocks              Clock read costs, counter skew and drift\n"
+                "      --skew-time MS        Length of every pair of CPUs (default %g)\n"
+                "      --drift-time MS       Length of the drift estimate (default %g)\n"
+                "      --jit MIX             Generate and run a loop, e.g. fma:2,load:1 (see -l)\n"
+                "      --jit-unroll N        Copies of the mix per loop iteration (default %d)\n"
+                "      --jit-acc N           Accumulators per mix entry (default %d)\n"
+                "      --jit-size BYTES      Working set of the jit loads/stores (default 16KiB)\n",
+                program, DEFAULT_REPORT_TIME, DEFAULT_SAMPLE_TIME / 1e6, DEFAULT_MEMORY_PASSES,
+                DEFAULT_MLP_CHAINS, MLP_MAX_CHAINS, DEFAULT_JITTER_THRESHOLD,
+                DEFAULT_WARMUP_TIME / 1e6,
+                DEFAULT_WARMUP_SLICE / 1e3, DEFAULT_SHOOTDOWN_TIME / 1e6,
+                DEFAULT_SHOOTDOWN_THRESHOLD, DEFAULT_PINGPONG_TIME / 1e6, DEFAULT_SKEW_TIME / 1e6,
+                DEFAULT_DRIFT_TIME / 1e6, DEFAULT_JIT_UNROLL, DEFAULT_JIT_ACCUMULATORS);
+}
+
+static bool
+ParseNumber(const char *text, double &value) {
+    char *end = nullptr;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0' && value >= 0;
+}
+
+static bool
+ParseOptions(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        double number = 0;
+
+        auto needNumber = [&]() {
+            if (value == nullptr || !ParseNumber(value, number)) {
+                std::fprintf(stderr, "Option %s expects a number\n", arg.c_str());
+                return false;
+            }
+            i++;
+            return true;
+        };
+
+        /* Index of the value among the choices, -1 after reporting a missing or invalid one */
+        auto needChoice = [&](std::initializer_list<const char *> choices) {
+            int index = 0;
+            for (const char *choice : choices) {
+                if (value != nullptr && std::strcmp(value, choice) == 0) {
+                    i++;
+                    return index;
+                }
+                index++;
+            }
+            std::string names;
+            for (const char *choice : choices) {
+                names += names.empty() ? choice : std::string("|") + choice;
+            }
+            std::fprintf(stderr, "Invalid value `%s` for %s, expected %s\n",
+                         value != nullptr ? value : "", arg.c_str(), names.c_str());
+            return -1;
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            PrintUsage(argv[0]);
+            std::exit(0);
+        } else if (arg == "-r" || arg == "--report") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.Report = number;
+        } else if (arg == "-s" || arg == "--steps") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.Steps = (uint64_t) number;
+        } else if (arg == "--sample-time") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.SampleTime = number;
+        } else if (arg == "-c" || arg == "--cores") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.Cores = (unsigned) number;
+        } else if (arg == "-o" || arg == "--ops") {
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                std::string name = argv[++i];
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                options.Ops.push_back(name);
+            }
+        } else if (arg == "-m" || arg == "--mem") {
+            options.Mem = true;
+        } else if (arg == "--mem-size") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.MemSize = (uint64_t) number;
+        } else if (arg == "--mem-passes") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.MemPasses = (uint64_t) number;
+        } else if (arg == "--mem-flush") {
+            options.MemFlush = true;
+        } else if (arg == "--pattern") {
+            /* In the order of the PATTERN_* values */
+            int pattern = needChoice({"uniform", "zipf", "cluster"});
+            if (pattern < 0) {
+                return false;
+            }
+            options.Pattern = pattern;
+        } else if (arg == "--chains") {
+            if (!needNumber()) {
+                return false;
+            }
+            if (number < 1 || number > MLP_MAX_CHAINS) {
+                std::fprintf(stderr, "Option %s expects 1 to %d\n", arg.c_str(), MLP_MAX_CHAINS);
+                return false;
+            }
+            options.Chains = (int32_t) number;
+        } else if (arg == "--walk") {
+            /* In the order of the WALK_* values */
+            int walk = needChoice({"forward", "backward", "pages"});
+            if (walk < 0) {
+                return false;
+            }
+            options.Walk = walk;
+        } else if (arg == "--stride") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.Stride = (int32_t) number;
+        } else if (arg == "--prefetch") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.Prefetch = (int32_t) number;
+        } else if (arg == "--paging") {
+            options.Paging = true;
+        } else if (arg == "--vm-size") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.VmSize = (uint64_t) number;
+        } else if (arg == "--exits") {
+            options.Exits = true;
+        } else if (arg == "-v" || arg == "--verify") {
+            options.Verify = true;
+        } else if (arg == "--discard-preempted") {
+            options.DiscardPreempted = true;
+        } else if (arg == "-j" || arg == "--jitter") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.Jitter = number;
+        } else if (arg == "--jitter-threshold") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.JitterThreshold = (uint64_t) number;
+        } else if (arg == "--mix") {
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                std::string spec = argv[++i];
+                std::transform(spec.begin(), spec.end(), spec.begin(), ::tolower);
+                options.Mix.push_back(spec);
+            }
+        } else if (arg == "--mix-steps") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.MixSteps = (uint64_t) number;
+        } else if (arg == "--seed") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.Seed = true;
+            options.SeedValue = (uint64_t) number;
+        } else if (arg == "-n" || arg == "--rounds") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.Rounds = (uint64_t) number;
+        } else if (arg == "--sweep") {
+            static const Sweep sweeps[] = {Sweep::Cores, Sweep::Size, Sweep::Chains, Sweep::Stride,
+                                           Sweep::Prefetch};
+            int sweep = needChoice({"cores", "size", "chains", "stride", "prefetch"});
+            if (sweep < 0) {
+                return false;
+            }
+            options.SweepMode = sweeps[sweep];
+        } else if (arg == "--sweep-min") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.SweepMin = (uint64_t) number;
+        } else if ((arg == "-f" || arg == "--format") && value != nullptr) {
+            if (std::strcmp(value, "text") == 0) {
+                options.Output = Format::Text;
+            } else if (std::strcmp(value, "json") == 0) {
+                options.Output = Format::Json;
+            } else if (std::strcmp(value, "csv") == 0) {
+                options.Output = Format::Csv;
+            } else {
+                std::fprintf(stderr, "Unknown format `%s`\n", value);
+                return false;
+            }
+            i++;
+        } else if (arg == "-t" || arg == "--topology") {
+            options.Topology = true;
+        } else if (arg == "-l" || arg == "--list") {
+            options.List = true;
+        } else if (arg == "--table") {
+            options.Table = true;
+        } else if (arg == "--warmup") {
+            /* In the order of the WARMUP_* values */
+            int lead = needChoice({"idle", "scalar"});
+            if (lead < 0) {
+                return false;
+            }
+            options.Warmup = true;
+            options.WarmupLead = lead;
+        } else if (arg == "--warmup-time") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.WarmupTime = number;
+        } else if (arg == "--warmup-slice") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.WarmupSlice = number;
+        } else if (arg == "--shootdown") {
+            options.Shootdown = true;
+        } else if (arg == "--shootdown-time") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.ShootdownTime = number;
+        } else if (arg == "--shootdown-threshold") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.ShootdownThreshold = (uint64_t) number;
+        } else if (arg == "--pingpong") {
+            options.PingPong = true;
+        } else if (arg == "--pingpong-time") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.PingPongTime = number;
+        } else if (arg == "--clocks") {
+            options.Clocks = true;
+        } else if (arg == "--skew-time") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.SkewTime = number;
+        } else if (arg == "--drift-time") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.DriftTime = number;
+        } else if (arg == "--jit" && value != nullptr) {
+            options.Jit = value;
+            i++;
+        } else if (arg == "--jit-unroll") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.JitUnroll = (uint64_t) number;
+        } else if (arg == "--jit-acc") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.JitAccumulators = (uint64_t) number;
+        } else if (arg == "--jit-size") {
+            if (!needNumber()) {
+                return false;
+            }
+            options.JitSize = (uint64_t) number;
+        } else {
+            std::fprintf(stderr, "Unknown option `%s`\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<LogicalCore>
+LogicalCores() {
+    std::vector<LogicalCore> cores(logical_core_count());
+    logical_cores(cores.data(), cores.size());
+    return cores;
+}
+
+static void
+PrintTopology(const std::vector<LogicalCore> &cores, Format format) {
+    if (format == Format::Csv) {
+        std::printf("thread,socket,core,vcpu\n");
+        for (const LogicalCore &core : cores) {
+            std::printf("%u,%u,%u,%u\n", core.Index, core.PackageID, core.CoreID, core.ThreadID);
+        }
+        return;
+    }
+
+    std::map<unsigned, std::map<unsigned, std::map<unsigned, unsigned>>> system;
+    for (const LogicalCore &core : cores) {
+        system[core.PackageID][core.CoreID][core.ThreadID] = core.Index;
+    }
+
+    bool indent = format == Format::Text;
+    const char *nl = indent ? "\n" : "";
+    const char *sep = indent ? ": " : ":";
+
+    std::printf("{%s", nl);
+    for (auto socket = system.begin(); socket != system.end(); ++socket) {
+        std::printf("%s\"Socket#%u\"%s{%s", indent ? "    " : "", socket->first, sep, nl);
+        for (auto core = socket->second.begin(); core != socket->second.end(); ++core) {
+            std::printf("%s\"Core#%u\"%s{%s", indent ? "        " : "", core->first, sep, nl);
+            for (auto cpu = core->second.begin(); cpu != core->second.end(); ++cpu) {
+                std::printf("%s\"vCPU#%u\"%s\"Thread#%u\"%s%s", indent ? "            " : "",
+                            cpu->first, sep, cpu->second,
+                            std::next(cpu) != core->second.end() ? "," : "", nl);
+            }
+            std::printf("%s}%s%s", indent ? "        " : "",
+                        std::next(core) != socket->second.end() ? "," : "", nl);
+        }
+        std::printf("%s}%s%s", indent ? "    " : "", std::next(socket) != system.end() ? "," : "",
+                    nl);
+    }
+    std::printf("}\n");
+}
+
+/* Latency (single chain), reciprocal throughput (independent chains) and pairings */
+static const char *chain_variants[] = {"", "_tput", "_load", "_fma"};
+
+static bool
+IsChainVariant(const std::string &name) {
+    for (const char *variant : chain_variants) {
+        size_t length = std::strlen(variant);
+        if (length != 0 && name.size() > length &&
+            name.compare(name.size() - length, length, variant) == 0 &&
+            kernel_ops_per_inst(name.substr(0, name.size() - length).c_str()) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void
+PrintTable(const std::vector<std::string> &ops, const LogicalCore &core, Format format) {
+    set_thread_affinity(core.Index);
+    set_thread_priority();
+
+    std::vector<std::vector<double>> times;
+    CpuResult start = cpu_time();
+    for (const std::string &name : ops) {
+        times.emplace_back();
+        for (const char *variant : chain_variants) {
+            times.back().push_back(kernel_inst_time((name + variant).c_str()));
+        }
+    }
+    CpuResult end = cpu_time();
+
+    /* Cycles of the CPU counter, the TSC on x86 and the generic timer on ARM */
+    double freq = (double) (end.Cycles - start.Cycles) / (end.Time - start.Time);
+
+    if (format == Format::Text) {
+        std::printf("Name: Instruction table (cycles of the %.2f GHz CPU counter)\n", freq);
+        std::printf("%-24s%10s%10s%10s%10s%10s\n", "Instruction", "Ops/Inst", "Latency",
+                    "RecipTput", "+Load", "+FMA");
+    } else if (format == Format::Csv) {
+        std::printf("name,ops_per_inst,latency,recip_tput,load,fma,freq\n");
+    }
+
+    for (size_t i = 0; i < ops.size(); i++) {
+        std::string name = ops[i];
+        unsigned long long opsPerInst = kernel_ops_per_inst(name.c_str());
+
+        if (format == Format::Json) {
+            std::printf("{\"name\":\"%s\",\"ops_per_inst\":%llu,\"freq\":%.6f", name.c_str(),
+                        opsPerInst, freq);
+            const char *keys[] = {"latency", "recip_tput", "load", "fma"};
+            for (size_t j = 0; j < times[i].size(); j++) {
+                std::printf(",\"%s\":%.4f", keys[j], times[i][j] * freq);
+            }
+            std::printf("}\n");
+        } else if (format == Format::Csv) {
+            std::printf("%s,%llu", name.c_str(), opsPerInst);
+            for (double time : times[i]) {
+                std::printf(",%.4f", time * freq);
+            }
+            std::printf(",%.6f\n", freq);
+        } else {
+            std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+            std::printf("%-24s%10llu", name.c_str(), opsPerInst);
+            for (double time : times[i]) {
+                if (time == 0) {
+                    std::printf("%10s", "-");
+                } else {
+                    std::printf("%10.2f", time * freq);
+                }
+            }
+            std::printf("\n");
+        }
+    }
+}
+
+static const char *
+UnitSuffix(const std::string &unit) {
+    if (unit == "bytes") {
+        return "B";
+    }
+    if (unit == "loads") {
+        return "Loads";
+    }
+    if (unit == "inst") {
+        return "Inst";
+    }
+    if (unit == "elems") {
+        return "Elems";
+    }
+    if (unit == "faults") {
+        return "Faults";
+    }
+    if (unit == "calls") {
+        return "Calls";
+    }
+    return "Ops";
+}
+
+static std::string
+SizeFmt(double num, const char *suffix) {
+    static const char *units[] = {"", "K", "M", "G", "T", "P", "E", "Z"};
+    char text[64];
+    for (const char *unit : units) {
+        if (num < 1024.0) {
+            std::snprintf(text, sizeof(text), "%.2f %s%s", num, unit, suffix);
+            return text;
+        }
+        num /= 1024.0;
+    }
+    std::snprintf(text, sizeof(text), "%.2f Y%s", num, suffix);
+    return text;
+}
+
+static void
+PrintWarmup(const std::vector<std::string> &ops, const LogicalCore &core, const Options &options) {
+    set_thread_affinity(core.Index);
+    set_thread_priority();
+
+    WarmupParams params{DEFAULT_WARMUP_IDLE, (int64_t) (options.WarmupTime * 1e6),
+                        (int64_t) (options.WarmupSlice * 1e3), 0, options.WarmupLead};
+    const char *lead = options.WarmupLead == WARMUP_SCALAR ? "scalar" : "idle";
+
+    if (options.Output == Format::Text) {
+        std::printf("Name: Warm-up after %s lead-in\n", lead);
+        std::printf("%-16s%12s%18s%18s%8s%12s\n", "Kernel", "Settle", "Throttled", "Steady",
+                    "Ratio", "Relax");
+    } else if (options.Output == Format::Csv) {
+        std::printf("name,unit,lead,settle_time,throttled_ops,throttled_time,steady_ops,"
+                    "steady_time,relax_time\n");
+    }
+
+    for (const std::string &name : ops) {
+        /* The working sets of a measurement run */
+        params.Bytes = 0;
+        if (name.rfind("mem_", 0) == 0 || name.rfind("cvt_", 0) == 0) {
+            params.Bytes = options.MemSize;
+        } else if (name.rfind("vm_", 0) == 0) {
+            params.Bytes = options.VmSize;
+        } else if (name == "jit") {
+            params.Bytes = options.JitSize;
+        }
+
+        WarmupResult r = warmup_trace(name.c_str(), &params, nullptr, 0);
+        if (r.Slices == 0) {
+            std::fprintf(stderr, "Failed to trace the warm-up of `%s`!\n", name.c_str());
+            continue;
+        }
+        const char *unit = kernel_unit(name.c_str());
+        double throttled = r.ThrottledTime > 0 ? r.ThrottledOps * 1e9 / r.ThrottledTime : 0;
+        double steady = r.SteadyTime > 0 ? r.SteadyOps * 1e9 / r.SteadyTime : 0;
+
+        if (options.Output == Format::Json) {
+            std::printf("{\"name\":\"%s\",\"unit\":\"%s\",\"lead\":\"%s\",\"settle_time\":%lld,"
+                        "\"throttled\":%.6e,\"steady\":%.6e,\"relax_time\":%lld}\n",
+                        name.c_str(), unit, lead, (long long) r.SettleTime, throttled, steady,
+                        (long long) r.RelaxTime);
+        } else if (options.Output == Format::Csv) {
+            std::printf("%s,%s,%s,%lld,%llu,%lld,%llu,%lld,%lld\n", name.c_str(), unit, lead,
+                        (long long) r.SettleTime, (unsigned long long) r.ThrottledOps,
+                        (long long) r.ThrottledTime, (unsigned long long) r.SteadyOps,
+                        (long long) r.SteadyTime, (long long) r.RelaxTime);
+        } else {
+            const char *suffix = UnitSuffix(unit);
+            std::string upper = name;
+            std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+            std::printf("%-16s%9.2f us", upper.c_str(), r.SettleTime / 1e3);
+            if (r.ThrottledTime > 0) {
+                std::printf("%18s", (SizeFmt(throttled, suffix) + "/s").c_str());
+            } else {
+                std::printf("%18s", "-");
+            }
+            std::printf("%18s", (SizeFmt(steady, suffix) + "/s").c_str());
+            if (r.ThrottledTime > 0 && steady > 0) {
+                std::printf("%8.2f", throttled / steady);
+            } else {
+                std::printf("%8s", "-");
+            }
+            std::printf("%9.2f us\n", r.RelaxTime / 1e3);
+        }
+        std::fflush(stdout);
+    }
+}
+
+static void
+PrintShootdown(std::vector<LogicalCore> physical, const Options &options) {
+    /* The other cores of the initiator's socket respond first, then the other sockets */
+    unsigned packageId = physical[0].PackageID;
+    std::stable_partition(physical.begin() + 1, physical.end(),
+                          [&](const LogicalCore &core) { return core.PackageID == packageId; });
+
+    std::vector<int32_t> responders;
+    for (size_t i = 1; i < physical.size(); i++) {
+        responders.push_back(physical[i].Index);
+    }
+    std::vector<unsigned> counts;
+    for (unsigned count = 1; count < responders.size(); count *= 2) {
+        counts.push_back(count);
+    }
+    if (!responders.empty()) {
+        counts.push_back(responders.size());
+    }
+
+    if (options.Output == Format::Text) {
+        std::printf("Name: TLB shootdown (responder stalls >= %llu ns)\n",
+                    (unsigned long long) options.ShootdownThreshold);
+        std::printf("%10s%9s%12s%12s%12s%8s\n", "Responders", "Sockets", "Unmap", "+Flush",
+                    "Stall", "Seen");
+    } else if (options.Output == Format::Csv) {
+        std::printf("responders,sockets,unmaps,unmap_time,baseline_unmaps,baseline_time,stalls,"
+                    "stall_time,baseline_stalls,baseline_stall_time\n");
+    }
+
+    for (unsigned count : counts) {
+        std::vector<unsigned> packages{physical[0].PackageID};
+        for (unsigned i = 1; i <= count; i++) {
+            packages.push_back(physical[i].PackageID);
+        }
+        std::sort(packages.begin(), packages.end());
+        size_t sockets = std::unique(packages.begin(), packages.end()) - packages.begin();
+
+        ShootdownResult r =
+            tlb_shootdown(physical[0].Index, responders.data(), count,
+                          (int64_t) (options.ShootdownTime * 1e6), options.ShootdownThreshold);
+
+        /* The baseline phase ran as long, what it stalled for was not the flushes */
+        double unmap = (double) r.UnmapTime / std::max<uint64_t>(r.Unmaps, 1);
+        double baseline = (double) r.BaselineTime / std::max<uint64_t>(r.BaselineUnmaps, 1);
+        double flushes = (double) std::max<uint64_t>(r.Unmaps * r.Responders, 1);
+        double stall = std::max((r.StallTime - r.BaselineStallTime) / flushes, 0.0);
+        double seen = std::max(((double) r.Stalls - r.BaselineStalls) / flushes, 0.0);
+
+        if (options.Output == Format::Json) {
+            std::printf("{\"responders\":%u,\"sockets\":%zu,\"unmap\":%.2f,\"flush\":%.2f,"
+                        "\"stall\":%.2f,\"seen\":%.4f}\n",
+                        count, sockets, unmap, unmap - baseline, stall, seen);
+        } else if (options.Output == Format::Csv) {
+            std::printf("%u,%zu,%llu,%lld,%llu,%lld,%llu,%lld,%llu,%lld\n", count, sockets,
+                        (unsigned long long) r.Unmaps, (long long) r.UnmapTime,
+                        (unsigned long long) r.BaselineUnmaps, (long long) r.BaselineTime,
+                        (unsigned long long) r.Stalls, (long long) r.StallTime,
+                        (unsigned long long) r.BaselineStalls, (long long) r.BaselineStallTime);
+        } else {
+            std::printf("%10u%9zu%9.2f us%9.2f us%9.2f us%7.1f%%\n", count, sockets, unmap / 1e3,
+                        (unmap - baseline) / 1e3, stall / 1e3, seen * 100);
+        }
+        std::fflush(stdout);
+    }
+}
+
+static void
+PrintPingPong(const std::vector<LogicalCore> &logical, const Options &options) {
+    /* The same CPU, its SMT sibling, another core of the socket and another socket */
+    const LogicalCore &first = logical[0];
+    std::vector<std::pair<const char *, const LogicalCore *>> pairs{{"cpu", &first}};
+    const LogicalCore *smt = nullptr, *core = nullptr, *socket = nullptr;
+    for (const LogicalCore &other : logical) {
+        if (other.Index == first.Index) {
+            continue;
+        }
+        if (other.PackageID != first.PackageID) {
+            socket = socket != nullptr ? socket : &other;
+        } else if (other.CoreID == first.CoreID) {
+            smt = smt != nullptr ? smt : &other;
+        } else {
+            core = core != nullptr ? core : &other;
+        }
+    }
+    for (auto [pair, other] : {std::make_pair("smt", smt), std::make_pair("core", core),
+                               std::make_pair("socket", socket)}) {
+        if (other != nullptr) {
+            pairs.emplace_back(pair, other);
+        }
+    }
+
+    if (options.Output == Format::Text) {
+        std::printf("Name: Futex wake-up latency (one way)\n");
+    } else if (options.Output == Format::Csv) {
+        std::printf("pair,first,second,time,wakeups,wake_time,min_wake,max_wake\n");
+    }
+
+    for (const auto &[pair, second] : pairs) {
+        uint64_t histogram[PINGPONG_BUCKETS] = {};
+        PingPongResult r = futex_pingpong(first.Index, second->Index,
+                                          (int64_t) (options.PingPongTime * 1e6), histogram,
+                                          PINGPONG_BUCKETS);
+        double mean = (double) r.WakeTime / std::max<uint64_t>(r.Wakeups, 1);
+
+        if (options.Output == Format::Json) {
+            std::printf("{\"pair\":\"%s\",\"first\":%u,\"second\":%u,\"wakeups\":%llu,"
+                        "\"min_wake\":%lld,\"mean_wake\":%.2f,\"max_wake\":%lld,\"histogram\":[",
+                        pair, first.Index, second->Index, (unsigned long long) r.Wakeups,
+                        (long long) r.MinWake, mean, (long long) r.MaxWake);
+            for (unsigned i = 0; i < PINGPONG_BUCKETS; i++) {
+                std::printf("%s%llu", i == 0 ? "" : ",", (unsigned long long) histogram[i]);
+            }
+            std::printf("]}\n");
+        } else if (options.Output == Format::Csv) {
+            std::printf("%s,%u,%u,%lld,%llu,%lld,%lld,%lld\n", pair, first.Index, second->Index,
+                        (long long) r.Time, (unsigned long long) r.Wakeups,
+                        (long long) r.WakeTime, (long long) r.MinWake, (long long) r.MaxWake);
+        } else {
+            std::printf("%s (Thread#%u -> Thread#%u): %llu wakeups, min %.2f us, mean %.2f us, "
+                        "max %.2f us\n",
+                        pair, first.Index, second->Index, (unsigned long long) r.Wakeups,
+                        r.MinWake / 1e3, mean / 1e3, r.MaxWake / 1e3);
+            uint64_t peak = *std::max_element(histogram, histogram + PINGPONG_BUCKETS);
+            for (unsigned i = 0; i < PINGPONG_BUCKETS; i++) {
+                if (histogram[i] == 0) {
+                    continue;
+                }
+                /* log2 buckets, the lower bound of each */
+                std::string bar(std::max<uint64_t>(1, 40 * histogram[i] / peak), '#');
+                std::printf("  >= %9.1f us: %8llu %s\n", (1ull << i) / 1e3,
+                            (unsigned long long) histogram[i], bar.c_str());
+            }
+        }
+        std::fflush(stdout);
+    }
+}
+
+static const char *
+TimeSourceName(int32_t clock) {
+    switch (clock) {
+    case CLOCK_MONOTONIC:
+        return "CLOCK_MONOTONIC";
+    case CLOCK_MONOTONIC_RAW:
+        return "CLOCK_MONOTONIC_RAW";
+    case CLOCK_BOOTTIME:
+        return "CLOCK_BOOTTIME";
+    case TIME_SOURCE_COUNTER:
+        return "counter";
+    }
+    return "unknown";
+}
+
+static void
+PrintJitter(const std::vector<LogicalCore> &physical, const Options &options) {
+    /* Every core scans at once, one gap histogram for all of them */
+    std::vector<JitterResult> results(physical.size());
+    std::vector<uint64_t> histograms(physical.size() * JITTER_BUCKETS);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < physical.size(); i++) {
+        threads.emplace_back([&, i]() {
+            set_thread_affinity(physical[i].Index);
+            set_thread_priority();
+            results[i] = jitter_scan((int64_t) (options.Jitter * 1e9), options.JitterThreshold,
+                                     histograms.data() + i * JITTER_BUCKETS, JITTER_BUCKETS);
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    JitterResult total{};
+    uint64_t histogram[JITTER_BUCKETS] = {};
+    for (size_t i = 0; i < physical.size(); i++) {
+        total.Time += results[i].Time;
+        total.Iterations += results[i].Iterations;
+        total.Gaps += results[i].Gaps;
+        total.GapTime += results[i].GapTime;
+        total.MaxGap = std::max(total.MaxGap, results[i].MaxGap);
+        for (unsigned j = 0; j < JITTER_BUCKETS; j++) {
+            histogram[j] += histograms[i * JITTER_BUCKETS + j];
+        }
+    }
+
+    if (options.Output == Format::Json) {
+        std::printf("{\"name\":\"jitter\",\"threshold\":%llu,\"time\":%lld,\"iterations\":%llu,"
+                    "\"gaps\":%llu,\"gap_time\":%lld,\"max_gap\":%lld,\"histogram\":[",
+                    (unsigned long long) options.JitterThreshold, (long long) total.Time,
+                    (unsigned long long) total.Iterations, (unsigned long long) total.Gaps,
+                    (long long) total.GapTime, (long long) total.MaxGap);
+        for (unsigned i = 0; i < JITTER_BUCKETS; i++) {
+            std::printf("%s%llu", i == 0 ? "" : ",", (unsigned long long) histogram[i]);
+        }
+        std::printf("]}\n");
+    } else if (options.Output == Format::Text) {
+        std::printf("Name: VM jitter (gaps >= %llu ns)\n",
+                    (unsigned long long) options.JitterThreshold);
+        std::printf("Time: %.2f sec\n", total.Time / 1e9);
+        std::printf("Gaps: %llu of %llu iters\n", (unsigned long long) total.Gaps,
+                    (unsigned long long) total.Iterations);
+        std::printf("GapTime: %.2f ms (%.3f%%)\n", total.GapTime / 1e6,
+                    total.GapTime * 100.0 / std::max<int64_t>(total.Time, 1));
+        std::printf("MaxGap: %.2f us\n", total.MaxGap / 1e3);
+        uint64_t peak = *std::max_element(histogram, histogram + JITTER_BUCKETS);
+        for (unsigned i = 0; i < JITTER_BUCKETS; i++) {
+            if (histogram[i] == 0) {
+                continue;
+            }
+            std::string bar(std::max<uint64_t>(1, 40 * histogram[i] / peak), '#');
+            std::printf("  >= %9.1f us: %8llu %s\n", (1ull << i) / 1e3,
+                        (unsigned long long) histogram[i], bar.c_str());
+        }
+        std::printf("\n");
+    }
+    /* A CSV stream holds the kernel samples only */
+    std::fflush(stdout);
+}
+
+static void
+PrintClocks(const std::vector<LogicalCore> &logical, const Options &options) {
+    set_thread_affinity(logical[0].Index);
+    set_thread_priority();
+
+    const char *clocks[] = {"clock_realtime", "clock_monotonic",        "clock_monotonic_raw",
+                            "clock_boottime", "clock_monotonic_coarse", "clock_syscall"};
+    std::vector<double> costs;
+    for (const char *name : clocks) {
+        costs.push_back(kernel_inst_time(name));
+    }
+    /* Reads as slow as the forced syscall never made it to the vDSO */
+    double syscallCost = costs.back();
+
+    std::vector<std::tuple<unsigned, unsigned, SkewResult>> skews;
+    for (size_t i = 0; i < logical.size(); i++) {
+        for (size_t j = i + 1; j < logical.size(); j++) {
+            SkewResult r = counter_skew(logical[i].Index, logical[j].Index,
+                                        (int64_t) (options.SkewTime * 1e6));
+            skews.emplace_back(logical[i].Index, logical[j].Index, r);
+        }
+    }
+
+    DriftResult drift = counter_drift((int64_t) (options.DriftTime * 1e6), DEFAULT_DRIFT_INTERVAL);
+
+    const char *source = clock_source();
+    const char *timeSource = TimeSourceName(time_source_clock());
+    bool counterBased = clock_counter_based();
+
+    if (options.Output == Format::Json) {
+        std::printf("{\"clocksource\":\"%s\",\"time_source\":\"%s\",\"counter_based\":%s,"
+                    "\"frequency\":%.3f,\"min_frequency\":%.3f,\"max_frequency\":%.3f,"
+                    "\"drift\":%.6f,\"reads\":{",
+                    source, timeSource, counterBased ? "true" : "false", drift.Frequency,
+                    drift.MinFrequency, drift.MaxFrequency, drift.Drift);
+        for (size_t i = 0; i < costs.size(); i++) {
+            std::printf("%s\"%s\":%.2f", i == 0 ? "" : ",", clocks[i], costs[i]);
+        }
+        std::printf("},\"skews\":[");
+        for (size_t i = 0; i < skews.size(); i++) {
+            const auto &[first, second, r] = skews[i];
+            std::printf("%s{\"first\":%u,\"second\":%u,\"min_offset\":%lld,\"max_offset\":%lld,"
+                        "\"round_trip\":%lld,\"backwards\":%llu}",
+                        i == 0 ? "" : ",", first, second, (long long) r.MinOffset,
+                        (long long) r.MaxOffset, (long long) r.RoundTrip,
+                        (unsigned long long) r.Backwards);
+        }
+        std::printf("]}\n");
+        return;
+    } else if (options.Output == Format::Csv) {
+        std::printf("first,second,rounds,min_offset,max_offset,round_trip,backwards\n");
+        for (const auto &[first, second, r] : skews) {
+            std::printf("%u,%u,%llu,%lld,%lld,%lld,%llu\n", first, second,
+                        (unsigned long long) r.Rounds, (long long) r.MinOffset,
+                        (long long) r.MaxOffset, (long long) r.RoundTrip,
+                        (unsigned long long) r.Backwards);
+        }
+        return;
+    }
+
+    std::printf("Name: Clock sources\n");
+    std::printf("Clocksource: %s\n", source[0] != '\0' ? source : "unknown");
+    std::printf("TimeSource: %s\n", timeSource);
+    for (size_t i = 0; i < costs.size(); i++) {
+        std::string name = clocks[i];
+        std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+        bool syscall = i + 1 == costs.size() || costs[i] > syscallCost / 2;
+        std::printf("  %-24s%8.1f ns  %s\n", name.c_str(), costs[i], syscall ? "syscall" : "vdso");
+    }
+
+    /* Consistent when zero lies within the offset bounds and no read went backwards */
+    unsigned skewed = 0;
+    for (const auto &[first, second, r] : skews) {
+        bool consistent = r.MinOffset <= 0 && 0 <= r.MaxOffset && r.Backwards == 0;
+        skewed += !consistent;
+        std::printf("  Thread#%u -> Thread#%u: offset %lld .. %lld ticks, round trip %lld ticks, "
+                    "%llu backwards%s\n",
+                    first, second, (long long) r.MinOffset, (long long) r.MaxOffset,
+                    (long long) r.RoundTrip, (unsigned long long) r.Backwards,
+                    consistent ? "" : " SKEWED");
+    }
+    if (!skews.empty()) {
+        std::printf("Counter: %zu of %zu pairs consistent\n", skews.size() - skewed, skews.size());
+    }
+
+    double spread = (drift.MaxFrequency - drift.MinFrequency) / drift.Frequency;
+    std::printf("CounterFreq: %.6f GHz over %llu intervals (spread %.2f ppm)\n",
+                drift.Frequency / 1e9, (unsigned long long) drift.Intervals, spread * 1e6);
+    std::printf("Drift: %.3f ppm/sec\n", drift.Drift);
+    if (counterBased) {
+        std::printf("Note: CLOCK_MONOTONIC reads the counter (clocksource %s), the drift is not "
+                    "against an independent clock\n",
+                    source);
+    }
+}
+
+static bool
+IsRandomAccess(const std::string &name) {
+    return name == "mem_gather" || name == "mem_scatter";
+}
+
+static bool
+IsStrideWalk(const std::string &name) {
+    return name == "mem_stride" || name == "mem_stride_lat";
+}
+
+/* Bytes read and written per element of a cvt_<source>_<target> kernel, 0 for the others */
+static unsigned
+ConvertElemBytes(const std::string &name) {
+    static const std::map<std::string, unsigned> widths{
+        {"f32", 4}, {"bf16", 2}, {"f16", 2}, {"s8", 1}};
+
+    if (name.rfind("cvt_", 0) != 0) {
+        return 0;
+    }
+    size_t split = name.find('_', 4);
+    if (split == std::string::npos) {
+        return 0;
+    }
+    auto source = widths.find(name.substr(4, split - 4));
+    auto target = widths.find(name.substr(split + 1));
+    if (source == widths.end() || target == widths.end()) {
+        return 0;
+    }
+    return source->second + target->second;
+}
+
+static const char *
+WalkName(int32_t walk) {
+    switch (walk) {
+    case WALK_BACKWARD:
+        return "backward";
+    case WALK_PAGES:
+        return "pages";
+    default:
+        return "forward";
+    }
+}
+
+static KernelJob
+MakeJob(const std::string &name, const LogicalCore &core, const KernelParams &params,
+        const Options &options) {
+    uint64_t steps = params.Steps;
+    if (name == "mem_chase" || name == "mem_mlp") {
+        /* Same number of passes over the chain as over the bandwidth buffers */
+        steps *= std::max<uint64_t>(params.Bytes / CHASE_LINE_SIZE, 2);
+    }
+
+    KernelJob job{};
+    job.Name = name.c_str();
+    job.CoreId = core.Index;
+    job.Flush = params.Flush;
+    job.Pattern = params.Pattern;
+    job.Chains = params.Chains;
+    job.Walk = params.Walk;
+    job.Stride = params.Stride;
+    job.Prefetch = params.Prefetch;
+    job.Steps = steps;
+    job.Bytes = params.Bytes;
+    job.Duration = (int64_t) (options.Report * 1e9);
+    job.Verify = options.Verify;
+    job.Discard = options.DiscardPreempted;
+    return job;
+}
+
+/* Exits when a run fails or a verified call does not match the reference model */
+static void
+RunJobs(std::vector<KernelJob> &jobs) {
+    if (run_kernels(jobs.data(), jobs.size()) != 0) {
+        std::fprintf(stderr, "Failed to run kernel `%s`!\n", jobs[0].Name);
+        std::exit(1);
+    }
+
+    for (const KernelJob &job : jobs) {
+        if (job.Mismatches != 0) {
+            std::fprintf(stderr, "%s output mismatch on Thread#%d (%llu of %llu calls)!\n",
+                         job.Name, job.CoreId, (unsigned long long) job.Mismatches,
+                         (unsigned long long) (job.Iterations + job.Discarded));
+            std::exit(1);
+        }
+    }
+}
+
+static Sample
+Measure(const std::string &name, const std::vector<LogicalCore> &cores,
+        const KernelParams &params, const Options &options) {
+    std::vector<KernelJob> jobs;
+    for (const LogicalCore &core : cores) {
+        jobs.push_back(MakeJob(name, core, params, options));
+    }
+    RunJobs(jobs);
+    uint64_t bytes = params.Bytes;
+
+    /* Calibrated jobs report the steps they picked */
+    Sample sample{name, kernel_unit(name.c_str()), (unsigned) cores.size(), jobs[0].Steps, bytes};
+    std::map<unsigned, std::pair<double, uint64_t>> packages;
+    std::map<unsigned, unsigned> packageCores;
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        double time = jobs[i].Time / 1e9;
+        sample.Time += time;
+        sample.Ops += jobs[i].Ops;
+        sample.Iterations += jobs[i].Iterations;
+        sample.Preempted += jobs[i].Preempted;
+        sample.Discarded += jobs[i].Discarded;
+        sample.LostTime += jobs[i].LostTime / 1e9 / jobs.size();
+
+        auto &package = packages[cores[i].PackageID];
+        package.first += time;
+        package.second += jobs[i].Ops;
+        packageCores[cores[i].PackageID]++;
+    }
+
+    sample.Time /= sample.Cores;
+    sample.Peak = sample.Time > 0 ? sample.Ops / sample.Time : 0;
+    if (name == "mem_mlp") {
+        sample.Chains = params.Chains != 0 ? params.Chains : DEFAULT_MLP_CHAINS;
+    }
+    if (IsStrideWalk(name)) {
+        sample.Walk = params.Walk;
+        sample.Stride = params.Stride != 0 ? params.Stride : CHASE_LINE_SIZE;
+        sample.Prefetch = params.Prefetch;
+    }
+    for (const auto &[packageId, package] : packages) {
+        double time = package.first / packageCores[packageId];
+        sample.Packages[packageId] = time > 0 ? package.second / time : 0;
+    }
+
+    return sample;
+}
+
+static void
+PrintSample(const Sample &sample, Format format) {
+    const char *suffix = UnitSuffix(sample.Unit);
+
+    if (format == Format::Json) {
+        std::printf("{\"name\":\"%s\",\"unit\":\"%s\",\"cores\":%u,\"steps\":%llu,\"bytes\":%llu,"
+                    "\"time\":%.6f,\"ops\":%llu,\"iterations\":%llu,\"peak\":%.6e,"
+                    "\"per_core\":%.6e,\"sockets\":{",
+                    sample.Name.c_str(), sample.Unit.c_str(), sample.Cores,
+                    (unsigned long long) sample.Steps, (unsigned long long) sample.Bytes,
+                    sample.Time, (unsigned long long) sample.Ops,
+                    (unsigned long long) sample.Iterations, sample.Peak,
+                    sample.Peak / sample.Cores);
+        for (auto it = sample.Packages.begin(); it != sample.Packages.end(); ++it) {
+            std::printf("%s\"%u\":%.6e", it == sample.Packages.begin() ? "" : ",", it->first,
+                        it->second);
+        }
+        std::printf("}");
+        if (sample.Chains != 0) {
+            std::printf(",\"chains\":%d,\"in_flight\":%.4f", sample.Chains, sample.InFlight);
+        }
+        if (sample.Stride != 0) {
+            std::printf(",\"walk\":\"%s\",\"stride\":%d,\"prefetch\":%d", WalkName(sample.Walk),
+                        sample.Stride, sample.Prefetch);
+        }
+        std::printf(",\"preempted\":%llu,\"discarded\":%llu,\"lost_time\":%.6f}\n",
+                    (unsigned long long) sample.Preempted, (unsigned long long) sample.Discarded,
+                    sample.LostTime);
+    } else if (format == Format::Csv) {
+        std::printf("%s,%s,%u,%llu,%llu,%.6f,%llu,%llu,%.6e,%.6e,%d,%.4f,%s,%d,%d,%llu,%llu,%.6f\n",
+                    sample.Name.c_str(), sample.Unit.c_str(), sample.Cores,
+                    (unsigned long long) sample.Steps, (unsigned long long) sample.Bytes,
+                    sample.Time, (unsigned long long) sample.Ops,
+                    (unsigned long long) sample.Iterations, sample.Peak, sample.Peak / sample.Cores,
+                    sample.Chains, sample.InFlight, sample.Stride != 0 ? WalkName(sample.Walk) : "",
+                    sample.Stride, sample.Prefetch, (unsigned long long) sample.Preempted,
+                    (unsigned long long) sample.Discarded, sample.LostTime);
+    } else {
+        std::string name = sample.Name;
+        std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+        std::printf("Name: %s\n", name.c_str());
+        std::printf("Time: %.2f sec\n", sample.Time);
+        std::printf("%s: %s\n", suffix, SizeFmt(sample.Ops, suffix).c_str());
+        std::printf("Peak: %s/sec\n", SizeFmt(sample.Peak, suffix).c_str());
+        std::printf("PerCore: %s/sec\n", SizeFmt(sample.Peak / sample.Cores, suffix).c_str());
+        if (IsRandomAccess(sample.Name)) {
+            double lookups = sample.Peak / sizeof(uint32_t);
+            std::printf("Lookups: %s/sec\n", SizeFmt(lookups, "").c_str());
+            std::printf("PerCoreLookups: %s/sec\n", SizeFmt(lookups / sample.Cores, "").c_str());
+        }
+        if (unsigned elemBytes = ConvertElemBytes(sample.Name)) {
+            std::printf("Bandwidth: %s/sec\n", SizeFmt(sample.Peak * elemBytes, "B").c_str());
+        }
+        if (sample.Chains != 0) {
+            std::printf("Bandwidth: %s/sec\n", SizeFmt(sample.Peak * CHASE_LINE_SIZE, "B").c_str());
+            std::printf("Chains: %d\n", sample.Chains);
+        }
+        if (sample.InFlight != 0) {
+            std::printf("InFlight: %.2f misses\n", sample.InFlight);
+        }
+        if (sample.Stride != 0) {
+            if (sample.Name == "mem_stride_lat" && sample.Peak > 0) {
+                std::printf("Latency: %.2f ns\n", 1e9 * sample.Cores / sample.Peak);
+            }
+            std::printf("Walk: %s\n", WalkName(sample.Walk));
+            std::printf("Stride: %d B\n", sample.Stride);
+            std::printf("Prefetch: %d accesses\n", sample.Prefetch);
+        }
+        if (uint64_t opsPerElem = kernel_ops_per_elem(sample.Name.c_str())) {
+            double ops = sample.Peak * opsPerElem;
+            std::printf("PeakOps: %s/sec\n", SizeFmt(ops, "Ops").c_str());
+            std::printf("PerCoreOps: %s/sec\n", SizeFmt(ops / sample.Cores, "Ops").c_str());
+        }
+        for (const auto &[packageId, peak] : sample.Packages) {
+            std::printf("Socket#%u: %s/sec\n", packageId, SizeFmt(peak, suffix).c_str());
+        }
+        if (sample.Bytes != 0) {
+            std::printf("Size: %s\n", SizeFmt(sample.Bytes, "B").c_str());
+        }
+        std::printf("Cores: %u\n", sample.Cores);
+        std::printf("Bench: %llu iters/report\n", (unsigned long long) sample.Iterations);
+        std::printf("Preempted: %llu samples (%llu discarded)\n",
+                    (unsigned long long) sample.Preempted, (unsigned long long) sample.Discarded);
+        std::printf("LostTime: %.2f ms\n\n", sample.LostTime * 1e3);
+    }
+    std::fflush(stdout);
+}
+
+struct MixGroup {
+    std::string Name;
+    std::vector<LogicalCore> Cores;
+    KernelParams Params;
+};
+
+/* NAME[:N|P%] specs, each group takes the next N physical cores or P% of them */
+static std::vector<MixGroup>
+MixGroups(const std::vector<LogicalCore> &physical, const Options &options) {
+    std::vector<MixGroup> groups;
+    size_t next = 0;
+    for (const std::string &spec : options.Mix) {
+        size_t split = spec.find(':');
+        std::string name = spec.substr(0, split);
+        std::string count = split != std::string::npos ? spec.substr(split + 1) : "1";
+        if (!kernel_support(name.c_str())) {
+            std::fprintf(stderr, "Kernel `%s` not supported!\n", name.c_str());
+            std::exit(1);
+        }
+
+        double number = 0;
+        bool percent = !count.empty() && count.back() == '%';
+        if (percent) {
+            count.pop_back();
+        }
+        if (!ParseNumber(count.c_str(), number)) {
+            std::fprintf(stderr, "Invalid core count in `%s`\n", spec.c_str());
+            std::exit(2);
+        }
+        size_t cores = percent ? (size_t) (physical.size() * number / 100) : (size_t) number;
+        if (cores == 0 || next + cores > physical.size()) {
+            std::fprintf(stderr, "Not enough cores for `%s`!\n", spec.c_str());
+            std::exit(1);
+        }
+
+        bool memory = name.rfind("mem_", 0) == 0 || name.rfind("cvt_", 0) == 0;
+        KernelParams params{memory ? options.MemPasses : options.MixSteps,
+                            memory ? options.MemSize : 0,
+                            options.MemFlush,
+                            options.Pattern,
+                            options.Chains,
+                            options.Walk,
+                            options.Stride,
+                            options.Prefetch};
+        groups.push_back({name, std::vector<LogicalCore>(physical.begin() + next,
+                                                         physical.begin() + next + cores),
+                          params});
+        next += cores;
+    }
+    return groups;
+}
+
+/* Ops per second of a group, the sum over its cores */
+static double
+GroupRate(const std::vector<KernelJob> &jobs, size_t first, size_t count) {
+    double time = 0;
+    uint64_t ops = 0;
+    for (size_t i = first; i < first + count; i++) {
+        time += jobs[i].Time / 1e9;
+        ops += jobs[i].Ops;
+    }
+    time /= count;
+    return time > 0 ? ops / time : 0;
+}
+
+static void
+PrintMix(const std::vector<MixGroup> &groups, const Options &options) {
+    /* Every group alone on its cores, then all of them at once */
+    std::vector<double> isolated;
+    std::vector<KernelJob> mixed;
+    for (const MixGroup &group : groups) {
+        std::vector<KernelJob> jobs;
+        for (const LogicalCore &core : group.Cores) {
+            jobs.push_back(MakeJob(group.Name, core, group.Params, options));
+        }
+        RunJobs(jobs);
+        isolated.push_back(GroupRate(jobs, 0, jobs.size()));
+        mixed.insert(mixed.end(), jobs.begin(), jobs.end());
+    }
+    RunJobs(mixed);
+
+    if (options.Output == Format::Text) {
+        std::printf("Name: Co-scheduled mix\n");
+    }
+
+    size_t first = 0;
+    for (size_t i = 0; i < groups.size(); i++) {
+        const MixGroup &group = groups[i];
+        const char *suffix = UnitSuffix(kernel_unit(group.Name.c_str()));
+        double rate = GroupRate(mixed, first, group.Cores.size());
+        double ratio = isolated[i] > 0 ? rate / isolated[i] : 0;
+        first += group.Cores.size();
+
+        if (options.Output == Format::Json) {
+            std::printf("{\"name\":\"mix\",\"kernel\":\"%s\",\"cores\":%zu,\"isolated\":%.6e,"
+                        "\"mixed\":%.6e,\"ratio\":%.4f}\n",
+                        group.Name.c_str(), group.Cores.size(), isolated[i], rate, ratio);
+        } else if (options.Output == Format::Csv) {
+            std::printf("%s,%zu,%.6e,%.6e,%.4f\n", group.Name.c_str(), group.Cores.size(),
+                        isolated[i], rate, ratio);
+        } else {
+            std::printf("%s x%zu: isolated %s/sec, mixed %s/sec (%.1f%%)\n", group.Name.c_str(),
+                        group.Cores.size(), SizeFmt(isolated[i], suffix).c_str(),
+                        SizeFmt(rate, suffix).c_str(), ratio * 100);
+        }
+    }
+    if (options.Output == Format::Text) {
+        std::printf("\n");
+    }
+    std::fflush(stdout);
+}
+
+int
+main(int argc, char **argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    init();
+
+    if (debug_build()) {
+        std::fprintf(stderr, "WARNING: Debug build of VmOpsMem is used!\n");
+    }
+
+    std::vector<LogicalCore> logical = LogicalCores();
+
+    if (options.Topology) {
+        PrintTopology(logical, options.Output);
+        return 0;
+    }
+
+    if (options.List) {
+        for (unsigned i = 0; i < kernel_count(); i++) {
+            const char *name = kernel_name(i);
+            std::printf("%s %s %s\n", name, kernel_unit(name),
+                        kernel_support(name) ? "supported" : "unsupported");
+        }
+        std::printf("jit instructions: %s\n", jit_instructions());
+        return 0;
+    }
+
+    if (options.Seed) {
+        set_input_seed(options.SeedValue);
+    }
+
+    set_sample_time((int64_t) (options.SampleTime * 1e6));
+
+    if (!options.Jit.empty()) {
+        int32_t status = set_jit_mix(options.Jit.c_str(), options.JitUnroll,
+                                     options.JitAccumulators);
+        if (status != JIT_OK) {
+            std::fprintf(stderr, "Failed to generate jit mix `%s` (%d)\n", options.Jit.c_str(),
+                         status);
+            return 1;
+        }
+        options.Ops = {"jit"};
+    }
+
+    std::vector<std::string> ops;
+    for (unsigned i = 0; i < kernel_count(); i++) {
+        std::string name = kernel_name(i);
+        bool memory = name.rfind("mem_", 0) == 0 || name.rfind("cvt_", 0) == 0;
+        bool paging = name.rfind("vm_", 0) == 0;
+        bool exits = name.rfind("exit_", 0) == 0 || name.rfind("sys_", 0) == 0 ||
+                     name.rfind("clock_", 0) == 0;
+        bool selected = options.Ops.empty()
+                            ? (!memory || options.Mem) && (!paging || options.Paging) &&
+                                  (!exits || options.Exits) && !IsChainVariant(name)
+                            : std::find(options.Ops.begin(), options.Ops.end(), name) !=
+                                  options.Ops.end();
+        if (selected && kernel_support(name.c_str())) {
+            ops.push_back(name);
+        }
+    }
+
+    if (ops.empty()) {
+        std::fprintf(stderr, "No ops supported\n");
+        return 1;
+    }
+
+    std::vector<LogicalCore> physical;
+    for (const LogicalCore &core : logical) {
+        if (core.ThreadID == 0) {
+            physical.push_back(core);
+        }
+    }
+    if (options.Cores != 0) {
+        if (options.Cores > physical.size()) {
+            std::fprintf(stderr, "Only %zu physical cores available\n", physical.size());
+            return 1;
+        }
+        physical.resize(options.Cores);
+    }
+
+    if (options.Verify) {
+        for (const std::string &name : ops) {
+            if (verify_kernel(name.c_str(), 0) == VERIFY_MISMATCH) {
+                std::fprintf(stderr, "%s output mismatch!\n", name.c_str());
+                return 1;
+            }
+        }
+    }
+
+    if (options.Table) {
+        std::vector<std::string> instructions;
+        for (const std::string &name : ops) {
+            if (kernel_ops_per_inst(name.c_str()) != 0 && !IsChainVariant(name)) {
+                instructions.push_back(name);
+            }
+        }
+        PrintTable(instructions, physical[0], options.Output);
+        return 0;
+    }
+
+    if (options.Warmup) {
+        PrintWarmup(ops, physical[0], options);
+        return 0;
+    }
+
+    if (options.Shootdown) {
+        if (physical.size() < 2) {
+            /* The responders are the other physical cores, there is nothing to flush remotely */
+            std::fprintf(stderr, "TLB shootdown needs >= 2 CPUs, %zu physical core available\n",
+                         physical.size());
+            return 1;
+        }
+        PrintShootdown(physical, options);
+        return 0;
+    }
+
+    if (options.Clocks) {
+        PrintClocks(logical, options);
+        return 0;
+    }
+
+    if (options.PingPong) {
+        PrintPingPong(logical, options);
+        return 0;
+    }
+
+    if (!options.Mix.empty()) {
+        std::vector<MixGroup> groups = MixGroups(physical, options);
+        if (options.Output == Format::Csv) {
+            std::printf("kernel,cores,isolated,mixed,ratio\n");
+        }
+        for (uint64_t round = 0; options.Rounds == 0 || round < options.Rounds; round++) {
+            PrintMix(groups, options);
+        }
+        return 0;
+    }
+
+    std::vector<unsigned> coreCounts{(unsigned) physical.size()};
+    if (options.SweepMode == Sweep::Cores) {
+        coreCounts.clear();
+        for (unsigned count = 1; count < physical.size(); count *= 2) {
+            coreCounts.push_back(count);
+        }
+        coreCounts.push_back(physical.size());
+    }
+    if (options.SweepMode == Sweep::Chains) {
+        /* One core, then every core of its socket, which come first */
+        unsigned packageId = physical[0].PackageID;
+        auto socket = std::stable_partition(physical.begin(), physical.end(),
+                                            [&](const LogicalCore &core) {
+                                                return core.PackageID == packageId;
+                                            });
+        coreCounts = {1};
+        if (socket - physical.begin() > 1) {
+            coreCounts.push_back(socket - physical.begin());
+        }
+    }
+
+    std::vector<int32_t> chainCounts{options.Chains};
+    if (options.SweepMode == Sweep::Chains) {
+        chainCounts.clear();
+        for (int32_t chains = 1; chains <= MLP_MAX_CHAINS; chains++) {
+            chainCounts.push_back(chains);
+        }
+    }
+
+    /* Strides from a cache line to past a page, distances from none to a page of lines */
+    std::vector<int32_t> strides{options.Stride};
+    if (options.SweepMode == Sweep::Stride) {
+        strides.clear();
+        for (int32_t stride = CHASE_LINE_SIZE; stride <= SWEEP_MAX_STRIDE; stride *= 2) {
+            strides.push_back(stride);
+        }
+    }
+
+    std::vector<int32_t> distances{options.Prefetch};
+    if (options.SweepMode == Sweep::Prefetch) {
+        distances = {0};
+        for (int32_t prefetch = 1; prefetch <= SWEEP_MAX_PREFETCH; prefetch *= 2) {
+            distances.push_back(prefetch);
+        }
+    }
+
+    if (options.Output == Format::Text && options.Steps == 0) {
+        std::printf("Monitor started .... (Report every %g seconds with %g ms samples)\n",
+                    options.Report, options.SampleTime);
+    } else if (options.Output == Format::Text) {
+        std::printf("Monitor started .... (Report every %g seconds with %llu Steps)\n",
+                    options.Report, (unsigned long long) options.Steps);
+    }
+
+    if (options.Output == Format::Text) {
+        std::printf("System Topology\n");
+        PrintTopology(logical, Format::Text);
+        std::printf("---\n");
+    } else if (options.Output == Format::Csv) {
+        std::printf("name,unit,cores,steps,bytes,time,ops,iterations,peak,per_core,chains,"
+                    "in_flight,walk,stride,prefetch,preempted,discarded,lost_time\n");
+    }
+
+    for (uint64_t round = 0; options.Rounds == 0 || round < options.Rounds; round++) {
+        for (const std::string &name : ops) {
+            bool memory = name.rfind("mem_", 0) == 0 || name.rfind("cvt_", 0) == 0;
+
+            if (options.Jitter > 0) {
+                PrintJitter(physical, options);
+            }
+
+            std::vector<uint64_t> sizes{memory ? options.MemSize : 0};
+            if (name == "jit") {
+                sizes = {options.JitSize};
+            }
+            if (name.rfind("vm_", 0) == 0) {
+                sizes = {options.VmSize};
+            }
+            if (memory && options.SweepMode == Sweep::Size) {
+                sizes.clear();
+                for (uint64_t size = options.SweepMin; size < options.MemSize; size *= 2) {
+                    sizes.push_back(size);
+                }
+                sizes.push_back(options.MemSize);
+            }
+
+            for (unsigned count : coreCounts) {
+                std::vector<LogicalCore> cores(physical.begin(), physical.begin() + count);
+                for (uint64_t size : sizes) {
+                    KernelParams params{memory ? options.MemPasses : options.Steps,
+                                        size,
+                                        options.MemFlush,
+                                        options.Pattern,
+                                        options.Chains,
+                                        options.Walk,
+                                        options.Stride,
+                                        options.Prefetch};
+                    if (IsStrideWalk(name)) {
+                        for (int32_t stride : strides) {
+                            for (int32_t prefetch : distances) {
+                                params.Stride = stride;
+                                params.Prefetch = prefetch;
+                                PrintSample(Measure(name, cores, params, options),
+                                            options.Output);
+                            }
+                        }
+                        continue;
+                    }
+                    if (name != "mem_mlp") {
+                        PrintSample(Measure(name, cores, params, options), options.Output);
+                        continue;
+                    }
+
+                    /* Little's law, the single chain gives the latency of one miss */
+                    double chainRate = 0;
+                    for (int32_t chains : chainCounts) {
+                        params.Chains = chains;
+                        Sample sample = Measure(name, cores, params, options);
+                        if (chains == 1) {
+                            chainRate = sample.Peak / sample.Cores;
+                        }
+                        if (chainRate > 0) {
+                            sample.InFlight = sample.Peak / sample.Cores / chainRate;
+                        }
+                        PrintSample(sample, options.Output);
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -6,42 +6,241 @@ import vm_ops_mem as vom
 def main():
     vom.init()
 
-    available_ops = list(vom.OpsType)
-    convert_ops = lambda name: vom.OpsType[name]
+    available_ops = (
+        list(vom.OpsType)
+        + list(vom.MathOpsType)
+        + list(vom.MemOpsType)
+        + list(vom.ConvertOpsType)
+        + list(vom.PagingOpsType)
+        + list(vom.ExitOpsType)
+    )
+
+    def convert_ops(name):
+        for ops_type in (
+            vom.OpsType,
+            vom.MathOpsType,
+            vom.ConvertOpsType,
+            vom.PagingOpsType,
+            vom.ExitOpsType,
+        ):
+            if name in ops_type.__members__:
+                return ops_type[name]
+        return vom.MemOpsType[name]
 
     parser = argparse.ArgumentParser()
     parser.add_argument('-r', '--report', type=int, default=60)
-    parser.add_argument('-s', '--steps', type=int, default=int(1e9))
+    parser.add_argument('-s', '--steps', type=int, default=0)
+    parser.add_argument('--sample-time', type=float, default=vom.DEFAULT_SAMPLE_TIME / 1e6)
     parser.add_argument("-c", "--cores", type=int, default=None)
     parser.add_argument('-o', '--ops', type=convert_ops, choices=available_ops, nargs='+', default=[])
+    parser.add_argument('-j', '--jitter', type=float, default=0)
+    parser.add_argument('--jitter-threshold', type=int, default=10000)
+    parser.add_argument('--discard-preempted', action='store_true')
+    parser.add_argument('-m', '--mem', action='store_true')
+    parser.add_argument('--mem-size', type=int, default=vom.DEFAULT_MEM_SIZE)
+    parser.add_argument('--mem-passes', type=int, default=0)
+    parser.add_argument('--mem-flush', action='store_true')
+    parser.add_argument('--pattern', choices=list(vom.PATTERNS), default='uniform')
+    parser.add_argument(
+        '--chains', type=int, choices=range(1, vom.MLP_MAX_CHAINS + 1), nargs='+', default=[0]
+    )
+    parser.add_argument('--walk', choices=list(vom.WALKS), default='forward')
+    parser.add_argument('--stride', type=int, nargs='+', default=[0])
+    parser.add_argument('--prefetch', type=int, nargs='+', default=[0])
+    parser.add_argument('--paging', action='store_true')
+    parser.add_argument('--vm-size', type=int, default=0)
+    parser.add_argument('--shootdown', action='store_true')
+    parser.add_argument('--shootdown-time', type=float, default=vom.DEFAULT_SHOOTDOWN_TIME / 1e6)
+    parser.add_argument('--shootdown-threshold', type=int, default=vom.DEFAULT_SHOOTDOWN_THRESHOLD)
+    parser.add_argument('--exits', action='store_true')
+    parser.add_argument('--pingpong', action='store_true')
+    parser.add_argument('--pingpong-time', type=float, default=vom.DEFAULT_PINGPONG_TIME / 1e6)
+    parser.add_argument('--clocks', action='store_true')
+    parser.add_argument('--skew-time', type=float, default=vom.DEFAULT_SKEW_TIME / 1e6)
+    parser.add_argument('--drift-time', type=float, default=vom.DEFAULT_DRIFT_TIME / 1e6)
+    parser.add_argument('-v', '--verify', action='store_true')
+    parser.add_argument('--seed', type=int, default=None)
+    parser.add_argument('--mix', type=str, nargs='+', default=[])
+    parser.add_argument('--mix-steps', type=int, default=0)
+    parser.add_argument('--table', action='store_true')
+    parser.add_argument('--warmup', choices=list(vom.WARMUP_LEADS), default=None)
+    parser.add_argument('--warmup-time', type=float, default=vom.DEFAULT_WARMUP_TIME / 1e6)
+    parser.add_argument('--warmup-slice', type=float, default=vom.DEFAULT_WARMUP_SLICE / 1e3)
+    parser.add_argument('--jit', type=str, default=None)
+    parser.add_argument('--jit-unroll', type=int, default=vom.DEFAULT_JIT_UNROLL)
+    parser.add_argument('--jit-acc', type=int, default=vom.DEFAULT_JIT_ACCUMULATORS)
+    parser.add_argument('--jit-size', type=int, default=0)
     args = parser.parse_args()
 
-    supported_ops = vom.supported_ops()
+    if args.seed is not None:
+        vom.set_input_seed(args.seed)
+
+    vom.set_sample_time(int(args.sample_time * 1e6))
 
-    if len(args.ops):
-        supported_ops = [op for op in args.ops if op in supported_ops]
+    supported_ops = vom.supported_ops() + vom.supported_math_ops()
+
+    if args.jit is not None:
+        vom.set_jit_mix(args.jit, args.jit_unroll, args.jit_acc)
+        supported_ops = [vom.JitOpsType.JIT]
+    elif len(args.ops):
+        # By name, IntEnum members of different op types with the same value compare equal
+        supported_names = {
+            op.name
+            for op in supported_ops
+            + vom.supported_mem_ops()
+            + vom.supported_convert_ops()
+            + vom.supported_paging_ops()
+            + vom.supported_exit_ops()
+        }
+        supported_ops = [op for op in args.ops if op.name in supported_names]
+    else:
+        if args.mem:
+            supported_ops = supported_ops + vom.supported_mem_ops() + vom.supported_convert_ops()
+        if args.paging:
+            supported_ops = supported_ops + vom.supported_paging_ops()
+        if args.exits:
+            supported_ops = supported_ops + vom.supported_exit_ops()
 
     if len(supported_ops) == 0:
         raise RuntimeError("No ops supported")
 
-    steps_fmt, steps_unit = vom.sizeof_fmt(args.steps, "Steps", 1000.0)
-    steps_fmt = int(steps_fmt)
+    if args.steps:
+        steps_fmt, steps_unit = vom.sizeof_fmt(args.steps, "Steps", 1000.0)
+        steps_str = f"{int(steps_fmt)} {steps_unit}"
+    else:
+        steps_str = f"{args.sample_time:g} ms calibrated samples"
 
-    print(
-        f"Monitor started .... (Report every {args.report} seconds with {steps_fmt} {steps_unit})"
-    )
+    print(f"Monitor started .... (Report every {args.report} seconds with {steps_str})")
     print(f"System Topology")
     print(json.dumps(vom.system_topology(), indent=4))
     print(f"---")
 
-    monitor = vom.PerfMonitor(args.cores)
+    monitor = vom.PerfMonitor(args.cores, args.discard_preempted, args.verify)
+
+    if args.table:
+        ops = [op for op in supported_ops if isinstance(op, (vom.OpsType, vom.ExitOpsType))]
+        print(monitor.table(ops))
+        return
+
+    if args.clocks:
+        print(
+            monitor.clocks(
+                int(args.skew_time * 1e6), int(args.drift_time * 1e6), vom.DEFAULT_DRIFT_INTERVAL
+            )
+        )
+        return
+
+    if args.pingpong:
+        print(monitor.pingpong(int(args.pingpong_time * 1e6)))
+        return
+
+    if args.shootdown:
+        print(monitor.shootdown(int(args.shootdown_time * 1e6), args.shootdown_threshold))
+        return
+
+    if args.warmup is not None:
+        report = monitor.warmup(
+            supported_ops,
+            args.warmup,
+            int(args.warmup_time * 1e6),
+            int(args.warmup_slice * 1e3),
+            mem_size=args.mem_size,
+            vm_size=args.vm_size,
+            jit_size=args.jit_size,
+        )
+        print(report)
+        return
+
+    if len(args.mix):
+        groups = monitor.mix_groups(
+            args.mix,
+            args.mix_steps,
+            args.mem_passes,
+            args.mem_size,
+            args.mem_flush,
+            vom.PATTERNS[args.pattern],
+            args.chains[0],
+            vom.WALKS[args.walk],
+            args.stride[0],
+            args.prefetch[0],
+        )
+        while True:
+            print(monitor.measure_mix(groups, args.report))
 
     op_id = 0
 
     while True:
         op = supported_ops[op_id]
 
-        report = monitor.measure(op, args.steps, args.report)
+        if args.jitter > 0:
+            print(monitor.jitter(args.jitter, args.jitter_threshold))
+
+        if isinstance(op, vom.MemOpsType) and op.name == "MEM_MLP":
+            # A single chain first gives the latency the misses in flight are derived from
+            chain_rate = 0
+            for chains in args.chains:
+                report = monitor.measure(
+                    op,
+                    args.mem_passes,
+                    args.report,
+                    mem_size=args.mem_size,
+                    mem_flush=args.mem_flush,
+                    mem_chains=chains,
+                )
+                if chains == 1 and report.elapsed_time:
+                    chain_rate = report.total_ops / report.elapsed_time
+                report.chains = chains or vom.DEFAULT_MLP_CHAINS
+                report.chain_rate = chain_rate
+                print(report)
+            op_id = (op_id + 1) % len(supported_ops)
+            continue
+        elif isinstance(op, vom.MemOpsType) and op.name in ("MEM_STRIDE", "MEM_STRIDE_LAT"):
+            # Every stride at every prefetch distance, 0 leaves it to the hardware prefetchers
+            for stride in args.stride:
+                for prefetch in args.prefetch:
+                    report = monitor.measure(
+                        op,
+                        args.mem_passes,
+                        args.report,
+                        mem_size=args.mem_size,
+                        mem_flush=args.mem_flush,
+                        mem_walk=vom.WALKS[args.walk],
+                        mem_stride=stride,
+                        mem_prefetch=prefetch,
+                    )
+                    report.walk = vom.WALKS[args.walk]
+                    report.stride = stride
+                    report.prefetch = prefetch
+                    print(report)
+            op_id = (op_id + 1) % len(supported_ops)
+            continue
+        elif isinstance(op, vom.MemOpsType):
+            report = monitor.measure(
+                op,
+                args.mem_passes,
+                args.report,
+                mem_size=args.mem_size,
+                mem_flush=args.mem_flush,
+                mem_pattern=vom.PATTERNS[args.pattern],
+            )
+        elif isinstance(op, vom.ConvertOpsType):
+            # Passes over the buffers like the memory kernels, --mem-size picks L1, L2 or DRAM
+            report = monitor.measure(
+                op,
+                args.mem_passes,
+                args.report,
+                mem_size=args.mem_size,
+                mem_flush=args.mem_flush,
+            )
+        elif isinstance(op, vom.ExitOpsType):
+            report = monitor.measure(op, args.steps, args.report, mem_size=0)
+        elif isinstance(op, vom.PagingOpsType):
+            # A 0 size lets the kernels pick theirs, one page per call or a 64 MiB fault region
+            report = monitor.measure(op, args.steps, args.report, mem_size=args.vm_size)
+        elif isinstance(op, vom.JitOpsType):
+            report = monitor.measure(op, args.steps, args.report, mem_size=args.jit_size)
+        else:
+            report = monitor.measure(op, args.steps, args.report)
         print(report)
 
         op_id = (op_id + 1) % len(supported_ops)
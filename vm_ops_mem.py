@@ -1,9 +1,12 @@
 import os
 import enum
 
+import collections
 import concurrent.futures
 
+import sys
 import ctypes
+import importlib
 
 class ArmOpsType(enum.IntEnum):
     # MATRIX MULTIPLY ACCUMULATE
@@ -35,6 +38,81 @@ class X86OpsType(enum.IntEnum):
     VNN_F16_F32 = enum.auto()
 
 
+class MemOpsType(enum.IntEnum):
+    # MEMORY BANDWIDTH
+    MEM_LOAD = enum.auto()     # read only (x86 vmovdqa64, arm ld1)
+    MEM_STORE = enum.auto()    # write only, write-allocate (x86 vmovdqa64, arm st1)
+    MEM_STORE_NT = enum.auto() # write only, non-temporal (x86 vmovntdq, arm stnp)
+    MEM_RMW = enum.auto()      # read-modify-write
+    MEM_TRIAD = enum.auto()    # a[i] = b[i] + s * c[i]
+
+    # POINTER CHASE
+    MEM_CHASE = enum.auto()    # dependent loads over a random single cycle of cache lines
+    MEM_MLP = enum.auto()      # independent chains interleaved, misses in flight
+
+    # RANDOM ACCESS
+    MEM_GATHER = enum.auto()   # 4 byte lookups at generated indices (x86 vpgatherdd, arm ld1 lane)
+    MEM_SCATTER = enum.auto()  # 4 byte stores at generated indices (x86 vpscatterdd, arm st1 lane)
+
+    # STRIDED WALK, one 8 byte load per access, optional software prefetch
+    MEM_STRIDE = enum.auto()     # independent loads, bandwidth of the lines touched
+    MEM_STRIDE_LAT = enum.auto() # dependent loads, latency per access
+
+
+class MathOpsType(enum.IntEnum):
+    # VECTOR MATH, fp32 polynomial approximations over an L1 resident block
+    EXP_F32 = enum.auto()
+    LOG_F32 = enum.auto()
+    TANH_F32 = enum.auto()
+    SIGMOID_F32 = enum.auto()
+    RSQRT_F32 = enum.auto()    # estimate + Newton refinement
+    SOFTMAX_F32 = enum.auto()  # fused max, exp-sum and scale per row
+
+
+class ConvertOpsType(enum.IntEnum):
+    # PRECISION CONVERSION, streaming over --mem-size bytes of fp32
+    CVT_F32_BF16 = enum.auto()     # x86 vcvtne2ps2bf16, arm bfcvtn
+    CVT_F32_F16 = enum.auto()      # x86 vcvtps2ph, arm fcvtn
+    CVT_F32_S8 = enum.auto()       # quantize with scale and zero point, saturating
+    CVT_S8_F32 = enum.auto()       # dequantize
+
+
+class PagingOpsType(enum.IntEnum):
+    # PAGE FAULTS AND MAPPINGS, huge variants use transparent huge pages
+    VM_FAULT = enum.auto()         # first-touch faults of fresh anonymous mappings
+    VM_FAULT_HUGE = enum.auto()
+    VM_MAP = enum.auto()           # mmap, fault in, munmap
+    VM_MAP_HUGE = enum.auto()
+    VM_MADVISE = enum.auto()       # fault in, madvise(MADV_DONTNEED)
+    VM_MADVISE_HUGE = enum.auto()
+
+
+class ExitOpsType(enum.IntEnum):
+    # TRAPPING INSTRUCTIONS, VM exits or kernel emulation depending on the hypervisor
+    EXIT_CPUID = enum.auto()       # x86, leaf 0
+    EXIT_RDTSCP = enum.auto()      # x86
+    EXIT_RDMSR = enum.auto()       # x86, IA32_TSC through /dev/cpu/N/msr
+    EXIT_MRS = enum.auto()         # arm, MIDR_EL1 from EL0
+    EXIT_CNTVCT = enum.auto()      # arm
+
+    # SYSCALLS
+    SYS_GETPID = enum.auto()
+    SYS_SCHED_YIELD = enum.auto()
+    SYS_FUTEX_WAKE = enum.auto()   # no waiters
+
+    # CLOCK READS, through the vDSO when the clocksource allows it
+    CLOCK_REALTIME = enum.auto()
+    CLOCK_MONOTONIC = enum.auto()
+    CLOCK_MONOTONIC_RAW = enum.auto()
+    CLOCK_BOOTTIME = enum.auto()
+    CLOCK_MONOTONIC_COARSE = enum.auto()
+    CLOCK_SYSCALL = enum.auto()    # CLOCK_MONOTONIC, always through the syscall
+
+
+class JitOpsType(enum.IntEnum):
+    JIT = enum.auto() # loop generated at runtime from the mix given to set_jit_mix
+
+
 class Result(ctypes.Structure):
     _fields_ = [
         ('time', ctypes.c_longlong),
@@ -49,6 +127,145 @@ class CpuResult(ctypes.Structure):
     ]
 
 
+class SchedStats(ctypes.Structure):
+    _fields_ = [
+        ("run_time", ctypes.c_ulonglong),
+        ("wait_time", ctypes.c_ulonglong),
+        ("timeslices", ctypes.c_ulonglong),
+        ("voluntary_switches", ctypes.c_ulonglong),
+        ("involuntary_switches", ctypes.c_ulonglong),
+        ("steal_time", ctypes.c_ulonglong),
+    ]
+
+
+class JitterResult(ctypes.Structure):
+    _fields_ = [
+        ("time", ctypes.c_longlong),
+        ("iterations", ctypes.c_ulonglong),
+        ("gaps", ctypes.c_ulonglong),
+        ("gap_time", ctypes.c_longlong),
+        ("max_gap", ctypes.c_longlong),
+    ]
+
+
+class WarmupParams(ctypes.Structure):
+    _fields_ = [
+        ("idle", ctypes.c_int64),
+        ("duration", ctypes.c_int64),
+        ("slice", ctypes.c_int64),
+        ("bytes", ctypes.c_uint64),
+        ("lead", ctypes.c_int32),
+    ]
+
+
+class WarmupSample(ctypes.Structure):
+    _fields_ = [
+        ("time", ctypes.c_int64),
+        ("length", ctypes.c_int64),
+        ("ops", ctypes.c_uint64),
+    ]
+
+
+class WarmupResult(ctypes.Structure):
+    _fields_ = [
+        ("settle_time", ctypes.c_int64),
+        ("throttled_ops", ctypes.c_uint64),
+        ("throttled_time", ctypes.c_int64),
+        ("steady_ops", ctypes.c_uint64),
+        ("steady_time", ctypes.c_int64),
+        ("relax_time", ctypes.c_int64),
+        ("slices", ctypes.c_uint64),
+        ("relax_slices", ctypes.c_uint64),
+    ]
+
+
+class ShootdownResult(ctypes.Structure):
+    _fields_ = [
+        ("responders", ctypes.c_uint64),
+        ("unmaps", ctypes.c_uint64),
+        ("unmap_time", ctypes.c_int64),
+        ("baseline_unmaps", ctypes.c_uint64),
+        ("baseline_time", ctypes.c_int64),
+        ("stalls", ctypes.c_uint64),
+        ("stall_time", ctypes.c_int64),
+        ("baseline_stalls", ctypes.c_uint64),
+        ("baseline_stall_time", ctypes.c_int64),
+    ]
+
+
+class PingPongResult(ctypes.Structure):
+    _fields_ = [
+        ("time", ctypes.c_int64),
+        ("wakeups", ctypes.c_uint64),
+        ("wake_time", ctypes.c_int64),
+        ("min_wake", ctypes.c_int64),
+        ("max_wake", ctypes.c_int64),
+    ]
+
+
+class SkewResult(ctypes.Structure):
+    _fields_ = [
+        ("rounds", ctypes.c_uint64),
+        ("min_offset", ctypes.c_int64),
+        ("max_offset", ctypes.c_int64),
+        ("round_trip", ctypes.c_int64),
+        ("backwards", ctypes.c_uint64),
+    ]
+
+
+class DriftResult(ctypes.Structure):
+    _fields_ = [
+        ("time", ctypes.c_int64),
+        ("intervals", ctypes.c_uint64),
+        ("frequency", ctypes.c_double),
+        ("min_frequency", ctypes.c_double),
+        ("max_frequency", ctypes.c_double),
+        ("drift", ctypes.c_double),
+    ]
+
+
+class KernelParams(ctypes.Structure):
+    _fields_ = [
+        ("steps", ctypes.c_uint64),
+        ("bytes", ctypes.c_uint64),
+        ("flush", ctypes.c_int32),
+        ("pattern", ctypes.c_int32),
+        ("chains", ctypes.c_int32),
+        ("walk", ctypes.c_int32),
+        ("stride", ctypes.c_int32),
+        ("prefetch", ctypes.c_int32),
+        ("verify", ctypes.c_int32),
+    ]
+
+
+class KernelJob(ctypes.Structure):
+    _fields_ = [
+        ("name", ctypes.c_char_p),
+        ("core_id", ctypes.c_int32),
+        ("flush", ctypes.c_int32),
+        ("pattern", ctypes.c_int32),
+        ("chains", ctypes.c_int32),
+        ("walk", ctypes.c_int32),
+        ("stride", ctypes.c_int32),
+        ("prefetch", ctypes.c_int32),
+        ("steps", ctypes.c_uint64),
+        ("bytes", ctypes.c_uint64),
+        ("duration", ctypes.c_int64),
+        ("verify", ctypes.c_int32),
+        ("discard", ctypes.c_int32),
+        ("time", ctypes.c_int64),
+        ("ops", ctypes.c_uint64),
+        ("iterations", ctypes.c_uint64),
+        ("cycles", ctypes.c_uint64),
+        ("elapsed", ctypes.c_int64),
+        ("preempted", ctypes.c_uint64),
+        ("discarded", ctypes.c_uint64),
+        ("discarded_time", ctypes.c_int64),
+        ("lost_time", ctypes.c_int64),
+        ("mismatches", ctypes.c_uint64),
+    ]
+
+
 class LogicalCore(ctypes.Structure):
     _fields_ = [
         ("index", ctypes.c_uint),
@@ -58,7 +275,88 @@ class LogicalCore(ctypes.Structure):
     ]
 
 
+JITTER_BUCKETS = 40
+DEFAULT_MEM_SIZE = 256 * 1024 * 1024
+DEFAULT_SAMPLE_TIME = 10 * 1000 * 1000
+CACHE_LINE_SIZE = 64
+VERIFY_UNCHECKED = -1
+VERIFY_MISMATCH = 0
+VERIFY_MATCH = 1
+
+# Index locality of MEM_GATHER and MEM_SCATTER
+PATTERN_UNIFORM = 0
+PATTERN_ZIPF = 1
+PATTERN_CLUSTER = 2
+PATTERNS = {"uniform": PATTERN_UNIFORM, "zipf": PATTERN_ZIPF, "cluster": PATTERN_CLUSTER}
+GATHER_ELEMENT_SIZE = 4
+
+# Independent pointer chains of MEM_MLP, 0 picks the default
+DEFAULT_MLP_CHAINS = 16
+MLP_MAX_CHAINS = 32
+
+# Access order of MEM_STRIDE and MEM_STRIDE_LAT, stride 0 picks a cache line
+WALK_FORWARD = 0
+WALK_BACKWARD = 1
+WALK_PAGES = 2
+WALKS = {"forward": WALK_FORWARD, "backward": WALK_BACKWARD, "pages": WALK_PAGES}
+WALK_PAGE_SIZE = 4096
+
+# What the core does before the warm-up trace starts the kernel
+WARMUP_IDLE = 0
+WARMUP_SCALAR = 1
+WARMUP_LEADS = {"idle": WARMUP_IDLE, "scalar": WARMUP_SCALAR}
+DEFAULT_WARMUP_IDLE = 100 * 1000 * 1000
+DEFAULT_WARMUP_TIME = 50 * 1000 * 1000
+DEFAULT_WARMUP_SLICE = 10 * 1000
+
+# Both phases of the TLB shootdown probe, responder clock gaps from the threshold on are stalls
+DEFAULT_SHOOTDOWN_TIME = 500 * 1000 * 1000
+DEFAULT_SHOOTDOWN_THRESHOLD = 250
+
+# Futex ping-pong between two pinned threads
+DEFAULT_PINGPONG_TIME = 500 * 1000 * 1000
+
+# Counter skew of every pair of CPUs, then its drift against CLOCK_MONOTONIC
+DEFAULT_SKEW_TIME = 20 * 1000 * 1000
+DEFAULT_DRIFT_TIME = 2000 * 1000 * 1000
+DEFAULT_DRIFT_INTERVAL = 100 * 1000 * 1000
+
+# Clocks cpu_time may pick from, by clockid_t
+TIME_SOURCE_COUNTER = -1
+TIME_SOURCES = {
+    1: "CLOCK_MONOTONIC",
+    4: "CLOCK_MONOTONIC_RAW",
+    7: "CLOCK_BOOTTIME",
+    TIME_SOURCE_COUNTER: "counter",
+}
+
+# Element widths of the conversion kernels, by the type names in theirs
+CONVERT_WIDTHS = {"f32": 4, "bf16": 2, "f16": 2, "s8": 1}
+
+UNIT_SUFFIX = {
+    "ops": "Ops",
+    "bytes": "B",
+    "loads": "Loads",
+    "inst": "Inst",
+    "elems": "Elems",
+    "faults": "Faults",
+    "calls": "Calls",
+}
+
+# Latency (single chain), reciprocal throughput (independent chains) and port pressure pairings
+CHAIN_VARIANTS = ("", "_tput", "_load", "_fma")
+
+DEFAULT_JIT_UNROLL = 4
+DEFAULT_JIT_ACCUMULATORS = 8
+JIT_ERRORS = {
+    -1: "syntax error or unknown instruction",
+    -2: "instruction not available on this CPU",
+    -3: "out of registers or memory offsets",
+    -4: "failed to map the code buffer",
+}
+
 lib = None
+native = None
 OpsType = None
 supported_ops = None
 measure_ops = None
@@ -66,14 +364,23 @@ measure_ops = None
 
 def init():
     global lib
+    global native
     global OpsType
     global supported_ops
     global measure_ops
 
-    dynlib_file = os.path.join(os.getcwd(), "Install/lib/libVmOpsMem.so")
-    lib = ctypes.cdll.LoadLibrary(dynlib_file)
+    dynlib_dir = os.path.join(os.getcwd(), "Install/lib")
+    lib = ctypes.cdll.LoadLibrary(os.path.join(dynlib_dir, "libVmOpsMem.so"))
     lib.init()
 
+    # The extension module links the same libVmOpsMem.so, so it shares the registry set up above
+    if dynlib_dir not in sys.path:
+        sys.path.insert(0, dynlib_dir)
+    try:
+        native = importlib.import_module("_vm_ops_mem")
+    except ImportError:
+        native = None
+
     if lib.debug_build():
         print("---------------------------------------------")
         print("| WARNING: Debug build of VmOpsMem is used! |")
@@ -181,12 +488,416 @@ def measure_x86_ops(op, steps):
         raise RuntimeError(f"Measure function for op `{op}` not found!")
     return result.time, result.ops
 
+def supported_mem_ops():
+    ops = list()
+    if lib.mem_load_support():
+        ops.append(MemOpsType.MEM_LOAD)
+    if lib.mem_store_support():
+        ops.append(MemOpsType.MEM_STORE)
+    if lib.mem_store_nt_support():
+        ops.append(MemOpsType.MEM_STORE_NT)
+    if lib.mem_rmw_support():
+        ops.append(MemOpsType.MEM_RMW)
+    if lib.mem_triad_support():
+        ops.append(MemOpsType.MEM_TRIAD)
+    if lib.mem_chase_support():
+        ops.append(MemOpsType.MEM_CHASE)
+    if lib.mem_mlp_support():
+        ops.append(MemOpsType.MEM_MLP)
+    if lib.mem_gather_support():
+        ops.append(MemOpsType.MEM_GATHER)
+    if lib.mem_scatter_support():
+        ops.append(MemOpsType.MEM_SCATTER)
+    if lib.mem_stride_support():
+        ops.append(MemOpsType.MEM_STRIDE)
+        ops.append(MemOpsType.MEM_STRIDE_LAT)
+    return ops
+
+
+def supported_math_ops():
+    return [op for op in MathOpsType if kernel_support(op.name.lower())]
+
+
+def supported_convert_ops():
+    return [op for op in ConvertOpsType if kernel_support(op.name.lower())]
+
+
+def supported_paging_ops():
+    return [op for op in PagingOpsType if kernel_support(op.name.lower())]
+
+
+def supported_exit_ops():
+    return [op for op in ExitOpsType if kernel_support(op.name.lower())]
+
+
+def measure_mem_ops(
+    op,
+    size,
+    steps,
+    flush,
+    pattern=PATTERN_UNIFORM,
+    chains=0,
+    walk=WALK_FORWARD,
+    stride=0,
+    prefetch=0,
+):
+    args = [ctypes.c_uint64(size), ctypes.c_uint64(steps), ctypes.c_int32(flush)]
+    result = None
+    if op == MemOpsType.MEM_LOAD:
+        lib.mem_load.restype = Result
+        result = lib.mem_load(*args)
+    elif op == MemOpsType.MEM_STORE:
+        lib.mem_store.restype = Result
+        result = lib.mem_store(*args)
+    elif op == MemOpsType.MEM_STORE_NT:
+        lib.mem_store_nt.restype = Result
+        result = lib.mem_store_nt(*args)
+    elif op == MemOpsType.MEM_RMW:
+        lib.mem_rmw.restype = Result
+        result = lib.mem_rmw(*args)
+    elif op == MemOpsType.MEM_TRIAD:
+        lib.mem_triad.restype = Result
+        result = lib.mem_triad(*args)
+    elif op == MemOpsType.MEM_CHASE:
+        lib.mem_chase.restype = Result
+        result = lib.mem_chase(ctypes.c_uint64(size), ctypes.c_uint64(chase_steps(size, steps)))
+    elif op == MemOpsType.MEM_MLP:
+        lib.mem_mlp.restype = Result
+        result = lib.mem_mlp(
+            ctypes.c_uint64(size), ctypes.c_uint64(chase_steps(size, steps)), ctypes.c_int32(chains)
+        )
+    elif op == MemOpsType.MEM_GATHER:
+        lib.mem_gather.restype = Result
+        result = lib.mem_gather(*args, ctypes.c_int32(pattern))
+    elif op == MemOpsType.MEM_SCATTER:
+        lib.mem_scatter.restype = Result
+        result = lib.mem_scatter(*args, ctypes.c_int32(pattern))
+    elif op in (MemOpsType.MEM_STRIDE, MemOpsType.MEM_STRIDE_LAT):
+        function = getattr(lib, op.name.lower())
+        function.restype = Result
+        result = function(
+            *args, ctypes.c_int32(walk), ctypes.c_int32(stride), ctypes.c_int32(prefetch)
+        )
+    else:
+        raise RuntimeError(f"Measure function for op `{op}` not found!")
+    return result.time, result.ops
+
+
+def chase_steps(size, passes):
+    return passes * max(size // CACHE_LINE_SIZE, 2)
+
+
+def measure_any_ops(
+    op,
+    steps,
+    mem_size=DEFAULT_MEM_SIZE,
+    mem_flush=False,
+    mem_pattern=PATTERN_UNIFORM,
+    mem_chains=0,
+    mem_walk=WALK_FORWARD,
+    mem_stride=0,
+    mem_prefetch=0,
+):
+    if native is not None:
+        # IntEnum members of different op types compare equal by value, match the type as well
+        if isinstance(op, MemOpsType) and op.name in ("MEM_CHASE", "MEM_MLP"):
+            steps = chase_steps(mem_size, steps)
+        result = native.run_kernel(
+            op.name.lower(),
+            steps,
+            mem_size,
+            mem_flush,
+            mem_pattern,
+            mem_chains,
+            mem_walk,
+            mem_stride,
+            mem_prefetch,
+        )
+        return result.time, result.ops
+    if isinstance(op, MemOpsType):
+        return measure_mem_ops(
+            op,
+            mem_size,
+            steps,
+            mem_flush,
+            mem_pattern,
+            mem_chains,
+            mem_walk,
+            mem_stride,
+            mem_prefetch,
+        )
+    if isinstance(op, (JitOpsType, MathOpsType, ConvertOpsType, PagingOpsType, ExitOpsType)):
+        result = run_kernel(op.name.lower(), steps, mem_size, mem_flush, mem_pattern)
+        return result.time, result.ops
+    return measure_ops(op, steps)
+
+
+def kernel_names():
+    lib.kernel_name.restype = ctypes.c_char_p
+    return [lib.kernel_name(index).decode() for index in range(lib.kernel_count())]
+
+
+def kernel_support(name):
+    lib.kernel_support.argtypes = [ctypes.c_char_p]
+    return bool(lib.kernel_support(name.encode()))
+
+
+def kernel_unit(name):
+    lib.kernel_unit.restype = ctypes.c_char_p
+    lib.kernel_unit.argtypes = [ctypes.c_char_p]
+    unit = lib.kernel_unit(name.encode())
+    return UNIT_SUFFIX[unit.decode()] if unit else "Ops"
+
+
+def kernel_ops_per_inst(name):
+    lib.kernel_ops_per_inst.restype = ctypes.c_uint64
+    lib.kernel_ops_per_inst.argtypes = [ctypes.c_char_p]
+    return lib.kernel_ops_per_inst(name.encode())
+
+
+def kernel_ops_per_elem(name):
+    lib.kernel_ops_per_elem.restype = ctypes.c_uint64
+    lib.kernel_ops_per_elem.argtypes = [ctypes.c_char_p]
+    return lib.kernel_ops_per_elem(name.encode())
+
+
+def kernel_inst_time(name):
+    if native is not None:
+        return native.kernel_inst_time(name)
+    lib.kernel_inst_time.restype = ctypes.c_double
+    lib.kernel_inst_time.argtypes = [ctypes.c_char_p]
+    return lib.kernel_inst_time(name.encode())
+
+
+def run_kernel(
+    name,
+    steps,
+    size=0,
+    flush=False,
+    pattern=PATTERN_UNIFORM,
+    chains=0,
+    walk=WALK_FORWARD,
+    stride=0,
+    prefetch=0,
+):
+    if native is not None:
+        return native.run_kernel(name, steps, size, flush, pattern, chains, walk, stride, prefetch)
+    params = KernelParams(steps, size, int(flush), pattern, chains, walk, stride, prefetch)
+    lib.run_kernel.restype = Result
+    lib.run_kernel.argtypes = [ctypes.c_char_p, ctypes.POINTER(KernelParams)]
+    return lib.run_kernel(name.encode(), ctypes.byref(params))
+
+
+def set_input_seed(seed):
+    if native is not None:
+        return native.set_input_seed(seed)
+    lib.set_input_seed.argtypes = [ctypes.c_uint64]
+    lib.set_input_seed(seed)
+
+
+def verify_kernel(name, steps=0):
+    if native is not None:
+        return native.verify_kernel(name, steps)
+    lib.verify_kernel.argtypes = [ctypes.c_char_p, ctypes.c_uint64]
+    return lib.verify_kernel(name.encode(), steps)
+
+
+def verify_result(name, steps, result):
+    if native is not None:
+        return native.verify_result(name, steps, result)
+    lib.verify_result.argtypes = [ctypes.c_char_p, ctypes.c_uint64, ctypes.POINTER(Result)]
+    return lib.verify_result(name.encode(), steps, ctypes.byref(result))
+
+
+def run_kernels(jobs):
+    if native is not None:
+        results = native.run_kernels(
+            [
+                (
+                    job.name.decode(),
+                    job.core_id,
+                    job.steps,
+                    job.bytes,
+                    job.flush,
+                    job.duration,
+                    job.pattern,
+                    job.chains,
+                    job.walk,
+                    job.stride,
+                    job.prefetch,
+                    job.verify,
+                    job.discard,
+                )
+                for job in jobs
+            ]
+        )
+        for job, (time, ops, iterations, steps, *stats) in zip(jobs, results):
+            job.time, job.ops, job.iterations, job.steps = time, ops, iterations, steps
+            (
+                job.cycles,
+                job.elapsed,
+                job.preempted,
+                job.discarded,
+                job.discarded_time,
+                job.lost_time,
+                job.mismatches,
+            ) = stats
+        return jobs
+    array = (KernelJob * len(jobs))(*jobs)
+    lib.run_kernels.argtypes = [ctypes.POINTER(KernelJob), ctypes.c_uint]
+    if lib.run_kernels(array, len(jobs)) != 0:
+        raise RuntimeError("Failed to run kernels!")
+    return list(array)
+
+
+def set_sample_time(time):
+    if native is not None:
+        return native.set_sample_time(time)
+    lib.set_sample_time.argtypes = [ctypes.c_int64]
+    lib.set_sample_time(time)
+
+
+def calibrate_steps(
+    name,
+    size=0,
+    flush=False,
+    pattern=PATTERN_UNIFORM,
+    chains=0,
+    walk=WALK_FORWARD,
+    stride=0,
+    prefetch=0,
+):
+    if native is not None:
+        return native.calibrate_steps(name, size, flush, pattern, chains, walk, stride, prefetch)
+    params = KernelParams(0, size, int(flush), pattern, chains, walk, stride, prefetch)
+    lib.calibrate_steps.restype = ctypes.c_uint64
+    lib.calibrate_steps.argtypes = [ctypes.c_char_p, ctypes.POINTER(KernelParams)]
+    steps = lib.calibrate_steps(name.encode(), ctypes.byref(params))
+    if steps == 0:
+        raise RuntimeError(f"Kernel `{name}` not supported!")
+    return steps
+
+
+def jit_instructions():
+    if native is not None:
+        names = native.jit_instructions()
+    else:
+        lib.jit_instructions.restype = ctypes.c_char_p
+        names = lib.jit_instructions().decode()
+    return names.split(",") if names else []
+
+
+def set_jit_mix(mix, unroll=DEFAULT_JIT_UNROLL, accumulators=DEFAULT_JIT_ACCUMULATORS):
+    if native is not None:
+        status = native.set_jit_mix(mix, unroll, accumulators)
+    else:
+        lib.set_jit_mix.argtypes = [ctypes.c_char_p, ctypes.c_uint32, ctypes.c_uint32]
+        status = lib.set_jit_mix(mix.encode(), unroll, accumulators)
+    if status != 0:
+        raise RuntimeError(f"JIT mix `{mix}`: {JIT_ERRORS.get(status, status)}!")
+
+
 def cpu_time():
+    if native is not None:
+        return native.cpu_time()
     lib.cpu_time.restype = CpuResult
     result = lib.cpu_time()
     return result.time, result.cycles
 
 
+def sched_stats():
+    lib.sched_stats.restype = SchedStats
+    return lib.sched_stats()
+
+
+def jitter_scan(time, threshold, buckets=JITTER_BUCKETS):
+    histogram = (ctypes.c_ulonglong * buckets)()
+    lib.jitter_scan.restype = JitterResult
+    lib.jitter_scan.argtypes = [
+        ctypes.c_longlong,
+        ctypes.c_longlong,
+        ctypes.POINTER(ctypes.c_ulonglong),
+        ctypes.c_uint,
+    ]
+    result = lib.jitter_scan(int(time * 1e9), threshold, histogram, buckets)
+    return result, list(histogram)
+
+
+def warmup_trace(
+    name,
+    lead=WARMUP_IDLE,
+    time=DEFAULT_WARMUP_TIME,
+    slice_time=DEFAULT_WARMUP_SLICE,
+    idle=DEFAULT_WARMUP_IDLE,
+    size=0,
+):
+    # Room for the kernel and the relaxation traces, with slices shorter than calibrated
+    count = 4 * (time // slice_time + 1)
+    samples = (WarmupSample * count)()
+    lib.warmup_trace.restype = WarmupResult
+    lib.warmup_trace.argtypes = [
+        ctypes.c_char_p,
+        ctypes.POINTER(WarmupParams),
+        ctypes.POINTER(WarmupSample),
+        ctypes.c_uint,
+    ]
+    params = WarmupParams(idle, time, slice_time, size, lead)
+    result = lib.warmup_trace(name.encode(), ctypes.byref(params), samples, count)
+    return result, list(samples[: min(count, result.slices + result.relax_slices)])
+
+
+def tlb_shootdown(initiator, responders, time, threshold):
+    lib.tlb_shootdown.restype = ShootdownResult
+    lib.tlb_shootdown.argtypes = [
+        ctypes.c_int32,
+        ctypes.POINTER(ctypes.c_int32),
+        ctypes.c_uint,
+        ctypes.c_int64,
+        ctypes.c_int64,
+    ]
+    cores = (ctypes.c_int32 * len(responders))(*responders)
+    return lib.tlb_shootdown(initiator, cores, len(responders), time, threshold)
+
+
+def futex_pingpong(first, second, time, buckets=JITTER_BUCKETS):
+    histogram = (ctypes.c_uint64 * buckets)()
+    lib.futex_pingpong.restype = PingPongResult
+    lib.futex_pingpong.argtypes = [
+        ctypes.c_int32,
+        ctypes.c_int32,
+        ctypes.c_int64,
+        ctypes.POINTER(ctypes.c_uint64),
+        ctypes.c_uint,
+    ]
+    result = lib.futex_pingpong(first, second, time, histogram, buckets)
+    return result, list(histogram)
+
+
+def clock_source():
+    lib.clock_source.restype = ctypes.c_char_p
+    return lib.clock_source().decode()
+
+
+def time_source():
+    return TIME_SOURCES.get(lib.time_source_clock(), "unknown")
+
+
+def clock_counter_based():
+    return bool(lib.clock_counter_based())
+
+
+def counter_skew(first, second, time):
+    lib.counter_skew.restype = SkewResult
+    lib.counter_skew.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int64]
+    return lib.counter_skew(first, second, time)
+
+
+def counter_drift(time, interval):
+    lib.counter_drift.restype = DriftResult
+    lib.counter_drift.argtypes = [ctypes.c_int64, ctypes.c_int64]
+    return lib.counter_drift(time, interval)
+
+
 def set_thread_affinity(core_id):
     lib.set_thread_affinity.argtypes = [ctypes.c_int32]
     lib.set_thread_affinity(core_id)
@@ -197,7 +908,8 @@ def set_thread_priority():
 
 
 def logical_cores():
-    num_cores = os.cpu_count()
+    # Only the CPUs of this process's cpuset that answered the probe
+    num_cores = lib.logical_core_count()
     result = (LogicalCore * num_cores)()
     lib.logical_cores.argtypes = [ctypes.POINTER(LogicalCore), ctypes.c_int]
     lib.logical_cores(result, ctypes.c_int(num_cores))
@@ -233,14 +945,35 @@ def sizeof_fmt(num, suffix="Ops", steps=1024.0):
     return num, f"Y{suffix}"
 
 
+def time_fmt(ns):
+    for unit in ("ns", "us", "ms"):
+        if abs(ns) < 1000.0:
+            return ns, unit
+        ns /= 1000.0
+    return ns, "s"
+
+
 class PerfReport:
-    def __init__(self, name, ratio=1):
+    def __init__(self, name, ratio=1, unit="Ops"):
         self.name = name
         self.ratio = ratio
+        self.unit = unit
+        self.packages = dict()
         self.elapsed_time = 0
         self.total_ops = 0
         self.total_freq = 0
         self.steps = 0
+        self.preempted = 0
+        self.discarded = 0
+        self.discarded_time = 0
+        self.lost_time = 0
+        # Chains of MEM_MLP and the per-core loads/sec of a single one, its latency reference
+        self.chains = 0
+        self.chain_rate = 0
+        # Walk, stride in bytes and prefetch distance in accesses of MEM_STRIDE and MEM_STRIDE_LAT
+        self.walk = WALK_FORWARD
+        self.stride = 0
+        self.prefetch = 0
 
     def update(self, elapsed_time, total_ops, total_freq, steps):
         self.elapsed_time += elapsed_time
@@ -248,28 +981,353 @@ class PerfReport:
         self.total_freq += total_freq
         self.steps += steps
 
+    def update_preemption(self, preempted, discarded, discarded_time, lost_time):
+        self.preempted += preempted
+        self.discarded += discarded
+        self.discarded_time += discarded_time
+        self.lost_time += lost_time
+
     def __str__(self):
+        if self.steps == 0 or self.elapsed_time == 0:
+            # Every sample was discarded, nothing to derive a rate from
+            str = ""
+            str += f"Name: {self.name}\n"
+            str += f"Time: 0.00 sec (no samples kept)\n"
+            str += f"Preempted: {self.preempted} samples ({self.discarded} discarded)\n"
+            str += f"LostTime: {self.lost_time / self.ratio * 1e3:.2f} ms\n"
+            return str
         peak_ops = self.total_ops / (self.elapsed_time / self.ratio)
         ai = self.total_ops / ((self.elapsed_time / self.ratio) * 1e9)
         cpu_freq = self.total_freq / self.steps
-        ops_fmt, ops_unit = sizeof_fmt(self.total_ops)
-        peak_fmt, peak_unit = sizeof_fmt(peak_ops)
+        ops_fmt, ops_unit = sizeof_fmt(self.total_ops, self.unit)
+        peak_fmt, peak_unit = sizeof_fmt(peak_ops, self.unit)
+        core_fmt, core_unit = sizeof_fmt(peak_ops / self.ratio, self.unit)
         cpu_fmt, cpu_unit = sizeof_fmt(cpu_freq, "Hz")
         str = ""
         str += f"Name: {self.name}\n"
         str += f"Time: {self.elapsed_time / self.ratio:.2f} sec\n"
-        str += f"Ops: {ops_fmt:.2f} {ops_unit}\n"
+        str += f"{self.unit}: {ops_fmt:.2f} {ops_unit}\n"
         str += f"Peak: {peak_fmt:.2f} {peak_unit}/sec\n"
-        str += f"AI: {ai:.2f} ops/cycle\n"
+        str += f"PerCore: {core_fmt:.2f} {core_unit}/sec\n"
+        if self.name.lower() in ("mem_gather", "mem_scatter"):
+            lookups_fmt, lookups_unit = sizeof_fmt(peak_ops / GATHER_ELEMENT_SIZE, "")
+            core_lookups_fmt, core_lookups_unit = sizeof_fmt(
+                peak_ops / GATHER_ELEMENT_SIZE / self.ratio, ""
+            )
+            str += f"Lookups: {lookups_fmt:.2f} {lookups_unit}/sec\n"
+            str += f"PerCoreLookups: {core_lookups_fmt:.2f} {core_lookups_unit}/sec\n"
+        if self.name.lower() == "mem_mlp":
+            bandwidth_fmt, bandwidth_unit = sizeof_fmt(peak_ops * CACHE_LINE_SIZE, "B")
+            str += f"Bandwidth: {bandwidth_fmt:.2f} {bandwidth_unit}/sec\n"
+            if self.chains:
+                str += f"Chains: {self.chains}\n"
+            if self.chain_rate:
+                # Little's law, loads/sec times the latency of one chain
+                str += f"InFlight: {peak_ops / self.ratio / self.chain_rate:.2f} misses\n"
+        if self.name.lower() in ("mem_stride", "mem_stride_lat"):
+            if self.name.lower() == "mem_stride_lat":
+                str += f"Latency: {1e9 * self.ratio / peak_ops:.2f} ns\n"
+            walk = next(name for name, value in WALKS.items() if value == self.walk)
+            str += f"Walk: {walk}\n"
+            str += f"Stride: {self.stride or CACHE_LINE_SIZE} B\n"
+            str += f"Prefetch: {self.prefetch} accesses\n"
+        ops_per_elem = kernel_ops_per_elem(self.name.lower()) if self.unit == "Elems" else 0
+        if ops_per_elem:
+            elem_fmt, elem_unit = sizeof_fmt(peak_ops * ops_per_elem, "Ops")
+            core_elem_fmt, core_elem_unit = sizeof_fmt(peak_ops * ops_per_elem / self.ratio, "Ops")
+            str += f"PeakOps: {elem_fmt:.2f} {elem_unit}/sec\n"
+            str += f"PerCoreOps: {core_elem_fmt:.2f} {core_elem_unit}/sec\n"
+        if self.name.lower().startswith("cvt_"):
+            # Read from the source buffer and written to the target one
+            width = sum(CONVERT_WIDTHS[kind] for kind in self.name.lower().split("_")[1:])
+            bandwidth_fmt, bandwidth_unit = sizeof_fmt(peak_ops * width, "B")
+            str += f"Bandwidth: {bandwidth_fmt:.2f} {bandwidth_unit}/sec\n"
+        if self.name.lower().startswith(("exit_", "sys_", "clock_")):
+            # Cycles of the CPU counter, as in the instruction table
+            str += f"Cost: {cpu_freq / (peak_ops / self.ratio):.1f} cycles\n"
+        for package_id, package in sorted(self.packages.items()):
+            if package.elapsed_time == 0:
+                str += f"Socket#{package_id}: no samples kept\n"
+                continue
+            package_ops = package.total_ops / (package.elapsed_time / package.ratio)
+            package_fmt, package_unit = sizeof_fmt(package_ops, self.unit)
+            str += f"Socket#{package_id}: {package_fmt:.2f} {package_unit}/sec\n"
+        str += f"AI: {ai:.2f} {'bytes' if self.unit == 'B' else self.unit.lower()}/cycle\n"
         str += f"CpuFreq: {cpu_fmt:.2f} {cpu_unit}\n"
         str += f"Bench: {self.steps / self.ratio} iters/report\n"
+        str += f"Preempted: {self.preempted} samples ({self.discarded} discarded)\n"
+        str += f"LostTime: {self.lost_time / self.ratio * 1e3:.2f} ms\n"
+        return str
+
+
+class JitterReport:
+    def __init__(self, threshold, buckets=JITTER_BUCKETS):
+        self.threshold = threshold
+        self.time = 0
+        self.iterations = 0
+        self.gaps = 0
+        self.gap_time = 0
+        self.max_gap = 0
+        self.histogram = [0] * buckets
+
+    def update(self, result, histogram):
+        self.time += result.time
+        self.iterations += result.iterations
+        self.gaps += result.gaps
+        self.gap_time += result.gap_time
+        self.max_gap = max(self.max_gap, result.max_gap)
+        self.histogram = [a + b for a, b in zip(self.histogram, histogram)]
+
+    def __str__(self):
+        str = ""
+        str += f"Name: VM jitter (gaps >= {self.threshold} ns)\n"
+        str += f"Time: {self.time / 1e9:.2f} sec\n"
+        str += f"Gaps: {self.gaps} of {self.iterations} iters\n"
+        str += f"GapTime: {self.gap_time / 1e6:.2f} ms ({self.gap_time / max(self.time, 1) * 100:.3f}%)\n"
+        str += f"MaxGap: {self.max_gap / 1e3:.2f} us\n"
+        peak = max(self.histogram)
+        for bucket, count in enumerate(self.histogram):
+            if count == 0:
+                continue
+            low, low_unit = time_fmt(2**bucket)
+            bar = "#" * max(1, int(40 * count / peak))
+            str += f"  >= {low:6.1f} {low_unit}: {count:8d} {bar}\n"
+        return str
+
+
+class TableReport:
+    def __init__(self, freq):
+        self.freq = freq
+        self.rows = list()
+
+    def update(self, name, ops_per_inst, times):
+        self.rows.append((name, ops_per_inst, times))
+
+    def __str__(self):
+        freq_fmt, freq_unit = sizeof_fmt(self.freq * 1e9, "Hz")
+        str = ""
+        str += f"Name: Instruction table (cycles of the {freq_fmt:.2f} {freq_unit} CPU counter)\n"
+        str += f"{'Instruction':<24}{'Ops/Inst':>10}{'Latency':>10}{'RecipTput':>10}"
+        str += f"{'+Load':>10}{'+FMA':>10}\n"
+        for name, ops_per_inst, times in self.rows:
+            str += f"{name:<24}{ops_per_inst:>10}"
+            for time in times:
+                str += f"{time * self.freq:>10.2f}" if time else f"{'-':>10}"
+            str += "\n"
+        return str
+
+
+class WarmupReport:
+    def __init__(self, lead):
+        self.lead = lead
+        self.rows = list()
+
+    def update(self, name, unit, result):
+        self.rows.append((name, unit, result))
+
+    def __str__(self):
+        str = ""
+        str += f"Name: Warm-up after {self.lead} lead-in\n"
+        str += f"{'Kernel':<16}{'Settle':>12}{'Throttled':>18}{'Steady':>18}{'Ratio':>8}"
+        str += f"{'Relax':>12}\n"
+        for name, unit, result in self.rows:
+            steady_rate = result.steady_ops / max(result.steady_time, 1) * 1e9
+            throttled_rate = result.throttled_ops / max(result.throttled_time, 1) * 1e9
+            steady_fmt, steady_unit = sizeof_fmt(steady_rate, unit)
+            settle_fmt, settle_unit = time_fmt(result.settle_time)
+            relax_fmt, relax_unit = time_fmt(result.relax_time)
+            str += f"{name:<16}{settle_fmt:>9.2f} {settle_unit:<2}"
+            if result.throttled_time:
+                throttled_fmt, throttled_unit = sizeof_fmt(throttled_rate, unit)
+                str += f"{throttled_fmt:>8.2f} {throttled_unit + '/s':<9}"
+            else:
+                str += f"{'-':>18}"
+            str += f"{steady_fmt:>8.2f} {steady_unit + '/s':<9}"
+            str += f"{throttled_rate / steady_rate:>8.2f}" if result.throttled_time else f"{'-':>8}"
+            str += f"{relax_fmt:>9.2f} {relax_unit:<2}\n"
+        return str
+
+
+class ShootdownReport:
+    def __init__(self, threshold):
+        self.threshold = threshold
+        self.rows = list()
+
+    def update(self, sockets, result):
+        self.rows.append((sockets, result))
+
+    def __str__(self):
+        str = ""
+        str += f"Name: TLB shootdown (responder stalls >= {self.threshold} ns)\n"
+        str += f"{'Responders':>10}{'Sockets':>9}{'Unmap':>12}{'+Flush':>12}{'Stall':>12}"
+        str += f"{'Seen':>8}\n"
+        for sockets, result in self.rows:
+            unmap = result.unmap_time / max(result.unmaps, 1)
+            baseline = result.baseline_time / max(result.baseline_unmaps, 1)
+            # The baseline phase ran as long, what it stalled for was not the flushes
+            flushes = max(result.unmaps * result.responders, 1)
+            stall = (result.stall_time - result.baseline_stall_time) / flushes
+            seen = (result.stalls - result.baseline_stalls) / flushes
+            str += f"{result.responders:>10}{sockets:>9}{unmap / 1e3:>9.2f} us"
+            str += f"{(unmap - baseline) / 1e3:>9.2f} us{max(stall, 0) / 1e3:>9.2f} us"
+            str += f"{max(seen, 0) * 100:>7.1f}%\n"
+        return str
+
+
+class PingPongReport:
+    def __init__(self):
+        self.rows = list()
+
+    def update(self, pair, first, second, result, histogram):
+        self.rows.append((pair, first, second, result, histogram))
+
+    def __str__(self):
+        str = ""
+        str += f"Name: Futex wake-up latency (one way)\n"
+        for pair, first, second, result, histogram in self.rows:
+            mean = result.wake_time / max(result.wakeups, 1)
+            str += f"{pair} (Thread#{first} -> Thread#{second}): {result.wakeups} wakeups, "
+            str += f"min {result.min_wake / 1e3:.2f} us, mean {mean / 1e3:.2f} us, "
+            str += f"max {result.max_wake / 1e3:.2f} us\n"
+            peak = max(histogram)
+            for bucket, count in enumerate(histogram):
+                if count == 0:
+                    continue
+                low, low_unit = time_fmt(2**bucket)
+                bar = "#" * max(1, int(40 * count / peak))
+                str += f"  >= {low:6.1f} {low_unit}: {count:8d} {bar}\n"
+        return str
+
+
+class ClockReport:
+    def __init__(self, source, time_source, counter_based=False):
+        self.source = source
+        self.time_source = time_source
+        self.counter_based = counter_based
+        self.reads = list()
+        self.skews = list()
+        self.drift = None
+
+    def update_read(self, name, cost):
+        self.reads.append((name, cost))
+
+    def update_skew(self, first, second, result):
+        self.skews.append((first, second, result))
+
+    def __str__(self):
+        str = ""
+        str += f"Name: Clock sources\n"
+        str += f"Clocksource: {self.source or 'unknown'}\n"
+        str += f"TimeSource: {self.time_source}\n"
+        # Reads as slow as the forced syscall never made it to the vDSO
+        syscall = dict(self.reads).get("CLOCK_SYSCALL", 0)
+        for name, cost in self.reads:
+            path = "syscall" if name == "CLOCK_SYSCALL" or cost > syscall / 2 else "vdso"
+            str += f"  {name:<24}{cost:>8.1f} ns  {path}\n"
+
+        # Consistent when zero lies within the offset bounds and no read went backwards
+        skewed = 0
+        for first, second, result in self.skews:
+            consistent = result.min_offset <= 0 <= result.max_offset and result.backwards == 0
+            skewed += not consistent
+            str += f"  Thread#{first} -> Thread#{second}: offset {result.min_offset} .. "
+            str += f"{result.max_offset} ticks, round trip {result.round_trip} ticks, "
+            str += f"{result.backwards} backwards{'' if consistent else ' SKEWED'}\n"
+        if self.skews:
+            str += f"Counter: {len(self.skews) - skewed} of {len(self.skews)} pairs consistent\n"
+
+        if self.drift is not None:
+            freq_fmt, freq_unit = sizeof_fmt(self.drift.frequency, "Hz", 1000.0)
+            spread = (self.drift.max_frequency - self.drift.min_frequency) / self.drift.frequency
+            str += f"CounterFreq: {freq_fmt:.6f} {freq_unit} over {self.drift.intervals} intervals"
+            str += f" (spread {spread * 1e6:.2f} ppm)\n"
+            str += f"Drift: {self.drift.drift:.3f} ppm/sec\n"
+        if self.counter_based:
+            str += f"Note: CLOCK_MONOTONIC reads the counter (clocksource {self.source}), "
+            str += f"the drift is not against an independent clock\n"
+        return str
+
+
+class MixGroup:
+    def __init__(
+        self,
+        name,
+        cores,
+        steps,
+        mem_size=DEFAULT_MEM_SIZE,
+        mem_flush=False,
+        mem_pattern=PATTERN_UNIFORM,
+        mem_chains=0,
+        mem_walk=WALK_FORWARD,
+        mem_stride=0,
+        mem_prefetch=0,
+    ):
+        self.name = name
+        self.cores = cores
+        self.steps = steps
+        if name in ("mem_chase", "mem_mlp"):
+            self.steps = chase_steps(mem_size, steps)
+        self.mem_size = mem_size
+        self.mem_flush = mem_flush
+        self.mem_pattern = mem_pattern
+        self.mem_chains = mem_chains
+        self.mem_walk = mem_walk
+        self.mem_stride = mem_stride
+        self.mem_prefetch = mem_prefetch
+
+    def jobs(self, time):
+        return [
+            KernelJob(
+                self.name.encode(),
+                core_info.index,
+                int(self.mem_flush),
+                self.mem_pattern,
+                self.mem_chains,
+                self.mem_walk,
+                self.mem_stride,
+                self.mem_prefetch,
+                self.steps,
+                self.mem_size,
+                int(time * 1e9),
+            )
+            for core_info in self.cores
+        ]
+
+    def report(self, jobs):
+        report = PerfReport(self.name, len(jobs), kernel_unit(self.name))
+        for job in jobs:
+            report.update(job.time / 1e9, job.ops, 0, job.iterations)
+        return report
+
+
+class MixReport:
+    def __init__(self):
+        self.groups = list()
+
+    def update(self, group, isolated, mixed):
+        self.groups.append((group, isolated, mixed))
+
+    def __str__(self):
+        str = ""
+        str += f"Name: Co-scheduled mix\n"
+        for group, isolated, mixed in self.groups:
+            isolated_rate = isolated.total_ops / (isolated.elapsed_time / isolated.ratio)
+            mixed_rate = mixed.total_ops / (mixed.elapsed_time / mixed.ratio)
+            isolated_fmt, isolated_unit = sizeof_fmt(isolated_rate, isolated.unit)
+            mixed_fmt, mixed_unit = sizeof_fmt(mixed_rate, mixed.unit)
+            str += f"{group.name} x{len(group.cores)}: "
+            str += f"isolated {isolated_fmt:.2f} {isolated_unit}/sec, "
+            str += f"mixed {mixed_fmt:.2f} {mixed_unit}/sec "
+            str += f"({mixed_rate / isolated_rate * 100:.1f}%)\n"
         return str
 
 
 class PerfMonitor:
-    def __init__(self, num_cores=None):
+    def __init__(self, num_cores=None, discard_preempted=False, verify=False):
         self.physical_cores = [core for core in logical_cores() if core.thread_id == 0]
         self.num_cores = len(self.physical_cores)
+        self.discard_preempted = discard_preempted
+        self.verify = verify
 
         if num_cores is not None:
             assert num_cores <= self.num_cores
@@ -278,44 +1336,256 @@ class PerfMonitor:
 
         self.executor = concurrent.futures.ThreadPoolExecutor(max_workers=num_cores)
 
-    def measure(self, op, steps, time):
+    def measure(self, op, steps, time, **params):
+        name = op.name.lower()
+        mem_size = params.get("mem_size", 0)
+        if name in ("mem_chase", "mem_mlp"):
+            steps = chase_steps(mem_size, steps)
+
+        # Zero steps lets every core calibrate one sample, all of them stop at the same deadline
+        jobs = run_kernels(
+            [
+                KernelJob(
+                    name.encode(),
+                    core_info.index,
+                    int(params.get("mem_flush", False)),
+                    params.get("mem_pattern", PATTERN_UNIFORM),
+                    params.get("mem_chains", 0),
+                    params.get("mem_walk", WALK_FORWARD),
+                    params.get("mem_stride", 0),
+                    params.get("mem_prefetch", 0),
+                    steps,
+                    mem_size,
+                    int(time * 1e9),
+                    int(self.verify),
+                    int(self.discard_preempted),
+                )
+                for core_info in self.physical_cores
+            ]
+        )
+
+        unit = kernel_unit(name)
+        package_cores = collections.Counter(core.package_id for core in self.physical_cores)
+
+        report = PerfReport(op.name, self.num_cores, unit)
+        for core_info, job in zip(self.physical_cores, jobs):
+            if job.mismatches:
+                raise RuntimeError(f"{op.name} output mismatch on Thread#{core_info.index}!")
+
+            package_id = core_info.package_id
+            if package_id not in report.packages:
+                report.packages[package_id] = PerfReport(op.name, package_cores[package_id], unit)
+
+            # Cycles over the elapsed time of the kept samples, weighted like one per sample
+            freq = job.cycles / (job.elapsed / 1e9) if job.elapsed else 0
+            for target in (report, report.packages[package_id]):
+                target.update(job.time / 1e9, job.ops, freq * job.iterations, job.iterations)
+                target.update_preemption(
+                    job.preempted, job.discarded, job.discarded_time / 1e9, job.lost_time / 1e9
+                )
+
+        return report
+
+    def mix_groups(
+        self,
+        specs,
+        steps,
+        mem_passes,
+        mem_size=DEFAULT_MEM_SIZE,
+        mem_flush=False,
+        mem_pattern=PATTERN_UNIFORM,
+        mem_chains=0,
+        mem_walk=WALK_FORWARD,
+        mem_stride=0,
+        mem_prefetch=0,
+    ):
+        groups = list()
+        next_core = 0
+        for spec in specs:
+            name, _, count = spec.lower().partition(":")
+            if not kernel_support(name):
+                raise RuntimeError(f"Kernel `{name}` not supported!")
+
+            if count.endswith("%"):
+                count = int(self.num_cores * int(count[:-1]) / 100)
+            else:
+                count = int(count or 1)
+
+            cores = self.physical_cores[next_core : next_core + count]
+            if count == 0 or len(cores) < count:
+                raise RuntimeError(f"Not enough cores for `{spec}`!")
+            next_core += count
+
+            if name.startswith(("mem_", "cvt_")):
+                groups.append(
+                    MixGroup(
+                        name,
+                        cores,
+                        mem_passes,
+                        mem_size,
+                        mem_flush,
+                        mem_pattern,
+                        mem_chains,
+                        mem_walk,
+                        mem_stride,
+                        mem_prefetch,
+                    )
+                )
+            else:
+                groups.append(MixGroup(name, cores, steps))
+        return groups
+
+    def measure_mix(self, groups, time):
+        report = MixReport()
+
+        isolated = [group.report(run_kernels(group.jobs(time))) for group in groups]
+
+        jobs = [group.jobs(time) for group in groups]
+        results = run_kernels([job for group_jobs in jobs for job in group_jobs])
+
+        offset = 0
+        for group, group_isolated, group_jobs in zip(groups, isolated, jobs):
+            mixed = group.report(results[offset : offset + len(group_jobs)])
+            report.update(group, group_isolated, mixed)
+            offset += len(group_jobs)
+
+        return report
+
+    def table(self, ops):
+        future = self.executor.submit(PerfMonitor.table_worker, self.physical_cores[0], ops)
+        return future.result()
+
+    def warmup(self, ops, lead, time, slice_time, mem_size=0, vm_size=0, jit_size=0):
+        future = self.executor.submit(
+            PerfMonitor.warmup_worker,
+            self.physical_cores[0],
+            ops,
+            lead,
+            time,
+            slice_time,
+            (mem_size, vm_size, jit_size),
+        )
+        return future.result()
+
+    def shootdown(self, time, threshold):
+        # The other cores of the initiator's socket respond first, then the other sockets
+        if self.num_cores < 2:
+            raise RuntimeError(
+                f"TLB shootdown needs >= 2 CPUs, {self.num_cores} physical core available"
+            )
+
+        initiator = self.physical_cores[0]
+        others = sorted(
+            self.physical_cores[1:], key=lambda core: core.package_id != initiator.package_id
+        )
+
+        counts = list()
+        while others and (not counts or counts[-1] < len(others)):
+            counts.append(min(2 ** len(counts), len(others)))
+
+        report = ShootdownReport(threshold)
+        for count in counts:
+            responders = others[:count]
+            sockets = len({initiator.package_id} | {core.package_id for core in responders})
+            result = tlb_shootdown(
+                initiator.index, [core.index for core in responders], time, threshold
+            )
+            report.update(sockets, result)
+        return report
+
+    def pingpong(self, time):
+        # The same CPU, its SMT sibling, another core of the socket and another socket
+        cpus = list(logical_cores())
+        first = cpus[0]
+        others = [core for core in cpus if core.index != first.index]
+        socket = [core for core in others if core.package_id == first.package_id]
+
+        pairs = [("cpu", first)]
+        pairs += [("smt", core) for core in socket if core.core_id == first.core_id][:1]
+        pairs += [("core", core) for core in socket if core.core_id != first.core_id][:1]
+        pairs += [("socket", core) for core in others if core.package_id != first.package_id][:1]
+
+        report = PingPongReport()
+        for pair, second in pairs:
+            result, histogram = futex_pingpong(first.index, second.index, time)
+            report.update(pair, first.index, second.index, result, histogram)
+        return report
+
+    def clocks(self, skew_time, drift_time, interval):
+        report = ClockReport(clock_source(), time_source(), clock_counter_based())
+        for op in ExitOpsType:
+            if op.name.startswith("CLOCK_") and kernel_support(op.name.lower()):
+                report.update_read(op.name, kernel_inst_time(op.name.lower()))
+
+        # Every pair of CPUs once, the lower one initiates
+        cpus = [core.index for core in logical_cores()]
+        for i, first in enumerate(cpus):
+            for second in cpus[i + 1 :]:
+                report.update_skew(first, second, counter_skew(first, second, skew_time))
+
+        report.drift = counter_drift(drift_time, interval)
+        return report
+
+    def jitter(self, time, threshold):
         report_futures = list(
             [
-                self.executor.submit(PerfMonitor.worker, core_info, op, steps, time)
+                self.executor.submit(PerfMonitor.jitter_worker, core_info, time, threshold)
                 for core_info in self.physical_cores
             ]
         )
 
-        report = PerfReport(op.name, self.num_cores)
+        report = JitterReport(threshold)
         for future in report_futures:
-            core_report = future.result()
-            report.update(
-                core_report.elapsed_time,
-                core_report.total_ops,
-                core_report.total_freq,
-                core_report.steps,
-            )
+            report.update(*future.result())
 
         return report
 
     @staticmethod
-    def worker(core_info, op, steps, time):
-        set_thread_affinity(core_info.core_id)
+    def table_worker(core_info, ops):
+        set_thread_affinity(core_info.index)
         set_thread_priority()
 
-        report = PerfReport(op.name)
+        rows = list()
+        time_start, cycles_start = cpu_time()
+        for op in ops:
+            name = op.name.lower()
+            times = [kernel_inst_time(name + variant) for variant in CHAIN_VARIANTS]
+            rows.append((op.name, kernel_ops_per_inst(name), times))
+        time_end, cycles_end = cpu_time()
 
-        while report.elapsed_time < time:
-            time_start, cycles_start = cpu_time()
-            ops_time, ops_count = measure_ops(op, steps)
-            time_end, cycles_end = cpu_time()
+        report = TableReport((cycles_end - cycles_start) / (time_end - time_start))
+        for row in rows:
+            report.update(*row)
+        return report
 
-            time_elapsed = time_end - time_start
-            time_elapsed = time_elapsed / 1e9
-            cycles_elapsed = cycles_end - cycles_start
-            freq = cycles_elapsed / time_elapsed
-            ops_time = ops_time / 1e9
+    @staticmethod
+    def warmup_worker(core_info, ops, lead, time, slice_time, sizes):
+        set_thread_affinity(core_info.index)
+        set_thread_priority()
 
-            report.update(ops_time, ops_count, freq, 1)
+        mem_size, vm_size, jit_size = sizes
+        report = WarmupReport(lead)
+        for op in ops:
+            # The working sets of a measurement run
+            size = 0
+            if isinstance(op, (MemOpsType, ConvertOpsType)):
+                size = mem_size
+            elif isinstance(op, PagingOpsType):
+                size = vm_size
+            elif isinstance(op, JitOpsType):
+                size = jit_size
 
+            name = op.name.lower()
+            result, _ = warmup_trace(name, WARMUP_LEADS[lead], time, slice_time, size=size)
+            # Nothing ran, e.g. an unsupported kernel
+            if result.slices == 0:
+                continue
+            report.update(op.name, kernel_unit(name), result)
         return report
+
+    @staticmethod
+    def jitter_worker(core_info, time, threshold):
+        set_thread_affinity(core_info.index)
+        set_thread_priority()
+
+        return jitter_scan(time, threshold)